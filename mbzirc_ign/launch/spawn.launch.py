@@ -91,6 +91,7 @@ def parse_from_cli(context, world_name):
         model.set_arm(arm)
 
     model.set_gripper(gripper)
+    model.set_rf_range_compact(LaunchConfiguration('rf_range_compact').perform(context))
     model.set_payload(payloads)
     model.set_arm_payload(arm_payloads)
     return model
@@ -180,6 +181,11 @@ def generate_launch_description():
             'arm_slot',
             default_value='0',
             description='arm slot to attach to usv'),
+        DeclareLaunchArgument(
+            'rf_range_compact',
+            default_value='False',
+            description='True to bridge the compact RF range output, '
+                        'if enabled in the world.'),
         DeclareLaunchArgument(
             'slot0',
             default_value='',
@@ -22,6 +22,8 @@
 #include <ignition/gazebo/components/Factory.hh>
 #include <ignition/gazebo/components/Serialization.hh>
 
+#include "MarineParameters.hh"
+
 namespace mbzirc
 {
 namespace components
@@ -32,6 +34,41 @@ namespace components
   using Usv = ignition::gazebo::components::Component<NoData, class UsvTag>;
   IGN_GAZEBO_REGISTER_COMPONENT("mbzirc_components.Usv", Usv)
 
+  /// \brief Buoyancy parameters of a vessel link, set by the Surface system.
+  using SurfaceParameters = ignition::gazebo::components::Component<
+      mbzirc::SurfaceParameters, class SurfaceParametersTag>;
+  IGN_GAZEBO_REGISTER_COMPONENT("mbzirc_components.SurfaceParameters",
+      SurfaceParameters)
+
+  /// \brief Hydrodynamic parameters of a vessel link, set by the
+  /// SimpleHydrodynamics system.
+  using HydrodynamicsParameters = ignition::gazebo::components::Component<
+      mbzirc::HydrodynamicsParameters, class HydrodynamicsParametersTag>;
+  IGN_GAZEBO_REGISTER_COMPONENT("mbzirc_components.HydrodynamicsParameters",
+      HydrodynamicsParameters)
+
+  /// \brief A component that marks a world whose vessels are simulated by
+  /// the MarineDynamics system. The per vessel Surface and
+  /// SimpleHydrodynamics systems are passive in such a world.
+  using MarineDynamics = ignition::gazebo::components::Component<
+      NoData, class MarineDynamicsTag>;
+  IGN_GAZEBO_REGISTER_COMPONENT("mbzirc_components.MarineDynamics",
+      MarineDynamics)
+
+  /// \brief Distance to the nearest competitor platform beyond which a
+  /// vessel link is parked [m], set by the Surface system.
+  using ParkDistance = ignition::gazebo::components::Component<
+      double, class ParkDistanceTag>;
+  IGN_GAZEBO_REGISTER_COMPONENT("mbzirc_components.ParkDistance",
+      ParkDistance)
+
+  /// \brief A component that marks a vessel link as parked, set by the
+  /// GameLogicPlugin while no competitor platform is near. A parked vessel
+  /// rides the waves kinematically instead of being simulated.
+  using Parked = ignition::gazebo::components::Component<
+      NoData, class ParkedTag>;
+  IGN_GAZEBO_REGISTER_COMPONENT("mbzirc_components.Parked", Parked)
+
 }  // namespace components
 }  // namespace mbzirc
 
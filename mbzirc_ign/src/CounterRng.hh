@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef MBZIRC_IGN__COUNTERRNG_HH_
+#define MBZIRC_IGN__COUNTERRNG_HH_
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+namespace mbzirc
+{
+/// \brief Counter-based random number stream. The stream is a pure function
+/// of a seed and up to three keys, such as a transmitter, a receiver and a
+/// tick, so streams can be drawn in any order and on any thread with the
+/// same results. Uses the SplitMix64 generator, and does not depend on the
+/// standard library distributions, whose output differs between
+/// implementations.
+class CounterRng
+{
+  /// \brief Constructor.
+  /// \param[in] _seed Seed.
+  /// \param[in] _a First key.
+  /// \param[in] _b Second key.
+  /// \param[in] _c Third key.
+  public: CounterRng(uint64_t _seed, uint64_t _a = 0, uint64_t _b = 0,
+                     uint64_t _c = 0)
+  {
+    this->state = Mix(Mix(Mix(Mix(_seed) ^ _a) ^ _b) ^ _c);
+  }
+
+  /// \brief Next 64 random bits.
+  /// \return The bits.
+  public: uint64_t Next()
+  {
+    this->state += kGamma;
+    return Mix(this->state);
+  }
+
+  /// \brief Uniform draw in [0, 1).
+  /// \return The draw.
+  public: double Uniform()
+  {
+    return static_cast<double>(this->Next() >> 11) * 0x1.0p-53;
+  }
+
+  /// \brief Normal draw, using the Box-Muller transform.
+  /// \param[in] _mean Mean.
+  /// \param[in] _stddev Standard deviation.
+  /// \return The draw.
+  public: double Normal(double _mean, double _stddev)
+  {
+    // 1 - u is in (0, 1], so the log is finite.
+    const double u1 = 1.0 - this->Uniform();
+    const double u2 = this->Uniform();
+    return _mean + _stddev * std::sqrt(-2.0 * std::log(u1)) *
+        std::cos(2.0 * M_PI * u2);
+  }
+
+  /// \brief Stable 64 bit key of a string, the FNV-1a hash.
+  /// \param[in] _s The string.
+  /// \return The key.
+  public: static uint64_t Key(const std::string &_s)
+  {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : _s)
+    {
+      hash ^= c;
+      hash *= 0x100000001b3ull;
+    }
+    return hash;
+  }
+
+  /// \brief SplitMix64 finalizer.
+  /// \param[in] _x Input.
+  /// \return Mixed bits.
+  private: static uint64_t Mix(uint64_t _x)
+  {
+    _x += kGamma;
+    _x = (_x ^ (_x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    _x = (_x ^ (_x >> 27)) * 0x94d049bb133111ebull;
+    return _x ^ (_x >> 31);
+  }
+
+  /// \brief SplitMix64 increment, the golden ratio.
+  private: static constexpr uint64_t kGamma = 0x9e3779b97f4a7c15ull;
+
+  /// \brief Counter.
+  private: uint64_t state;
+};
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__COUNTERRNG_HH_
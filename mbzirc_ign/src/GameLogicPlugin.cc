@@ -18,15 +18,21 @@
 #include <ignition/math/Helpers.hh>
 #include <ignition/msgs/boolean.pb.h>
 #include <ignition/msgs/float.pb.h>
+#include <ignition/msgs/float_v.pb.h>
 #include <ignition/msgs/stringmsg_v.pb.h>
 #include <ignition/plugin/Register.hh>
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <ignition/math/AxisAlignedBox.hh>
+#include <ignition/math/Vector2.hh>
 
 #include <ignition/rendering/Camera.hh>
 #include <ignition/rendering/Image.hh>
@@ -220,6 +226,11 @@ class mbzirc::GameLogicPluginPrivate
   public: bool OnWavefieldRequest(const ignition::msgs::Empty &_req,
                                   ignition::msgs::Float_V &_res);
 
+  /// \brief Callback triggered when a new sea state is published, so that
+  /// wavefields loaded afterwards get it from the wavefield service.
+  /// \param[in] _msg [gain, period] or [gain, period, dir x, dir y].
+  public: void OnWavefieldUpdate(const ignition::msgs::Float_V &_msg);
+
   /// \brief Pause trajectory following for the specified vessel
   /// \param[in] _vessel Name of vessel
   public: void PauseVesselTrajectory(const std::string &_vessel);
@@ -263,6 +274,15 @@ class mbzirc::GameLogicPluginPrivate
   public: void CheckRobotsInGeofenceBoundary(
       EntityComponentManager &_ecm);
 
+  /// \brief Park the vessel links with a ParkDistance component that are
+  /// farther than that distance from every competitor platform, and unpark
+  /// them when a platform comes within it. Runs once per second of sim time.
+  /// \param[in] _simTime Current sim time.
+  /// \param[in] _ecm Mutable reference to Entity Component Manager
+  public: void UpdateParkedVessels(
+      const std::chrono::steady_clock::duration &_simTime,
+      EntityComponentManager &_ecm);
+
   /// \brief Make an entity static
   /// \param[in] _entity Entity to make static
   /// \param[in] _ecm Mutable reference to Entity Component Manager
@@ -368,6 +388,9 @@ class mbzirc::GameLogicPluginPrivate
   /// \brief Mutex to protect phase.
   public: std::mutex phaseMutex;
 
+  /// \brief Mutex to protect wave params.
+  public: std::mutex waveMutex;
+
   /// \brief Target reports
   public: std::vector<ignition::msgs::StringMsg_V> reports;
 
@@ -410,6 +433,9 @@ class mbzirc::GameLogicPluginPrivate
   /// \brief Time at which the last status publication took place.
   public: std::chrono::steady_clock::time_point lastStatusPubTime;
 
+  /// \brief Sim time of the last parking update.
+  public: std::optional<std::chrono::steady_clock::duration> lastParkTime;
+
   /// \brief Time at which the summary.yaml file was last updated.
   public: mutable std::chrono::steady_clock::time_point lastUpdateScoresTime;
 
@@ -552,6 +578,12 @@ class mbzirc::GameLogicPluginPrivate
   /// \brief Wave period param
   public: double wavePeriod{-1.0};
 
+  /// \brief Wave direction param, only set by sea state updates.
+  public: std::optional<math::Vector2d> waveDirection;
+
+  /// \brief Whether the wavefield service is advertised.
+  public: bool wavefieldServiceAdvertised{false};
+
   /// \brief A list of rgbd cameras in the world
   public: std::set<gazebo::Entity> rgbdCameraSensors;
 
@@ -826,10 +858,14 @@ void GameLogicPlugin::Configure(const ignition::gazebo::Entity & /*_entity*/,
 
   if (this->dataPtr->waveGain >= 0 && this->dataPtr->wavePeriod >= 0)
   {
-    this->dataPtr->node.Advertise("/mbzirc/wavefield",
+    this->dataPtr->wavefieldServiceAdvertised = this->dataPtr->node.Advertise(
+        "/mbzirc/wavefield",
         &GameLogicPluginPrivate::OnWavefieldRequest, this->dataPtr.get());
   }
 
+  this->dataPtr->node.Subscribe("/mbzirc/wavefield/update",
+      &GameLogicPluginPrivate::OnWavefieldUpdate, this->dataPtr.get());
+
   ignmsg << "Starting MBZIRC" << std::endl;
 
   // Make sure that there are score files.
@@ -868,6 +904,10 @@ void GameLogicPluginPrivate::OnBatteryMsg(
 void GameLogicPlugin::PreUpdate(const UpdateInfo &_info,
     EntityComponentManager &_ecm)
 {
+  // park vessels far from the robots, also during the setup phase
+  if (!_info.paused)
+    this->dataPtr->UpdateParkedVessels(_info.simTime, _ecm);
+
   if (!this->dataPtr->started)
     return;
 
@@ -1120,6 +1160,50 @@ void GameLogicPluginPrivate::CheckRobotsInGeofenceBoundary(
   }
 }
 
+//////////////////////////////////////////////////
+void GameLogicPluginPrivate::UpdateParkedVessels(
+    const std::chrono::steady_clock::duration &_simTime,
+    EntityComponentManager &_ecm)
+{
+  if (this->lastParkTime &&
+      _simTime - *this->lastParkTime < std::chrono::seconds(1))
+  {
+    return;
+  }
+  this->lastParkTime = _simTime;
+
+  std::vector<math::Vector3d> robotPositions;
+  for (const auto &[robotEnt, robot] : this->robots)
+    robotPositions.push_back(worldPose(robotEnt, _ecm).Pos());
+
+  std::vector<Entity> park;
+  std::vector<Entity> unpark;
+  _ecm.Each<mbzirc::components::ParkDistance>(
+      [&](const Entity &_entity,
+          const mbzirc::components::ParkDistance *_parkDistance) -> bool
+      {
+        const math::Vector3d position = worldPose(_entity, _ecm).Pos();
+        double distance = std::numeric_limits<double>::infinity();
+        for (const auto &robotPos : robotPositions)
+          distance = std::min(distance, robotPos.Distance(position));
+
+        // Unpark within the distance, park again only 10% beyond it so
+        // that a platform at the boundary does not toggle the vessel.
+        const bool parked =
+            _ecm.Component<mbzirc::components::Parked>(_entity);
+        if (parked && distance < _parkDistance->Data())
+          unpark.push_back(_entity);
+        else if (!parked && distance > 1.1 * _parkDistance->Data())
+          park.push_back(_entity);
+        return true;
+      });
+
+  for (const auto &entity : park)
+    _ecm.CreateComponent(entity, mbzirc::components::Parked());
+  for (const auto &entity : unpark)
+    _ecm.RemoveComponent<mbzirc::components::Parked>(entity);
+}
+
 //////////////////////////////////////////////////
 bool GameLogicPluginPrivate::MakeStatic(Entity _entity,
     EntityComponentManager &_ecm)
@@ -1541,11 +1625,40 @@ bool GameLogicPluginPrivate::OnSkipToPhase(
 bool GameLogicPluginPrivate::OnWavefieldRequest(const ignition::msgs::Empty &_req,
   ignition::msgs::Float_V &_res)
 {
+  std::lock_guard<std::mutex> lock(this->waveMutex);
   _res.add_data(this->waveGain);
   _res.add_data(this->wavePeriod);
+  if (this->waveDirection)
+  {
+    _res.add_data(this->waveDirection->X());
+    _res.add_data(this->waveDirection->Y());
+  }
   return true;
 }
 
+/////////////////////////////////////////////////
+void GameLogicPluginPrivate::OnWavefieldUpdate(
+  const ignition::msgs::Float_V &_msg)
+{
+  if (_msg.data_size() < 2 || _msg.data(0) < 0.0 || _msg.data(1) <= 0.0)
+    return;
+
+  std::lock_guard<std::mutex> lock(this->waveMutex);
+  this->waveGain = _msg.data(0);
+  this->wavePeriod = _msg.data(1);
+  if (_msg.data_size() >= 4)
+    this->waveDirection = math::Vector2d(_msg.data(2), _msg.data(3));
+
+  if (!this->wavefieldServiceAdvertised)
+  {
+    this->wavefieldServiceAdvertised = this->node.Advertise(
+        "/mbzirc/wavefield",
+        &GameLogicPluginPrivate::OnWavefieldRequest, this);
+  }
+  ignmsg << "Sea state updated: gain [" << this->waveGain << "] period ["
+         << this->wavePeriod << "]" << std::endl;
+}
+
 /////////////////////////////////////////////////
 void GameLogicPluginPrivate::PauseVesselTrajectory(const std::string &_vessel)
 {
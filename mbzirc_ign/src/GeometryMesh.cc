@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include <ignition/common/Mesh.hh>
+#include <ignition/common/MeshManager.hh>
+#include <ignition/common/SubMesh.hh>
+#include <ignition/common/Util.hh>
+#include <sdf/Box.hh>
+#include <sdf/Cylinder.hh>
+#include <sdf/Mesh.hh>
+#include <sdf/Sphere.hh>
+
+#include "ignition/gazebo/Util.hh"
+
+#include "GeometryMesh.hh"
+
+using namespace ignition;
+
+//////////////////////////////////////////////////
+bool mbzirc::AppendGeometryTriangles(const sdf::Geometry &_geometry,
+    const math::Pose3d &_pose, std::vector<math::Vector3d> &_vertices,
+    std::vector<uint32_t> &_indices)
+{
+  // Unit primitives of the mesh manager, scaled to the geometry.
+  const common::Mesh *mesh{nullptr};
+  math::Vector3d scale(1, 1, 1);
+  auto meshManager = common::MeshManager::Instance();
+  if (_geometry.Type() == sdf::GeometryType::BOX && _geometry.BoxShape())
+  {
+    mesh = meshManager->MeshByName("unit_box");
+    scale = _geometry.BoxShape()->Size();
+  }
+  else if (_geometry.Type() == sdf::GeometryType::CYLINDER &&
+           _geometry.CylinderShape())
+  {
+    mesh = meshManager->MeshByName("unit_cylinder");
+    const double diameter = 2.0 * _geometry.CylinderShape()->Radius();
+    scale.Set(diameter, diameter, _geometry.CylinderShape()->Length());
+  }
+  else if (_geometry.Type() == sdf::GeometryType::SPHERE &&
+           _geometry.SphereShape())
+  {
+    mesh = meshManager->MeshByName("unit_sphere");
+    scale *= 2.0 * _geometry.SphereShape()->Radius();
+  }
+  else if (_geometry.Type() == sdf::GeometryType::MESH &&
+           _geometry.MeshShape())
+  {
+    const std::string file = common::findFile(gazebo::asFullPath(
+        _geometry.MeshShape()->Uri(), _geometry.MeshShape()->FilePath()));
+    mesh = meshManager->Load(file);
+    scale = _geometry.MeshShape()->Scale();
+  }
+  if (!mesh)
+    return false;
+
+  // Flatten the submeshes into the frame of the mesh.
+  for (unsigned int m = 0; m < mesh->SubMeshCount(); ++m)
+  {
+    auto subMesh = mesh->SubMeshByIndex(m).lock();
+    if (!subMesh)
+      continue;
+    const uint32_t first = static_cast<uint32_t>(_vertices.size());
+    for (unsigned int v = 0; v < subMesh->VertexCount(); ++v)
+      _vertices.push_back(_pose.CoordPositionAdd(subMesh->Vertex(v) * scale));
+    for (unsigned int i = 0; i < subMesh->IndexCount(); ++i)
+      _indices.push_back(first + subMesh->Index(i));
+  }
+  return true;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef MBZIRC_IGN__GEOMETRYMESH_HH_
+#define MBZIRC_IGN__GEOMETRYMESH_HH_
+
+#include <cstdint>
+#include <vector>
+
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+#include <sdf/Geometry.hh>
+
+namespace mbzirc
+{
+/// \brief Append the triangles of a geometry at a pose to a triangle mesh.
+/// Boxes, cylinders and spheres are the unit primitives of the mesh manager
+/// scaled to the geometry, and meshes are loaded from their URI.
+/// \param[in] _geometry The geometry.
+/// \param[in] _pose Pose of the geometry in the frame of the mesh.
+/// \param[in,out] _vertices Vertices of the mesh.
+/// \param[in,out] _indices Vertex indices of the mesh, three per triangle.
+/// \return False if the geometry has no triangles, e.g. a plane, or its
+/// mesh could not be loaded.
+bool AppendGeometryTriangles(const sdf::Geometry &_geometry,
+    const ignition::math::Pose3d &_pose,
+    std::vector<ignition::math::Vector3d> &_vertices,
+    std::vector<uint32_t> &_indices);
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__GEOMETRYMESH_HH_
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "HullMesh.hh"
+
+using namespace ignition;
+using namespace mbzirc;
+
+/// \brief Merge the vertices that share a cell of a uniform grid.
+/// \param[in] _vertices Input vertices.
+/// \param[in] _indices Input triangles.
+/// \param[in] _cells Number of cells along the longest side of the bounding
+/// box.
+/// \param[out] _outVertices One vertex per occupied cell.
+/// \param[out] _outIndices Triangles that are not degenerate after merging.
+static void ClusterVertices(const std::vector<math::Vector3d> &_vertices,
+    const std::vector<uint32_t> &_indices, int _cells,
+    std::vector<math::Vector3d> &_outVertices,
+    std::vector<uint32_t> &_outIndices)
+{
+  math::Vector3d low(std::numeric_limits<double>::max(),
+      std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+  math::Vector3d high = -low;
+  for (const auto &v : _vertices)
+  {
+    low.Set(std::min(low.X(), v.X()), std::min(low.Y(), v.Y()),
+        std::min(low.Z(), v.Z()));
+    high.Set(std::max(high.X(), v.X()), std::max(high.Y(), v.Y()),
+        std::max(high.Z(), v.Z()));
+  }
+  const math::Vector3d extent = high - low;
+  const double size = std::max({extent.X(), extent.Y(), extent.Z(), 1e-9}) /
+      _cells;
+  const uint64_t nx = static_cast<uint64_t>(extent.X() / size) + 1;
+  const uint64_t ny = static_cast<uint64_t>(extent.Y() / size) + 1;
+
+  // Cell of each vertex. Each cell keeps the member farthest from the
+  // center of the bounding box, so that the decimated hull does not shrink
+  // and lose displacement the way averaging the members would.
+  const math::Vector3d middle = (low + high) * 0.5;
+  std::unordered_map<uint64_t, uint32_t> cells;
+  std::vector<uint32_t> remap(_vertices.size());
+  std::vector<double> reach;
+  _outVertices.clear();
+  for (size_t i = 0; i < _vertices.size(); ++i)
+  {
+    const math::Vector3d p = (_vertices[i] - low) / size;
+    const uint64_t key = static_cast<uint64_t>(p.X()) +
+        nx * (static_cast<uint64_t>(p.Y()) +
+        ny * static_cast<uint64_t>(p.Z()));
+    const uint32_t next = static_cast<uint32_t>(_outVertices.size());
+    auto it = cells.emplace(key, next).first;
+    if (it->second == next)
+    {
+      _outVertices.push_back(_vertices[i]);
+      reach.push_back(-1.0);
+    }
+    remap[i] = it->second;
+    const double r = (_vertices[i] - middle).SquaredLength();
+    if (r > reach[it->second])
+    {
+      reach[it->second] = r;
+      _outVertices[it->second] = _vertices[i];
+    }
+  }
+
+  // Drop collapsed and repeated triangles.
+  std::set<std::array<uint32_t, 3>> seen;
+  _outIndices.clear();
+  for (size_t t = 0; t + 2 < _indices.size(); t += 3)
+  {
+    std::array<uint32_t, 3> tri = {remap[_indices[t]],
+        remap[_indices[t + 1]], remap[_indices[t + 2]]};
+    if (tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0])
+      continue;
+    // Rotate the smallest index first, keeping the winding.
+    std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()),
+        tri.end());
+    if (!seen.insert(tri).second)
+      continue;
+    _outIndices.insert(_outIndices.end(), tri.begin(), tri.end());
+  }
+}
+
+/// \brief Add the pressure load of a fully submerged triangle.
+/// \param[in] _a First vertex.
+/// \param[in] _b Second vertex.
+/// \param[in] _c Third vertex.
+/// \param[in] _da Depth of the first vertex [m].
+/// \param[in] _db Depth of the second vertex [m].
+/// \param[in] _dc Depth of the third vertex [m].
+/// \param[in] _center Point the torque is computed about.
+/// \param[in,out] _force Sum of the forces divided by -rho * g.
+/// \param[in,out] _torque Sum of the torques divided by -rho * g.
+static void AddTriangle(const math::Vector3d &_a, const math::Vector3d &_b,
+    const math::Vector3d &_c, double _da, double _db, double _dc,
+    const math::Vector3d &_center, math::Vector3d &_force,
+    math::Vector3d &_torque)
+{
+  // Area vector, pointing out of the hull.
+  const math::Vector3d area = (_b - _a).Cross(_c - _a) * 0.5;
+  const double sum = _da + _db + _dc;
+
+  // The depth is linear over the triangle, so the pressure integrates to
+  // the mean depth and its moment to
+  // A / 12 * (sum_i x_i d_i + sum_i x_i * sum_j d_j).
+  const math::Vector3d arm = (_a * _da + _b * _db + _c * _dc +
+      (_a + _b + _c) * sum) / 12.0 - _center * (sum / 3.0);
+  _force += area * (sum / 3.0);
+  _torque += arm.Cross(area);
+}
+
+//////////////////////////////////////////////////
+void HullMesh::SetMesh(const std::vector<math::Vector3d> &_vertices,
+    const std::vector<uint32_t> &_indices)
+{
+  this->vertices = _vertices;
+  this->indices = _indices;
+  this->indices.resize(_indices.size() - _indices.size() % 3);
+  this->worldVertices.resize(_vertices.size());
+
+  // Mesh files do not agree on the winding, turn the normals outwards.
+  if (this->Volume() < 0.0)
+  {
+    for (size_t t = 0; t < this->indices.size(); t += 3)
+      std::swap(this->indices[t + 1], this->indices[t + 2]);
+  }
+}
+
+//////////////////////////////////////////////////
+void HullMesh::Decimate(size_t _maxTriangles)
+{
+  if (this->TriangleCount() <= _maxTriangles)
+    return;
+
+  // Largest cell count that meets the budget.
+  std::vector<math::Vector3d> bestVertices;
+  std::vector<uint32_t> bestIndices;
+  std::vector<math::Vector3d> outVertices;
+  std::vector<uint32_t> outIndices;
+  int low = 1;
+  int high = 4096;
+  while (low <= high)
+  {
+    const int cells = (low + high) / 2;
+    ClusterVertices(this->vertices, this->indices, cells, outVertices,
+        outIndices);
+    if (outIndices.size() / 3 <= _maxTriangles)
+    {
+      std::swap(bestVertices, outVertices);
+      std::swap(bestIndices, outIndices);
+      low = cells + 1;
+    }
+    else
+    {
+      high = cells - 1;
+    }
+  }
+  this->SetMesh(bestVertices, bestIndices);
+}
+
+//////////////////////////////////////////////////
+size_t HullMesh::VertexCount() const
+{
+  return this->vertices.size();
+}
+
+//////////////////////////////////////////////////
+size_t HullMesh::TriangleCount() const
+{
+  return this->indices.size() / 3;
+}
+
+//////////////////////////////////////////////////
+double HullMesh::Volume() const
+{
+  double volume = 0.0;
+  for (size_t t = 0; t < this->indices.size(); t += 3)
+  {
+    const auto &a = this->vertices[this->indices[t]];
+    const auto &b = this->vertices[this->indices[t + 1]];
+    const auto &c = this->vertices[this->indices[t + 2]];
+    volume += a.Dot(b.Cross(c)) / 6.0;
+  }
+  return volume;
+}
+
+//////////////////////////////////////////////////
+math::AxisAlignedBox HullMesh::BoundingBox() const
+{
+  if (this->vertices.empty())
+    return math::AxisAlignedBox();
+
+  math::Vector3d min = this->vertices[0];
+  math::Vector3d max = min;
+  for (const auto &v : this->vertices)
+  {
+    min.Min(v);
+    max.Max(v);
+  }
+  return math::AxisAlignedBox(min, max);
+}
+
+//////////////////////////////////////////////////
+const std::vector<math::Vector3d> &HullMesh::Transform(
+    const math::Pose3d &_pose)
+{
+  for (size_t i = 0; i < this->vertices.size(); ++i)
+    this->worldVertices[i] = _pose.Pos() + _pose.Rot() * this->vertices[i];
+  return this->worldVertices;
+}
+
+//////////////////////////////////////////////////
+void HullMesh::Integrate(const std::vector<double> &_surface,
+    double _density, double _gravity, const math::Vector3d &_center,
+    math::Vector3d &_force, math::Vector3d &_torque) const
+{
+  math::Vector3d force(0, 0, 0);
+  math::Vector3d torque(0, 0, 0);
+  const auto &w = this->worldVertices;
+  for (size_t t = 0; t < this->indices.size(); t += 3)
+  {
+    const uint32_t v[3] = {this->indices[t], this->indices[t + 1],
+        this->indices[t + 2]};
+    const double d[3] = {_surface[v[0]] - w[v[0]].Z(),
+        _surface[v[1]] - w[v[1]].Z(), _surface[v[2]] - w[v[2]].Z()};
+    const int wet = (d[0] > 0) + (d[1] > 0) + (d[2] > 0);
+    if (wet == 0)
+      continue;
+
+    if (wet == 3)
+    {
+      AddTriangle(w[v[0]], w[v[1]], w[v[2]], d[0], d[1], d[2], _center,
+          force, torque);
+      continue;
+    }
+
+    // Clip at the waterline, keeping the winding. With one wet vertex i the
+    // wet part is a triangle, with two wet vertices i, j it is a quad.
+    if (wet == 1)
+    {
+      const int i = d[0] > 0 ? 0 : (d[1] > 0 ? 1 : 2);
+      const int j = (i + 1) % 3;
+      const int k = (i + 2) % 3;
+      const auto &pi = w[v[i]];
+      const math::Vector3d pij = pi + (w[v[j]] - pi) * (d[i] / (d[i] - d[j]));
+      const math::Vector3d pik = pi + (w[v[k]] - pi) * (d[i] / (d[i] - d[k]));
+      AddTriangle(pi, pij, pik, d[i], 0, 0, _center, force, torque);
+    }
+    else
+    {
+      const int k = d[0] <= 0 ? 0 : (d[1] <= 0 ? 1 : 2);
+      const int i = (k + 1) % 3;
+      const int j = (k + 2) % 3;
+      const auto &pi = w[v[i]];
+      const auto &pj = w[v[j]];
+      const auto &pk = w[v[k]];
+      const math::Vector3d pjk = pj + (pk - pj) * (d[j] / (d[j] - d[k]));
+      const math::Vector3d pki = pk + (pi - pk) * (d[k] / (d[k] - d[i]));
+      AddTriangle(pi, pj, pjk, d[i], d[j], 0, _center, force, torque);
+      AddTriangle(pi, pjk, pki, d[i], 0, 0, _center, force, torque);
+    }
+  }
+
+  // p = rho * g * depth, acting against the outward normal.
+  _force = force * (-_density * _gravity);
+  _torque = torque * (-_density * _gravity);
+}
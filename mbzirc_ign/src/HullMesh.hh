@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef MBZIRC_IGN__HULLMESH_HH_
+#define MBZIRC_IGN__HULLMESH_HH_
+
+#include <cstdint>
+#include <vector>
+
+#include <ignition/math/AxisAlignedBox.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+
+namespace mbzirc
+{
+/// \brief A closed triangle mesh of a vessel hull, used to integrate the
+/// hydrostatic pressure over the part of the hull below the wave surface.
+///
+/// The mesh is stored as flat arrays of link frame vertices and vertex
+/// indices, three per triangle, so a step only streams through them:
+/// Transform the vertices to the world frame, query the wave surface
+/// height above each of them, then Integrate the pressure. Triangles
+/// crossing the surface are clipped at the waterline, assuming the depth
+/// varies linearly over each triangle.
+class HullMesh
+{
+  /// \brief Set the mesh.
+  /// \param[in] _vertices Vertices in the link frame.
+  /// \param[in] _indices Vertex indices, three per triangle. The winding
+  /// is reversed if it gives a negative volume.
+  public: void SetMesh(const std::vector<ignition::math::Vector3d> &_vertices,
+              const std::vector<uint32_t> &_indices);
+
+  /// \brief Reduce the mesh to at most a number of triangles by merging
+  /// the vertices that share a cell of a uniform grid. Uses the finest
+  /// grid that meets the budget.
+  /// \param[in] _maxTriangles Triangle budget.
+  public: void Decimate(size_t _maxTriangles);
+
+  /// \brief Number of vertices.
+  public: size_t VertexCount() const;
+
+  /// \brief Number of triangles.
+  public: size_t TriangleCount() const;
+
+  /// \brief Enclosed volume [m^3].
+  public: double Volume() const;
+
+  /// \brief Bounding box of the vertices in the link frame.
+  /// \return The box, empty if there is no mesh.
+  public: ignition::math::AxisAlignedBox BoundingBox() const;
+
+  /// \brief Transform the vertices to the world frame.
+  /// \param[in] _pose World pose of the link.
+  /// \return The world vertices, valid until the next call.
+  public: const std::vector<ignition::math::Vector3d> &Transform(
+              const ignition::math::Pose3d &_pose);
+
+  /// \brief Integrate the hydrostatic pressure over the submerged part of
+  /// the hull, using the world vertices of the last Transform.
+  /// \param[in] _surface Height of the fluid surface above each vertex
+  /// [m], in the world frame.
+  /// \param[in] _density Fluid density [kg/m^3].
+  /// \param[in] _gravity Magnitude of the gravity [m/s^2].
+  /// \param[in] _center Point the torque is computed about, in the world
+  /// frame.
+  /// \param[out] _force Force in the world frame [N].
+  /// \param[out] _torque Torque about _center in the world frame [Nm].
+  public: void Integrate(const std::vector<double> &_surface,
+              double _density, double _gravity,
+              const ignition::math::Vector3d &_center,
+              ignition::math::Vector3d &_force,
+              ignition::math::Vector3d &_torque) const;
+
+  /// \brief Vertices in the link frame.
+  private: std::vector<ignition::math::Vector3d> vertices;
+
+  /// \brief Vertex indices, three per triangle.
+  private: std::vector<uint32_t> indices;
+
+  /// \brief Vertices in the world frame.
+  private: std::vector<ignition::math::Vector3d> worldVertices;
+};
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__HULLMESH_HH_
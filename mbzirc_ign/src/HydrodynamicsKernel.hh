@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef MBZIRC_IGN__HYDRODYNAMICSKERNEL_HH_
+#define MBZIRC_IGN__HYDRODYNAMICSKERNEL_HH_
+
+#include <array>
+#include <cmath>
+#include <optional>
+
+#include <Eigen/Core>
+
+#include "MarineParameters.hh"
+
+namespace mbzirc
+{
+/// \brief Body frame added mass, Coriolis and drag loads of a vessel,
+/// following Fossen's equations (p 37), see the SimpleHydrodynamics
+/// system.
+///
+/// The added mass and drag matrices are diagonal, so they are stored as
+/// their diagonals, and the added mass Coriolis matrix as its four non-zero
+/// entries. Every quantity is fixed size: evaluating the kernel does not
+/// allocate.
+/// \tparam T Scalar type.
+template <typename T>
+class HydrodynamicsKernel
+{
+  /// \brief Generalized vector: surge, sway, heave, roll, pitch, yaw.
+  public: using Vector6 = Eigen::Matrix<T, 6, 1>;
+
+  /// \brief Constructor.
+  /// \param[in] _params Hydrodynamic parameters.
+  public: explicit HydrodynamicsKernel(
+              const HydrodynamicsParameters &_params = {})
+  {
+    this->SetParameters(_params);
+  }
+
+  /// \brief Set the hydrodynamic parameters.
+  /// \param[in] _params Hydrodynamic parameters.
+  public: void SetParameters(const HydrodynamicsParameters &_params)
+  {
+    this->addedMass << _params.xDotU, _params.yDotV, _params.zDotW,
+        _params.kDotP, _params.mDotQ, _params.nDotR;
+    this->linearDrag << _params.xU, _params.yV, _params.zW,
+        _params.kP, _params.mQ, _params.nR;
+    this->quadraticDrag << _params.xUU, _params.yVV, _params.zWW,
+        _params.kPP, _params.mQQ, _params.nRR;
+
+    // C(0, 5) = Y_v' v, C(1, 5) = X_u' u, C(5, 0) = Y_v' v, C(5, 1) = X_u' u
+    const T yDotV = static_cast<T>(_params.yDotV);
+    const T xDotU = static_cast<T>(_params.xDotU);
+    this->coriolis = {{
+        {0, 5, 1, yDotV},
+        {1, 5, 0, xDotU},
+        {5, 0, 1, yDotV},
+        {5, 1, 0, xDotU}}};
+  }
+
+  /// \brief Added mass and drag loads, -M_A nu_dot - D(nu) nu.
+  /// \param[in] _state Body frame velocity nu.
+  /// \param[in] _stateDot Body frame acceleration nu_dot.
+  /// \return Body frame force and torque.
+  public: Vector6 Force(const Vector6 &_state, const Vector6 &_stateDot) const
+  {
+    const Vector6 kAmassVec = -this->addedMass.cwiseProduct(_stateDot);
+    const Vector6 kDvec = -(this->linearDrag +
+        this->quadraticDrag.cwiseProduct(_state.cwiseAbs()))
+        .cwiseProduct(_state);
+    return kAmassVec + kDvec;
+  }
+
+  /// \brief Added mass Coriolis loads, -C_A(nu) nu. The SimpleHydrodynamics
+  /// model does not apply them.
+  /// \param[in] _state Body frame velocity nu.
+  /// \return Body frame force and torque.
+  public: Vector6 CoriolisForce(const Vector6 &_state) const
+  {
+    Vector6 result = Vector6::Zero();
+    for (const auto &entry : this->coriolis)
+    {
+      result(entry.row) -=
+          entry.gain * _state(entry.factor) * _state(entry.col);
+    }
+    return result;
+  }
+
+  /// \brief A non-zero entry of the Coriolis matrix, gain * nu(factor).
+  private: struct CoriolisEntry
+  {
+    /// \brief Row.
+    int row;
+
+    /// \brief Column.
+    int col;
+
+    /// \brief Index of the velocity the entry is proportional to.
+    int factor;
+
+    /// \brief Gain.
+    T gain;
+  };
+
+  /// \brief Diagonal of the added mass matrix.
+  private: Vector6 addedMass;
+
+  /// \brief Diagonal of the linear drag matrix.
+  private: Vector6 linearDrag;
+
+  /// \brief Diagonal of the quadratic drag matrix.
+  private: Vector6 quadraticDrag;
+
+  /// \brief Non-zero entries of the added mass Coriolis matrix.
+  private: std::array<CoriolisEntry, 4> coriolis;
+};
+
+/// \brief First order low-pass filter of the body frame acceleration fed to
+/// the added mass term. The raw acceleration from the physics is noisy, and
+/// the feedback between the added mass force and the acceleration limits
+/// the stable step size.
+///
+/// The filter advances once per sim time: repeated updates at the same
+/// time return the cached output.
+/// \tparam T Scalar type.
+template <typename T>
+class AccelerationFilter
+{
+  /// \brief Generalized vector: surge, sway, heave, roll, pitch, yaw.
+  public: using Vector6 = Eigen::Matrix<T, 6, 1>;
+
+  /// \brief Set the cutoff frequency.
+  /// \param[in] _cutoff Cutoff frequency [Hz], 0 or less to pass the raw
+  /// acceleration through.
+  public: void SetCutoff(T _cutoff)
+  {
+    this->cutoff = _cutoff;
+    this->Reset();
+  }
+
+  /// \brief Restart from the next input.
+  public: void Reset()
+  {
+    this->lastTime.reset();
+  }
+
+  /// \brief Filter a new acceleration sample.
+  /// \param[in] _raw Raw body frame acceleration.
+  /// \param[in] _time Sim time of the sample [s].
+  /// \return Filtered body frame acceleration.
+  public: const Vector6 &Update(const Vector6 &_raw, double _time)
+  {
+    if (this->cutoff <= 0 || !this->lastTime || _time < *this->lastTime)
+    {
+      this->output = _raw;
+      this->lastTime = _time;
+      return this->output;
+    }
+
+    const double dt = _time - *this->lastTime;
+    if (dt <= 0.0)
+      return this->output;
+
+    // Exact discretization of the first order lag over the step.
+    const T alpha = static_cast<T>(
+        1.0 - std::exp(-2.0 * M_PI * this->cutoff * dt));
+    this->output += alpha * (_raw - this->output);
+    this->lastTime = _time;
+    return this->output;
+  }
+
+  /// \brief Cutoff frequency [Hz].
+  private: T cutoff = 0;
+
+  /// \brief Sim time of the last sample [s].
+  private: std::optional<double> lastTime;
+
+  /// \brief Last output.
+  private: Vector6 output = Vector6::Zero();
+};
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__HYDRODYNAMICSKERNEL_HH_
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef MBZIRC_IGN__LINKBUDGET_HH_
+#define MBZIRC_IGN__LINKBUDGET_HH_
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+namespace mbzirc
+{
+/// \brief Link budget of the RF range sensors, evaluated for a batch of
+/// links from one transmitter.
+///
+/// The model is the one of the RFRange system: log-normal path loss,
+/// QPSK bit error rate and independent bit errors over the payload. The
+/// packet error rate (PER) only depends on the signal to noise ratio, so
+/// it is tabulated every 0.025 dB of SNR between -20 dB and 30 dB and
+/// interpolated linearly, with an absolute error below 1e-4. Outside of
+/// the table the PER is the one of its closest end, which for payloads of
+/// 100 bytes is 1 and 0 to double precision. The range estimate is
+/// computed with one exp() instead of pow() calls, and matches the exact
+/// model to rounding.
+class LinkBudget
+{
+  /// \brief Model parameters.
+  public: struct Params
+  {
+    /// \brief Hard limit on range [m], 0 or less for no limit.
+    double maxRange = 50.0;
+
+    /// \brief Fading exponent.
+    double fadingExponent = 2.5;
+
+    /// \brief Path loss at 1 m [dB].
+    double l0 = 40;
+
+    /// \brief Variance of the received power [dB^2].
+    double sigma = 10;
+
+    /// \brief RSSI at 1 m [dBm].
+    double rssi1 = -15;
+
+    /// \brief Transmit power [dBm].
+    double txPower = 27;
+
+    /// \brief Noise floor [dBm].
+    double noiseFloor = -90;
+
+    /// \brief Size of the packet [bytes].
+    uint64_t numBytes = 100;
+  };
+
+  /// \brief Links of a batch, as a structure of arrays.
+  public: struct Batch
+  {
+    /// \brief Resize all the arrays.
+    /// \param[in] _size Number of links.
+    public: void Resize(size_t _size)
+    {
+      this->rxPos.resize(_size);
+      this->fading.resize(_size);
+      this->loss.resize(_size);
+      this->draw.resize(_size);
+      this->received.resize(_size);
+      this->rssi.resize(_size);
+      this->range.resize(_size);
+    }
+
+    /// \brief Input, position of each receiver.
+    public: std::vector<ignition::math::Vector3d> rxPos;
+
+    /// \brief Input, standard normal draw of the fading of each link.
+    public: std::vector<double> fading;
+
+    /// \brief Input, extra loss of each link, such as obstructions [dB].
+    public: std::vector<double> loss;
+
+    /// \brief Input, uniform draw in [0, 1) of the delivery of each link.
+    public: std::vector<double> draw;
+
+    /// \brief Output, 1 if the packet of the link is received.
+    public: std::vector<uint8_t> received;
+
+    /// \brief Output, received signal strength of each link [dBm].
+    public: std::vector<double> rssi;
+
+    /// \brief Output, range estimate of each received link [m].
+    public: std::vector<double> range;
+  };
+
+  /// \brief Constructor, with the default parameters.
+  public: LinkBudget()
+  {
+    this->Configure(Params());
+  }
+
+  /// \brief Set the parameters and tabulate the packet error rate.
+  /// \param[in] _params Parameters.
+  public: void Configure(const Params &_params)
+  {
+    this->params = _params;
+    this->stddev = _params.sigma > 0.0 ? std::sqrt(_params.sigma) : 0.0;
+
+    // range = 10^((rssi1 - rssi) / (10 n)), with
+    // rssi = txPower - l0 - 10 n log10(d) - loss + stddev * z.
+    const double tenN = 10.0 * _params.fadingExponent;
+    this->rangeScale = std::pow(10.0,
+        (_params.rssi1 - _params.txPower + _params.l0) / tenN);
+    this->rangeFading = -this->stddev * std::log(10.0) / tenN;
+    this->rangeLoss = std::log(10.0) / tenN;
+
+    this->table.resize(kTableSize + 1);
+    for (size_t i = 0; i <= kTableSize; ++i)
+    {
+      this->table[i] = ExactPacketErrorRate(
+          kMinSnr + i * kSnrStep, _params.numBytes);
+    }
+  }
+
+  /// \brief Parameters.
+  /// \return The parameters.
+  public: const Params &Parameters() const
+  {
+    return this->params;
+  }
+
+  /// \brief Standard deviation of the received power.
+  /// \return Standard deviation [dB], 0 if the links do not fade.
+  public: double Stddev() const
+  {
+    return this->stddev;
+  }
+
+  /// \brief Evaluate a batch of links.
+  /// \param[in] _txPos Position of the transmitter.
+  /// \param[in,out] _batch Links, with the inputs set.
+  public: void Evaluate(const ignition::math::Vector3d &_txPos,
+                        Batch &_batch) const
+  {
+    const size_t size = _batch.rxPos.size();
+    const double maxRangeSquared = this->params.maxRange > 0.0 ?
+        this->params.maxRange * this->params.maxRange :
+        std::numeric_limits<double>::infinity();
+    const double mean = this->params.txPower - this->params.l0;
+    const double tenN = 10.0 * this->params.fadingExponent;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+      const double distanceSquared =
+          (_batch.rxPos[i] - _txPos).SquaredLength();
+      const double distance = std::sqrt(distanceSquared);
+      const double rssi = mean - tenN * std::log10(distance) -
+          _batch.loss[i] + this->stddev * _batch.fading[i];
+      _batch.rssi[i] = rssi;
+      _batch.received[i] = distanceSquared <= maxRangeSquared &&
+          _batch.draw[i] > this->PacketErrorRate(
+          rssi - this->params.noiseFloor);
+      _batch.range[i] = 0.0;
+      if (_batch.received[i])
+      {
+        _batch.range[i] = this->rangeScale * distance *
+            std::exp(this->rangeFading * _batch.fading[i] +
+            this->rangeLoss * _batch.loss[i]);
+      }
+    }
+  }
+
+  /// \brief Tabulated packet error rate.
+  /// \param[in] _snr Signal to noise ratio [dB].
+  /// \return The packet error rate.
+  public: double PacketErrorRate(double _snr) const
+  {
+    const double x = (_snr - kMinSnr) / kSnrStep;
+    if (!(x > 0.0))
+      return this->table.front();
+    if (x >= kTableSize)
+      return this->table.back();
+    const size_t i = static_cast<size_t>(x);
+    const double t = x - i;
+    return this->table[i] + t * (this->table[i + 1] - this->table[i]);
+  }
+
+  /// \brief Exact packet error rate, the reference of the table.
+  /// \param[in] _snr Signal to noise ratio [dB].
+  /// \param[in] _numBytes Size of the packet [bytes].
+  /// \return The packet error rate.
+  public: static double ExactPacketErrorRate(double _snr,
+                                             uint64_t _numBytes)
+  {
+    const double ber = std::erfc(std::sqrt(std::pow(10.0, _snr / 10.0)));
+    return 1.0 - std::exp(_numBytes * std::log(1.0 - ber));
+  }
+
+  /// \brief Lowest SNR of the table [dB].
+  public: static constexpr double kMinSnr = -20.0;
+
+  /// \brief SNR step of the table [dB].
+  public: static constexpr double kSnrStep = 0.025;
+
+  /// \brief Number of steps of the table.
+  public: static constexpr size_t kTableSize = 2000;
+
+  /// \brief Parameters.
+  private: Params params;
+
+  /// \brief Standard deviation of the received power [dB].
+  private: double stddev = 0.0;
+
+  /// \brief Range estimate of a link at 1 m without fading [m].
+  private: double rangeScale = 1.0;
+
+  /// \brief Factor of the fading draw in the log of the range estimate.
+  private: double rangeFading = 0.0;
+
+  /// \brief Factor of the extra loss in the log of the range estimate.
+  private: double rangeLoss = 0.0;
+
+  /// \brief Packet error rate every kSnrStep from kMinSnr.
+  private: std::vector<double> table;
+};
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__LINKBUDGET_HH_
@@ -0,0 +1,514 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <ignition/common/Profiler.hh>
+#include <ignition/common/WorkerPool.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+#include <ignition/plugin/Register.hh>
+#include <sdf/sdf.hh>
+
+#include "ignition/gazebo/Link.hh"
+#include "ignition/gazebo/World.hh"
+
+#include "Components.hh"
+#include "HydrodynamicsKernel.hh"
+#include "MarineDynamics.hh"
+#include "Wavefield.hh"
+
+using namespace ignition;
+using namespace gazebo;
+using namespace systems;
+
+/// \brief A vessel link simulated by the system.
+struct MarineVessel
+{
+  /// \brief The link.
+  Link link;
+
+  /// \brief Buoyancy parameters, if the link has a Surface system.
+  std::optional<mbzirc::SurfaceParameters> surface;
+
+  /// \brief Added mass and drag model, if the link has a
+  /// SimpleHydrodynamics system.
+  std::optional<mbzirc::HydrodynamicsKernel<double>> hydrodynamics;
+
+  /// \brief Smooths the acceleration of the added mass term.
+  mbzirc::AccelerationFilter<double> accelerationFilter;
+
+  /// \brief The wavefield the vessel floats on.
+  std::shared_ptr<Wavefield> wavefield;
+
+  /// \brief Whether the wavefield uses the FFT model.
+  bool fft{false};
+
+  /// \brief The wavefield during the parallel stage of a step, null if the
+  /// depths are queried before it.
+  std::shared_ptr<const WavefieldSnapshot> snapshot;
+
+  /// \brief Index of the first buoyancy sample of the vessel.
+  size_t firstSample{0};
+
+  /// \brief Number of buoyancy samples of the vessel.
+  size_t sampleCount{0};
+};
+
+class ignition::gazebo::systems::MarineDynamicsPrivate
+{
+  /// \brief Rebuild the vessel list if links were added or removed.
+  /// \param[in] _ecm The entity component manager.
+  public: void UpdateVessels(const EntityComponentManager &_ecm);
+
+  /// \brief Read the state of a vessel from the ECM.
+  /// \param[in] _v Vessel index.
+  /// \param[in] _ecm The entity component manager.
+  /// \return True if the full state needed by the vessel is available and
+  /// the vessel is not parked.
+  public: bool ReadState(size_t _v, const EntityComponentManager &_ecm);
+
+  /// \brief Compute the wrench of a range of vessels.
+  /// \param[in] _begin First vessel index.
+  /// \param[in] _end One past the last vessel index.
+  public: void Compute(size_t _begin, size_t _end);
+
+  /// \brief Compute the wrench of a vessel.
+  /// \param[in] _v Vessel index.
+  public: void ComputeVessel(size_t _v);
+
+  /// \brief The world entity.
+  public: Entity world{kNullEntity};
+
+  /// \brief The world's gravity [m/s^2].
+  public: math::Vector3d gravity;
+
+  /// \brief Sim time of the current step [s].
+  public: double simTime{0};
+
+  /// \brief Number of worker threads.
+  public: unsigned int threads{2};
+
+  /// \brief Worker threads, null to compute on the simulation thread.
+  public: std::unique_ptr<common::WorkerPool> pool;
+
+  /// \brief Sorted links of the current vessels.
+  public: std::vector<Entity> entities;
+
+  /// \brief Links found at this step, reused across steps.
+  public: std::vector<Entity> found;
+
+  /// \brief The vessels.
+  public: std::vector<MarineVessel> vessels;
+
+  /// \brief Whether the state of each vessel was read.
+  public: std::vector<char> valid;
+
+  /// \brief Link pose of each vessel.
+  public: std::vector<math::Pose3d> pose;
+
+  /// \brief Center of mass pose of each vessel.
+  public: std::vector<math::Pose3d> comPose;
+
+  /// \brief World linear velocity of each vessel.
+  public: std::vector<math::Vector3d> linearVel;
+
+  /// \brief World angular velocity of each vessel.
+  public: std::vector<math::Vector3d> angularVel;
+
+  /// \brief World linear acceleration of each vessel.
+  public: std::vector<math::Vector3d> linearAccel;
+
+  /// \brief World angular acceleration of each vessel.
+  public: std::vector<math::Vector3d> angularAccel;
+
+  /// \brief World force on the center of mass of each vessel.
+  public: std::vector<math::Vector3d> force;
+
+  /// \brief World torque about the center of mass of each vessel.
+  public: std::vector<math::Vector3d> torque;
+
+  /// \brief Buoyancy sample points in the link frame, contiguous per vessel.
+  public: std::vector<math::Vector3d> samples;
+
+  /// \brief World x coordinate of each sample point.
+  public: std::vector<double> sampleX;
+
+  /// \brief World y coordinate of each sample point.
+  public: std::vector<double> sampleY;
+
+  /// \brief World z coordinate of each sample point.
+  public: std::vector<double> sampleZ;
+
+  /// \brief Wave depth at each sample point.
+  public: std::vector<double> depths;
+};
+
+//////////////////////////////////////////////////
+void MarineDynamicsPrivate::UpdateVessels(const EntityComponentManager &_ecm)
+{
+  this->found.clear();
+  _ecm.Each<mbzirc::components::SurfaceParameters>(
+      [&](const Entity &_entity,
+          const mbzirc::components::SurfaceParameters *) -> bool
+      {
+        this->found.push_back(_entity);
+        return true;
+      });
+  _ecm.Each<mbzirc::components::HydrodynamicsParameters>(
+      [&](const Entity &_entity,
+          const mbzirc::components::HydrodynamicsParameters *) -> bool
+      {
+        this->found.push_back(_entity);
+        return true;
+      });
+  std::sort(this->found.begin(), this->found.end());
+  this->found.erase(std::unique(this->found.begin(), this->found.end()),
+      this->found.end());
+
+  if (this->found == this->entities)
+    return;
+  this->entities = this->found;
+
+  this->vessels.clear();
+  this->samples.clear();
+  for (const auto &entity : this->entities)
+  {
+    MarineVessel vessel;
+    vessel.link = Link(entity);
+
+    auto surface =
+        _ecm.Component<mbzirc::components::SurfaceParameters>(entity);
+    if (surface)
+    {
+      vessel.wavefield =
+          Wavefield::Find(this->world, surface->Data().wavefield);
+      if (!vessel.wavefield)
+      {
+        ignerr << "No wavefield loaded for link [" << entity
+               << "], not applying its buoyancy" << std::endl;
+      }
+      else
+      {
+        vessel.surface = surface->Data();
+        vessel.fft = vessel.wavefield->Model() == "FFT";
+        vessel.firstSample = this->samples.size();
+        vessel.surface->AppendSamples(this->samples);
+        vessel.sampleCount = this->samples.size() - vessel.firstSample;
+      }
+    }
+
+    auto hydrodynamics =
+        _ecm.Component<mbzirc::components::HydrodynamicsParameters>(entity);
+    if (hydrodynamics)
+    {
+      vessel.hydrodynamics.emplace(hydrodynamics->Data());
+      vessel.accelerationFilter.SetCutoff(
+          hydrodynamics->Data().accelerationCutoff);
+    }
+
+    this->vessels.push_back(vessel);
+  }
+
+  const size_t count = this->vessels.size();
+  this->valid.assign(count, 0);
+  this->pose.resize(count);
+  this->comPose.resize(count);
+  this->linearVel.resize(count);
+  this->angularVel.resize(count);
+  this->linearAccel.resize(count);
+  this->angularAccel.resize(count);
+  this->force.resize(count);
+  this->torque.resize(count);
+  this->sampleX.resize(this->samples.size());
+  this->sampleY.resize(this->samples.size());
+  this->sampleZ.resize(this->samples.size());
+  this->depths.resize(this->samples.size());
+
+  igndbg << "MarineDynamics simulating " << count << " vessel links with "
+         << this->samples.size() << " buoyancy samples" << std::endl;
+}
+
+//////////////////////////////////////////////////
+bool MarineDynamicsPrivate::ReadState(size_t _v,
+    const EntityComponentManager &_ecm)
+{
+  const auto &vessel = this->vessels[_v];
+
+  // Parked vessels ride the waves kinematically, see Surface.
+  if (_ecm.Component<mbzirc::components::Parked>(vessel.link.Entity()))
+    return false;
+
+  auto worldPose = vessel.link.WorldPose(_ecm);
+  auto worldComPose = vessel.link.WorldInertialPose(_ecm);
+  if (!worldPose || !worldComPose)
+  {
+    ignerr << "Unable to get world pose from link ["
+           << vessel.link.Entity() << "]" << std::endl;
+    return false;
+  }
+  this->pose[_v] = *worldPose;
+  this->comPose[_v] = *worldComPose;
+
+  if (vessel.hydrodynamics)
+  {
+    auto worldAngularVel = vessel.link.WorldAngularVelocity(_ecm);
+    auto worldLinearVel = vessel.link.WorldLinearVelocity(_ecm);
+    auto worldAngularAccel = vessel.link.WorldAngularAcceleration(_ecm);
+    auto worldLinearAccel = vessel.link.WorldLinearAcceleration(_ecm);
+    if (!worldAngularVel || !worldLinearVel || !worldAngularAccel ||
+        !worldLinearAccel)
+    {
+      ignerr << "No velocity or acceleration for link ["
+             << vessel.link.Entity() << "]" << std::endl;
+      return false;
+    }
+    this->angularVel[_v] = *worldAngularVel;
+    this->linearVel[_v] = *worldLinearVel;
+    this->angularAccel[_v] = *worldAngularAccel;
+    this->linearAccel[_v] = *worldLinearAccel;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+void MarineDynamicsPrivate::Compute(size_t _begin, size_t _end)
+{
+  for (size_t v = _begin; v < _end; ++v)
+    this->ComputeVessel(v);
+}
+
+//////////////////////////////////////////////////
+void MarineDynamicsPrivate::ComputeVessel(size_t _v)
+{
+  auto &force = this->force[_v];
+  auto &torque = this->torque[_v];
+  force = math::Vector3d::Zero;
+  torque = math::Vector3d::Zero;
+  if (!this->valid[_v])
+    return;
+
+  // Each vessel is computed by a single worker, which owns its filter.
+  auto &vessel = this->vessels[_v];
+  const auto &comPose = this->comPose[_v];
+
+  // Buoyancy, see Surface.
+  if (vessel.surface)
+  {
+    const size_t first = vessel.firstSample;
+    if (vessel.snapshot)
+    {
+      vessel.snapshot->ComputeDepthBatch(&this->sampleX[first],
+          &this->sampleY[first], vessel.sampleCount, &this->depths[first]);
+    }
+
+    double buoyancy = 0.0;
+    math::Vector3d moment(0, 0, 0);
+    for (size_t s = first; s < first + vessel.sampleCount; ++s)
+    {
+      const double kDeltaZ = vessel.surface->fluidLevel + this->depths[s] -
+          this->sampleZ[s];
+      const double kBuoyForce =
+          vessel.surface->SampleBuoyancy(kDeltaZ, -this->gravity.Z());
+      buoyancy += kBuoyForce;
+      moment += this->samples[s] * kBuoyForce;
+    }
+
+    if (buoyancy > 0.0)
+    {
+      // Apply at the center of buoyancy, moved to the center of mass.
+      const auto &pose = this->pose[_v];
+      const math::Vector3d center = pose.Pos() +
+          pose.Rot() * (moment / buoyancy);
+      const math::Vector3d buoyancyForce(0, 0, buoyancy);
+      force += buoyancyForce;
+      torque += (center - comPose.Pos()).Cross(buoyancyForce);
+    }
+  }
+
+  // Added mass and drag, see SimpleHydrodynamics.
+  if (vessel.hydrodynamics)
+  {
+    using Vector6 = mbzirc::HydrodynamicsKernel<double>::Vector6;
+    const auto kInverse = comPose.Rot().Inverse();
+    const math::Vector3d u = kInverse * this->linearVel[_v];
+    const math::Vector3d w = kInverse * this->angularVel[_v];
+    const math::Vector3d a = kInverse * this->linearAccel[_v];
+    const math::Vector3d alpha = kInverse * this->angularAccel[_v];
+
+    Vector6 state;
+    Vector6 stateDot;
+    state << u.X(), u.Y(), u.Z(), w.X(), w.Y(), w.Z();
+    stateDot << a.X(), a.Y(), a.Z(), alpha.X(), alpha.Y(), alpha.Z();
+    stateDot = vessel.accelerationFilter.Update(stateDot, this->simTime);
+    const Vector6 kForceSum = vessel.hydrodynamics->Force(state, stateDot);
+
+    force += comPose.Rot().RotateVector(
+        math::Vector3d(kForceSum(0), kForceSum(1), kForceSum(2)));
+    torque += comPose.Rot().RotateVector(
+        math::Vector3d(kForceSum(3), kForceSum(4), kForceSum(5)));
+  }
+}
+
+//////////////////////////////////////////////////
+MarineDynamics::MarineDynamics()
+  : dataPtr(std::make_unique<MarineDynamicsPrivate>())
+{
+}
+
+//////////////////////////////////////////////////
+MarineDynamics::~MarineDynamics() = default;
+
+//////////////////////////////////////////////////
+void MarineDynamics::Configure(const Entity &_entity,
+    const std::shared_ptr<const sdf::Element> &_sdf,
+    EntityComponentManager &_ecm,
+    EventManager &/*_eventMgr*/)
+{
+  this->dataPtr->world = _entity;
+
+  auto gravityOpt = World(_entity).Gravity(_ecm);
+  if (!gravityOpt)
+  {
+    ignerr << "Unable to get the gravity from the world" << std::endl;
+    return;
+  }
+  this->dataPtr->gravity = *gravityOpt;
+
+  int threads = _sdf->Get<int>("threads", 2).first;
+  this->dataPtr->threads = static_cast<unsigned int>(std::max(threads, 0));
+  if (this->dataPtr->threads > 0)
+  {
+    this->dataPtr->pool =
+        std::make_unique<common::WorkerPool>(this->dataPtr->threads);
+  }
+
+  // Tell the per vessel systems to stay passive.
+  _ecm.CreateComponent(_entity, mbzirc::components::MarineDynamics());
+
+  igndbg << "MarineDynamics plugin successfully configured with "
+         << this->dataPtr->threads << " threads" << std::endl;
+}
+
+//////////////////////////////////////////////////
+void MarineDynamics::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
+    ignition::gazebo::EntityComponentManager &_ecm)
+{
+  IGN_PROFILE("MarineDynamics::PreUpdate");
+
+  auto &d = *this->dataPtr;
+  d.UpdateVessels(_ecm);
+
+  // Pick up sea state changes at the step boundary.
+  for (auto &vessel : d.vessels)
+  {
+    if (vessel.wavefield)
+      vessel.wavefield->ApplyPendingUpdate();
+  }
+
+  if (_info.paused || d.vessels.empty())
+    return;
+
+  const double simTime = std::chrono::duration<double>(_info.simTime).count();
+  d.simTime = simTime;
+
+  // Gather the state and the world sample points.
+  {
+    IGN_PROFILE("MarineDynamics::Gather");
+    for (size_t v = 0; v < d.vessels.size(); ++v)
+    {
+      auto &vessel = d.vessels[v];
+      d.valid[v] = d.ReadState(v, _ecm);
+      if (!d.valid[v] || !vessel.surface)
+        continue;
+
+      const auto &pose = d.pose[v];
+      for (size_t s = vessel.firstSample;
+           s < vessel.firstSample + vessel.sampleCount; ++s)
+      {
+        const math::Vector3d point = pose.Pos() + pose.Rot() * d.samples[s];
+        d.sampleX[s] = point.X();
+        d.sampleY[s] = point.Y();
+        d.sampleZ[s] = point.Z();
+      }
+
+      // The FFT model and the grid cache update shared state on lookup, so
+      // they are queried here. The sum of components is evaluated on a
+      // snapshot that the workers can share.
+      if (vessel.fft || vessel.wavefield->GridCacheEnabled())
+      {
+        vessel.snapshot = nullptr;
+        for (size_t s = vessel.firstSample;
+             s < vessel.firstSample + vessel.sampleCount; ++s)
+        {
+          d.depths[s] = vessel.wavefield->ComputeDepth(
+              math::Vector3d(d.sampleX[s], d.sampleY[s], 0), simTime);
+        }
+      }
+      else
+      {
+        vessel.snapshot = vessel.wavefield->Snapshot(simTime);
+      }
+    }
+  }
+
+  // Compute the wrenches, one contiguous range of vessels per thread.
+  {
+    IGN_PROFILE("MarineDynamics::Compute");
+    const size_t count = d.vessels.size();
+    if (!d.pool || count < 2)
+    {
+      d.Compute(0, count);
+    }
+    else
+    {
+      const size_t chunk = (count + d.threads - 1) / d.threads;
+      for (size_t begin = 0; begin < count; begin += chunk)
+      {
+        const size_t end = std::min(count, begin + chunk);
+        d.pool->AddWork([&d, begin, end]() { d.Compute(begin, end); });
+      }
+      d.pool->WaitForResults();
+    }
+
+    // Release the snapshots so the wavefield can reuse their buffers at the
+    // next step.
+    for (auto &vessel : d.vessels)
+      vessel.snapshot = nullptr;
+  }
+
+  // One wrench per vessel.
+  {
+    IGN_PROFILE("MarineDynamics::Apply");
+    for (size_t v = 0; v < d.vessels.size(); ++v)
+    {
+      if (d.valid[v])
+        d.vessels[v].link.AddWorldWrench(_ecm, d.force[v], d.torque[v]);
+    }
+  }
+}
+
+IGNITION_ADD_PLUGIN(MarineDynamics,
+                    ignition::gazebo::System,
+                    MarineDynamics::ISystemConfigure,
+                    MarineDynamics::ISystemPreUpdate)
+
+IGNITION_ADD_PLUGIN_ALIAS(MarineDynamics,
+                          "ignition::gazebo::systems::MarineDynamics")
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGNITION_GAZEBO_SYSTEMS_MARINE_DYNAMICS_HH_
+#define IGNITION_GAZEBO_SYSTEMS_MARINE_DYNAMICS_HH_
+
+#include <memory>
+#include <ignition/gazebo/System.hh>
+#include <sdf/sdf.hh>
+
+namespace ignition
+{
+namespace gazebo
+{
+// Inline bracket to help doxygen filtering.
+inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+namespace systems
+{
+  // Forward declaration
+  class MarineDynamicsPrivate;
+
+  /// \brief A world system that computes the buoyancy and hydrodynamic loads
+  /// of every vessel in the world in one place, instead of one Surface and
+  /// one SimpleHydrodynamics system per vessel.
+  ///
+  /// The vessels keep their Surface and SimpleHydrodynamics plugins, which
+  /// publish their parameters as components on the vessel link and then stay
+  /// passive while this system is loaded. Every step the state of all the
+  /// vessels is gathered into contiguous arrays, the loads are computed in
+  /// parallel on a small thread pool, and one wrench is applied per vessel.
+  ///
+  /// Surface plugins using the "direct" `<depth_method>` or `<lod>` keep
+  /// applying their own buoyancy.
+  ///
+  /// ## Optional system parameters
+  ///
+  /// * `<threads>` is the number of worker threads, 0 to compute on the
+  /// simulation thread. Defaults to 2.
+  ///
+  /// ## Example
+  /// <plugin
+  ///   filename="libMarineDynamics.so"
+  ///   name="ignition::gazebo::systems::MarineDynamics">
+  ///   <threads>2</threads>
+  /// </plugin>
+  class MarineDynamics
+      : public System,
+        public ISystemConfigure,
+        public ISystemPreUpdate
+  {
+    /// \brief Constructor.
+    public: MarineDynamics();
+
+    /// \brief Destructor.
+    public: ~MarineDynamics() override;
+
+    // Documentation inherited.
+    public: void Configure(const Entity &_entity,
+                           const std::shared_ptr<const sdf::Element> &_sdf,
+                           EntityComponentManager &_ecm,
+                           EventManager &_eventMgr) override;
+
+    // Documentation inherited.
+    public: void PreUpdate(
+                const ignition::gazebo::UpdateInfo &_info,
+                ignition::gazebo::EntityComponentManager &_ecm) override;
+
+    /// \brief Private data pointer.
+    private: std::unique_ptr<MarineDynamicsPrivate> dataPtr;
+  };
+  }
+}
+}
+}
+
+#endif
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef MBZIRC_IGN__MARINEPARAMETERS_HH_
+#define MBZIRC_IGN__MARINEPARAMETERS_HH_
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+namespace mbzirc
+{
+/// \brief Buoyancy parameters of a vessel link, see the Surface system.
+struct SurfaceParameters
+{
+  /// \brief Vessel length [m].
+  double vehicleLength = 4.9;
+
+  /// \brief Vessel width [m].
+  double vehicleWidth = 2.4;
+
+  /// \brief Demi-hull radius [m].
+  double hullRadius = 0.213;
+
+  /// \brief Length discretization, i.e., "N"
+  int numSamples = 2;
+
+  /// \brief Fluid height [m].
+  double fluidLevel = 0;
+
+  /// \brief Fluid density [kg/m^3].
+  double fluidDensity = 997.7735;
+
+  /// \brief Key of the wavefield the vessel floats on, see Wavefield::Key.
+  std::string wavefield;
+
+  /// \brief Append the sample points in the link frame, one row of
+  /// numSamples points along each hull.
+  /// \param[out] _samples The sample points.
+  void AppendSamples(std::vector<ignition::math::Vector3d> &_samples) const
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      const double y = (i * 2.0 - 1.0) * this->vehicleWidth / 2.0;
+      for (int j = 1; j <= this->numSamples; ++j)
+      {
+        const double x = ((j - 0.5) / this->numSamples - 0.5) *
+            this->vehicleLength;
+        _samples.push_back(ignition::math::Vector3d(x, y, 0));
+      }
+    }
+  }
+
+  /// \brief Buoyancy force of the hull segment around one sample point.
+  /// \param[in] _deltaZ Height of the fluid surface above the sample [m].
+  /// \param[in] _gravity Magnitude of the gravity [m/s^2].
+  /// \return The upward force [N].
+  double SampleBuoyancy(double _deltaZ, double _gravity) const
+  {
+    // enforce only upward buoy force
+    const double h = std::clamp(_deltaZ, 0.0, this->hullRadius);
+
+    // Area of the circle segment below the surface.
+    // \ref https://www.mathopenref.com/segmentareaht.html
+    const double r = this->hullRadius;
+    const double area = r * r * std::acos((r - h) / r) -
+        (r - h) * std::sqrt(2 * r * h - h * h);
+    return area * this->vehicleLength / this->numSamples * _gravity *
+        this->fluidDensity;
+  }
+};
+
+/// \brief Hydrodynamic parameters of a vessel link, see the
+/// SimpleHydrodynamics system for their description.
+struct HydrodynamicsParameters
+{
+  /// \brief Added mass in surge, X_\dot{u}.
+  double xDotU = 5;
+
+  /// \brief Added mass in sway, Y_\dot{v}.
+  double yDotV = 5;
+
+  /// \brief Added mass in heave, Z_\dot{w}.
+  double zDotW = 0.1;
+
+  /// \brief Added mass in roll, K_\dot{p}.
+  double kDotP = 0.1;
+
+  /// \brief Added mass in pitch, M_\dot{q}.
+  double mDotQ = 0.1;
+
+  /// \brief Added mass in yaw, N_\dot{r}.
+  double nDotR = 1;
+
+  /// \brief Linear drag in surge.
+  double xU = 20;
+
+  /// \brief Quadratic drag in surge.
+  double xUU = 0;
+
+  /// \brief Linear drag in sway.
+  double yV = 20;
+
+  /// \brief Quadratic drag in sway.
+  double yVV = 0;
+
+  /// \brief Linear drag in heave.
+  double zW = 20;
+
+  /// \brief Quadratic drag in heave.
+  double zWW = 0;
+
+  /// \brief Linear drag in roll.
+  double kP = 20;
+
+  /// \brief Quadratic drag in roll.
+  double kPP = 0;
+
+  /// \brief Linear drag in pitch.
+  double mQ = 20;
+
+  /// \brief Quadratic drag in pitch.
+  double mQQ = 0;
+
+  /// \brief Linear drag in yaw.
+  double nR = 20;
+
+  /// \brief Quadratic drag in yaw.
+  double nRR = 0;
+
+  /// \brief Cutoff frequency of the low-pass filter on the body frame
+  /// acceleration of the added mass term [Hz], 0 to use the raw
+  /// acceleration.
+  double accelerationCutoff = 0;
+};
+
+/// \brief Stream insertion, used to serialize the component.
+/// \param[in] _out Output stream.
+/// \param[in] _params Parameters to write.
+/// \return The stream.
+inline std::ostream &operator<<(std::ostream &_out,
+    const SurfaceParameters &_params)
+{
+  _out << _params.vehicleLength << " " << _params.vehicleWidth << " "
+       << _params.hullRadius << " " << _params.numSamples << " "
+       << _params.fluidLevel << " " << _params.fluidDensity << " "
+       << std::quoted(_params.wavefield);
+  return _out;
+}
+
+/// \brief Stream extraction, used to deserialize the component.
+/// \param[in] _in Input stream.
+/// \param[out] _params Parameters to read.
+/// \return The stream.
+inline std::istream &operator>>(std::istream &_in,
+    SurfaceParameters &_params)
+{
+  _in >> _params.vehicleLength >> _params.vehicleWidth
+      >> _params.hullRadius >> _params.numSamples
+      >> _params.fluidLevel >> _params.fluidDensity
+      >> std::quoted(_params.wavefield);
+  return _in;
+}
+
+/// \brief Stream insertion, used to serialize the component.
+/// \param[in] _out Output stream.
+/// \param[in] _params Parameters to write.
+/// \return The stream.
+inline std::ostream &operator<<(std::ostream &_out,
+    const HydrodynamicsParameters &_params)
+{
+  _out << _params.xDotU << " " << _params.yDotV << " " << _params.zDotW << " "
+       << _params.kDotP << " " << _params.mDotQ << " " << _params.nDotR << " "
+       << _params.xU << " " << _params.xUU << " "
+       << _params.yV << " " << _params.yVV << " "
+       << _params.zW << " " << _params.zWW << " "
+       << _params.kP << " " << _params.kPP << " "
+       << _params.mQ << " " << _params.mQQ << " "
+       << _params.nR << " " << _params.nRR << " "
+       << _params.accelerationCutoff;
+  return _out;
+}
+
+/// \brief Stream extraction, used to deserialize the component.
+/// \param[in] _in Input stream.
+/// \param[out] _params Parameters to read.
+/// \return The stream.
+inline std::istream &operator>>(std::istream &_in,
+    HydrodynamicsParameters &_params)
+{
+  _in >> _params.xDotU >> _params.yDotV >> _params.zDotW
+      >> _params.kDotP >> _params.mDotQ >> _params.nDotR
+      >> _params.xU >> _params.xUU >> _params.yV >> _params.yVV
+      >> _params.zW >> _params.zWW >> _params.kP >> _params.kPP
+      >> _params.mQ >> _params.mQQ >> _params.nR >> _params.nRR
+      >> _params.accelerationCutoff;
+  return _in;
+}
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__MARINEPARAMETERS_HH_
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "OcclusionGrid.hh"
+
+using namespace ignition;
+using namespace mbzirc;
+
+/// \brief Height of an empty cell.
+static constexpr float kNoHeight = -std::numeric_limits<float>::infinity();
+
+//////////////////////////////////////////////////
+void OcclusionGrid::Build(const std::vector<math::Vector3d> &_vertices,
+    const std::vector<uint32_t> &_indices, double _cellSize)
+{
+  this->heights.clear();
+  this->blockHeights.clear();
+  this->nx = 0;
+  this->ny = 0;
+  this->maxHeight = -std::numeric_limits<double>::infinity();
+  if (_vertices.empty() || _indices.size() < 3 || !(_cellSize > 0.0))
+    return;
+
+  double lowX = std::numeric_limits<double>::max();
+  double lowY = lowX;
+  double highX = -lowX;
+  double highY = -lowX;
+  for (const auto &v : _vertices)
+  {
+    lowX = std::min(lowX, v.X());
+    lowY = std::min(lowY, v.Y());
+    highX = std::max(highX, v.X());
+    highY = std::max(highY, v.Y());
+  }
+
+  // Coarsen the grid until it fits the cell budget.
+  this->cellSize = _cellSize;
+  while (true)
+  {
+    this->nx = static_cast<int64_t>((highX - lowX) / this->cellSize) + 1;
+    this->ny = static_cast<int64_t>((highY - lowY) / this->cellSize) + 1;
+    if (static_cast<size_t>(this->nx * this->ny) <= kMaxCells)
+      break;
+    this->cellSize *= 2.0;
+  }
+  this->minX = lowX;
+  this->minY = lowY;
+  this->heights.assign(this->nx * this->ny, kNoHeight);
+
+  auto cellX = [this](double _x)
+  {
+    return std::clamp(static_cast<int64_t>(
+        std::floor((_x - this->minX) / this->cellSize)), int64_t{0},
+        this->nx - 1);
+  };
+  auto cellY = [this](double _y)
+  {
+    return std::clamp(static_cast<int64_t>(
+        std::floor((_y - this->minY) / this->cellSize)), int64_t{0},
+        this->ny - 1);
+  };
+  auto raise = [this](int64_t _ix, int64_t _iy, double _z)
+  {
+    float &h = this->heights[_iy * this->nx + _ix];
+    h = std::max(h, static_cast<float>(_z));
+  };
+
+  for (size_t t = 0; t + 2 < _indices.size(); t += 3)
+  {
+    const auto &a = _vertices[_indices[t]];
+    const auto &b = _vertices[_indices[t + 1]];
+    const auto &c = _vertices[_indices[t + 2]];
+
+    // Vertices, so that triangles smaller than a cell are kept.
+    for (const auto *v : {&a, &b, &c})
+      raise(cellX(v->X()), cellY(v->Y()), v->Z());
+
+    // Cell centers within the triangle, with the height of the triangle
+    // there. Vertical triangles only have their vertices.
+    const double det = (b.X() - a.X()) * (c.Y() - a.Y()) -
+        (c.X() - a.X()) * (b.Y() - a.Y());
+    if (std::abs(det) < 1e-12)
+      continue;
+    const int64_t x0 = cellX(std::min({a.X(), b.X(), c.X()}));
+    const int64_t x1 = cellX(std::max({a.X(), b.X(), c.X()}));
+    const int64_t y0 = cellY(std::min({a.Y(), b.Y(), c.Y()}));
+    const int64_t y1 = cellY(std::max({a.Y(), b.Y(), c.Y()}));
+    for (int64_t iy = y0; iy <= y1; ++iy)
+    {
+      const double y = this->minY + (iy + 0.5) * this->cellSize;
+      for (int64_t ix = x0; ix <= x1; ++ix)
+      {
+        const double x = this->minX + (ix + 0.5) * this->cellSize;
+        const double u = ((x - a.X()) * (c.Y() - a.Y()) -
+            (c.X() - a.X()) * (y - a.Y())) / det;
+        const double v = ((b.X() - a.X()) * (y - a.Y()) -
+            (x - a.X()) * (b.Y() - a.Y())) / det;
+        if (u < 0.0 || v < 0.0 || u + v > 1.0)
+          continue;
+        raise(ix, iy, a.Z() + u * (b.Z() - a.Z()) + v * (c.Z() - a.Z()));
+      }
+    }
+  }
+
+  // Highest cell of each block.
+  this->bnx = (this->nx + kBlock - 1) / kBlock;
+  this->bny = (this->ny + kBlock - 1) / kBlock;
+  this->blockHeights.assign(this->bnx * this->bny, kNoHeight);
+  for (int64_t iy = 0; iy < this->ny; ++iy)
+  {
+    for (int64_t ix = 0; ix < this->nx; ++ix)
+    {
+      float &h = this->blockHeights[(iy / kBlock) * this->bnx + ix / kBlock];
+      h = std::max(h, this->heights[iy * this->nx + ix]);
+    }
+  }
+
+  for (float h : this->blockHeights)
+    this->maxHeight = std::max(this->maxHeight, static_cast<double>(h));
+}
+
+//////////////////////////////////////////////////
+bool OcclusionGrid::Empty() const
+{
+  return this->heights.empty();
+}
+
+//////////////////////////////////////////////////
+double OcclusionGrid::CellSize() const
+{
+  return this->cellSize;
+}
+
+//////////////////////////////////////////////////
+size_t OcclusionGrid::CellCount() const
+{
+  return this->heights.size();
+}
+
+//////////////////////////////////////////////////
+double OcclusionGrid::Height(double _x, double _y) const
+{
+  if (this->heights.empty())
+    return kNoHeight;
+  const double fx = std::floor((_x - this->minX) / this->cellSize);
+  const double fy = std::floor((_y - this->minY) / this->cellSize);
+  if (fx < 0.0 || fy < 0.0 || fx >= this->nx || fy >= this->ny)
+    return kNoHeight;
+  return this->heights[static_cast<int64_t>(fy) * this->nx +
+      static_cast<int64_t>(fx)];
+}
+
+//////////////////////////////////////////////////
+template <typename Visit>
+bool OcclusionGrid::Walk(const math::Vector3d &_a, double _dx, double _dy,
+    double _t0, double _t1, double _size, int64_t _nx, int64_t _ny,
+    Visit _visit) const
+{
+  // 2D DDA from the cell of the point at _t0.
+  const double x = _a.X() + _t0 * _dx - this->minX;
+  const double y = _a.Y() + _t0 * _dy - this->minY;
+  int64_t ix = std::clamp(static_cast<int64_t>(std::floor(x / _size)),
+      int64_t{0}, _nx - 1);
+  int64_t iy = std::clamp(static_cast<int64_t>(std::floor(y / _size)),
+      int64_t{0}, _ny - 1);
+  const int64_t stepX = _dx > 0.0 ? 1 : -1;
+  const int64_t stepY = _dy > 0.0 ? 1 : -1;
+  const double inf = std::numeric_limits<double>::infinity();
+  const double deltaX = _dx != 0.0 ? _size / std::abs(_dx) : inf;
+  const double deltaY = _dy != 0.0 ? _size / std::abs(_dy) : inf;
+  double nextX = _dx != 0.0 ?
+      ((ix + (_dx > 0.0 ? 1 : 0)) * _size + this->minX - _a.X()) / _dx : inf;
+  double nextY = _dy != 0.0 ?
+      ((iy + (_dy > 0.0 ? 1 : 0)) * _size + this->minY - _a.Y()) / _dy : inf;
+
+  double t = _t0;
+  while (true)
+  {
+    const double tExit = std::min({nextX, nextY, _t1});
+    if (!_visit(ix, iy, t, tExit))
+      return false;
+    if (tExit >= _t1)
+      return true;
+
+    if (nextX < nextY)
+    {
+      ix += stepX;
+      nextX += deltaX;
+    }
+    else
+    {
+      iy += stepY;
+      nextY += deltaY;
+    }
+    if (ix < 0 || iy < 0 || ix >= _nx || iy >= _ny)
+      return true;
+    t = tExit;
+  }
+}
+
+//////////////////////////////////////////////////
+bool OcclusionGrid::LineOfSight(const math::Vector3d &_a,
+    const math::Vector3d &_b) const
+{
+  if (this->heights.empty() ||
+      std::min(_a.Z(), _b.Z()) >= this->maxHeight)
+  {
+    return true;
+  }
+
+  // Clip the segment to the grid, as a + t (b - a) with t in [t0, t1].
+  const double dx = _b.X() - _a.X();
+  const double dy = _b.Y() - _a.Y();
+  const double dz = _b.Z() - _a.Z();
+  double t0 = 0.0;
+  double t1 = 1.0;
+  auto clip = [&t0, &t1](double _p, double _d, double _low, double _high)
+  {
+    if (std::abs(_d) < 1e-12)
+      return _p >= _low && _p <= _high;
+    double tLow = (_low - _p) / _d;
+    double tHigh = (_high - _p) / _d;
+    if (tLow > tHigh)
+      std::swap(tLow, tHigh);
+    t0 = std::max(t0, tLow);
+    t1 = std::min(t1, tHigh);
+    return t0 <= t1;
+  };
+  if (!clip(_a.X(), dx, this->minX, this->minX + this->nx * this->cellSize) ||
+      !clip(_a.Y(), dy, this->minY, this->minY + this->ny * this->cellSize))
+  {
+    return true;
+  }
+
+  // The segment is straight, so its lowest point in a cell is where it
+  // enters or leaves the cell. Walk the blocks, and the cells of the blocks
+  // the segment passes below the top of.
+  auto low = [&](double _tEnter, double _tExit)
+  {
+    return _a.Z() + dz * (dz > 0.0 ? _tEnter : _tExit);
+  };
+  const double blockSize = this->cellSize * kBlock;
+  return this->Walk(_a, dx, dy, t0, t1, blockSize, this->bnx, this->bny,
+      [&](int64_t _bx, int64_t _by, double _tEnter, double _tExit)
+      {
+        if (low(_tEnter, _tExit) >= this->blockHeights[_by * this->bnx + _bx])
+          return true;
+        return this->Walk(_a, dx, dy, _tEnter, _tExit, this->cellSize,
+            this->nx, this->ny,
+            [&](int64_t _ix, int64_t _iy, double _tIn, double _tOut)
+            {
+              return low(_tIn, _tOut) >= this->heights[_iy * this->nx + _ix];
+            });
+      });
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef MBZIRC_IGN__OCCLUSIONGRID_HH_
+#define MBZIRC_IGN__OCCLUSIONGRID_HH_
+
+#include <cstdint>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+namespace mbzirc
+{
+/// \brief A 2.5D height grid of static geometry, used to test the line of
+/// sight between two points without ray casts against the physics.
+///
+/// Each cell holds the highest point of the triangles over it, sampled at
+/// the cell center and at the triangle vertices, so features smaller than
+/// a cell may be missed. A segment is blocked if it passes below the top
+/// of a cell it crosses. The cells are visited with a 2D DDA traversal,
+/// first over blocks of kBlock x kBlock cells holding their highest cell,
+/// then over the cells of the blocks the segment passes below the top of.
+/// A test costs at most one step per cell along the segment, and far less
+/// over open water. Segments above the highest cell are accepted without
+/// traversal.
+class OcclusionGrid
+{
+  /// \brief Build the grid over the bounding box of a triangle mesh.
+  /// \param[in] _vertices Vertices in the world frame.
+  /// \param[in] _indices Vertex indices, three per triangle.
+  /// \param[in] _cellSize Cell size [m]. Larger cells are used if the
+  /// grid would exceed kMaxCells.
+  public: void Build(const std::vector<ignition::math::Vector3d> &_vertices,
+              const std::vector<uint32_t> &_indices, double _cellSize);
+
+  /// \brief Whether the grid holds no geometry.
+  /// \return True if empty.
+  public: bool Empty() const;
+
+  /// \brief Cell size.
+  /// \return The cell size [m].
+  public: double CellSize() const;
+
+  /// \brief Number of cells.
+  /// \return The number of cells.
+  public: size_t CellCount() const;
+
+  /// \brief Height of the geometry at a point.
+  /// \param[in] _x X coordinate [m].
+  /// \param[in] _y Y coordinate [m].
+  /// \return The height [m], -infinity where there is no geometry.
+  public: double Height(double _x, double _y) const;
+
+  /// \brief Whether a segment clears the geometry.
+  /// \param[in] _a First point, in the world frame.
+  /// \param[in] _b Second point, in the world frame.
+  /// \return True if the segment does not pass below any cell top.
+  public: bool LineOfSight(const ignition::math::Vector3d &_a,
+              const ignition::math::Vector3d &_b) const;
+
+  /// \brief Visit the cells a segment crosses, in order.
+  /// \param[in] _a Start of the segment.
+  /// \param[in] _dx X extent of the segment.
+  /// \param[in] _dy Y extent of the segment.
+  /// \param[in] _t0 Segment parameter to start from, within the grid.
+  /// \param[in] _t1 Segment parameter to stop at, within the grid.
+  /// \param[in] _size Cell size of the level [m].
+  /// \param[in] _nx Number of cells of the level along x.
+  /// \param[in] _ny Number of cells of the level along y.
+  /// \param[in] _visit Called with the cell indices and the segment
+  /// parameters where the segment enters and leaves the cell. Returns
+  /// false to stop.
+  /// \return False if stopped by _visit.
+  private: template <typename Visit>
+           bool Walk(const ignition::math::Vector3d &_a, double _dx,
+               double _dy, double _t0, double _t1, double _size,
+               int64_t _nx, int64_t _ny, Visit _visit) const;
+
+  /// \brief Largest number of cells of a grid.
+  public: static constexpr size_t kMaxCells = 1u << 24;
+
+  /// \brief Number of cells of a block along each axis.
+  public: static constexpr int64_t kBlock = 16;
+
+  /// \brief Lower x coordinate of the grid [m].
+  private: double minX = 0.0;
+
+  /// \brief Lower y coordinate of the grid [m].
+  private: double minY = 0.0;
+
+  /// \brief Cell size [m].
+  private: double cellSize = 1.0;
+
+  /// \brief Number of cells along x.
+  private: int64_t nx = 0;
+
+  /// \brief Number of cells along y.
+  private: int64_t ny = 0;
+
+  /// \brief Height of each cell, row major along x [m].
+  private: std::vector<float> heights;
+
+  /// \brief Number of blocks along x.
+  private: int64_t bnx = 0;
+
+  /// \brief Number of blocks along y.
+  private: int64_t bny = 0;
+
+  /// \brief Height of the highest cell of each block [m].
+  private: std::vector<float> blockHeights;
+
+  /// \brief Height of the highest cell [m].
+  private: double maxHeight = 0.0;
+};
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__OCCLUSIONGRID_HH_
@@ -15,25 +15,43 @@
  *
  */
 
+#include <ignition/msgs/double_v.pb.h>
 #include <ignition/msgs/param_v.pb.h>
+#include <ignition/msgs/stringmsg_v.pb.h>
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <memory>
 #include <random>
+#include <set>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <ignition/common/Profiler.hh>
+#include <ignition/common/WorkerPool.hh>
 #include <ignition/math/Pose3.hh>
-#include <ignition/math/Rand.hh>
 #include <ignition/plugin/Register.hh>
 #include <ignition/transport/Node.hh>
 #include <sdf/sdf.hh>
 
+#include "ignition/gazebo/components/Collision.hh"
+#include "ignition/gazebo/components/Geometry.hh"
 #include "ignition/gazebo/components/Model.hh"
+#include "ignition/gazebo/components/Name.hh"
 #include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/components/Static.hh"
 #include "ignition/gazebo/Util.hh"
 
+#include "CounterRng.hh"
+#include "GeometryMesh.hh"
+#include "LinkBudget.hh"
+#include "OcclusionGrid.hh"
 #include "RFRange.hh"
+#include "SpatialGrid.hh"
+#include "StaggeredSchedule.hh"
 
 using namespace ignition;
 using namespace gazebo;
@@ -205,6 +223,42 @@ class gazebo::systems::RFRangePrivate
 
     /// \brief An Ignition Transport publisher.
     public: transport::Node::Publisher pub;
+
+    /// \brief Index of the model in the peer table of the compact output.
+    public: uint32_t id = 0;
+
+    /// \brief Key of the random streams, from the name.
+    public: uint64_t key = 0;
+
+    /// \brief Attempts and drops of the links from this sensor since the
+    /// diagnostics were last published, by receiver key.
+    public: std::unordered_map<uint64_t, std::pair<uint64_t, uint64_t>>
+        linkStats;
+  };
+
+  /// \brief Diagnostics accumulated since they were last published.
+  public: struct Diagnostics
+  {
+    /// \brief Number of updates that evaluated links.
+    public: uint64_t updates = 0;
+
+    /// \brief Number of non-paused steps.
+    public: uint64_t steps = 0;
+
+    /// \brief Number of links evaluated.
+    public: uint64_t pairsEvaluated = 0;
+
+    /// \brief Number of links culled beyond max range.
+    public: uint64_t pairsCulled = 0;
+
+    /// \brief Number of bytes of the published readings and peer tables.
+    public: uint64_t bytesPublished = 0;
+
+    /// \brief Wall time spent in PreUpdate.
+    public: std::chrono::steady_clock::duration updateTime{0};
+
+    /// \brief Longest wall time of a PreUpdate.
+    public: std::chrono::steady_clock::duration maxUpdateTime{0};
   };
 
   /// \brief Configure the sensor via SDF.
@@ -246,14 +300,41 @@ class gazebo::systems::RFRangePrivate
   /// limitations). This probability is then used to determine if the
   /// packet is successfully communicated.
   ///
-  /// \param[in out] _txPos Current position of the transmitter.
-  /// \param[in out] _rxPos Current position of the receiver.
+  /// \param[in] _txPos Current position of the transmitter.
+  /// \param[in] _rxPos Current position of the receiver.
   /// \param[in] _numBytes Size of the packet.
+  /// \param[in] _loss Extra loss of the link, such as obstructions (dB).
+  /// \param[in,out] _rng Random stream of the link.
   /// \return std::tuple<bool, double> reporting if the packet should be
   /// delivered and the received signal strength (in dBm).
-  public: std::tuple<bool, double> AttemptSend(math::Vector3d &_txPos,
-                                               math::Vector3d &_rxPos,
-                                               const uint64_t &_numBytes);
+  public: std::tuple<bool, double> AttemptSend(const math::Vector3d &_txPos,
+                                               const math::Vector3d &_rxPos,
+                                               const uint64_t &_numBytes,
+                                               double _loss,
+                                               mbzirc::CounterRng &_rng) const;
+
+  /// \brief Build the occlusion grid from the collisions of the static
+  /// models and of the listed occluder models.
+  /// \param[in] _ecm Entity Component Manager.
+  public: void BuildOcclusionGrid(const EntityComponentManager &_ecm);
+
+  /// \brief Set the link budget parameters from the configurations.
+  public: void ConfigureLinkBudget();
+
+  /// \brief Evaluate the links of a range of the transmitters to service
+  /// and fill their output messages.
+  /// \param[in] _begin First index in the transmitters to service.
+  /// \param[in] _end One past the last index.
+  /// \param[in] _simTime Current sim time.
+  public: void Evaluate(size_t _begin, size_t _end,
+                        const std::chrono::steady_clock::duration &_simTime);
+
+  /// \brief Account for the wall time of a step, and publish the
+  /// diagnostics when they are due.
+  /// \param[in] _start Wall time the step started.
+  /// \param[in] _simTime Current sim time.
+  public: void EndStep(const std::chrono::steady_clock::time_point &_start,
+                       const std::chrono::steady_clock::duration &_simTime);
 
   /// \brief Update the poses of all the registered RF sensors.
   /// \param[in] _ecm Entity Component Manager.
@@ -276,26 +357,117 @@ class gazebo::systems::RFRangePrivate
   /// \brief System update period calculated from <update_rate>.
   public: std::chrono::steady_clock::duration updatePeriod{0};
 
+  /// \brief Service sensor i of N at phase i / N of the update period
+  /// instead of all of them at once.
+  public: bool staggered = false;
+
+  /// \brief Transmitters to service in the current update, sorted.
+  public: std::vector<size_t> due;
+
   /// \brief The entity map associated to all the registered sensors in the
   /// world. The key is the entity of the model attached to a sensor. The value
   /// is a struct with fields such as pose, name, etc.
   public: std::map<gazebo::Entity, RFRangeData> entityMap;
 
+  /// \brief The sensors of the entity map, in the same order.
+  public: std::vector<RFRangeData *> sensors;
+
+  /// \brief Position of each sensor.
+  public: std::vector<math::Vector3d> positions;
+
+  /// \brief Index of the sensors within max range of each other.
+  public: mbzirc::SpatialGrid grid;
+
+  /// \brief Sensors within max range of each sensor due at this update.
+  /// Sorted by Evaluate.
+  public: std::vector<std::vector<size_t>> neighbors;
+
   /// \brief Range configuration.
   public: RangeConfiguration rangeConfig;
 
   /// \brief Radio configuration.
   public: RadioConfiguration radioConfig;
 
-  /// \brief Random device to seed random engine
-  public: std::random_device rd{};
+  /// \brief Batched link budget, from the configurations.
+  public: mbzirc::LinkBudget linkBudget;
+
+  /// \brief Evaluate each link with AttemptSend instead of the batched
+  /// link budget, to validate it.
+  public: bool exactLinkBudget = false;
+
+  /// \brief Whether obstructed links are attenuated.
+  public: bool occlusion = false;
+
+  /// \brief Whether the occlusion grid has been built.
+  public: bool occlusionBuilt = false;
+
+  /// \brief Cell size of the occlusion grid [m].
+  public: double occlusionCellSize = 2.0;
+
+  /// \brief Extra loss of obstructed links [dB].
+  public: double occlusionLoss = 20.0;
+
+  /// \brief Non-static models also used as occluders, at their initial
+  /// pose.
+  public: std::set<std::string> occluderModels;
 
-  /// \brief Random number generator.
-  public: std::default_random_engine rndEngine{rd()};
+  /// \brief Height grid of the occluders.
+  public: mbzirc::OcclusionGrid occlusionGrid;
+
+  /// \brief Seed of the random streams. Each link draws from its own
+  /// stream, keyed by the transmitter, the receiver and the sim time.
+  public: uint64_t seed = 0;
+
+  /// \brief Number of worker threads.
+  public: unsigned int threads{0};
+
+  /// \brief Worker threads, null to evaluate on the simulation thread.
+  public: std::unique_ptr<common::WorkerPool> pool;
+
+  /// \brief Param_V output of each transmitter.
+  public: std::vector<ignition::msgs::Param_V> outputs;
+
+  /// \brief Compact output of each transmitter.
+  public: std::vector<ignition::msgs::Double_V> compactOutputs;
 
   /// \brief True if RF configurations has been overriden
   public: bool rfConfigOverriden = false;
 
+  /// \brief Publish packed Double_V readings and a peer table instead of
+  /// Param_V readings.
+  public: bool compactOutput = false;
+
+  /// \brief Model names of the compact output, indexed by sensor id.
+  public: ignition::msgs::StringMsg_V peers;
+
+  /// \brief Publisher of the peer table.
+  public: transport::Node::Publisher peersPub;
+
+  /// \brief Whether the peer table changed since it was last published.
+  public: bool peersChanged = false;
+
+  /// \brief Sim time the peer table was last published.
+  public: std::chrono::steady_clock::duration lastPeersTime{0};
+
+  /// \brief Period to republish the peer table for late subscribers.
+  public: static constexpr std::chrono::seconds kPeersPeriod{10};
+
+  /// \brief Publisher of the diagnostics.
+  public: transport::Node::Publisher diagnosticsPub;
+
+  /// \brief Period of the diagnostics, zero to disable them.
+  public: std::chrono::steady_clock::duration diagnosticsPeriod{0};
+
+  /// \brief Sim time the diagnostics were last published.
+  public: std::chrono::steady_clock::duration lastDiagnosticsTime{0};
+
+  /// \brief Diagnostics since they were last published.
+  public: Diagnostics diagnostics;
+
+  /// \brief Topic of the diagnostics.
+  public: static constexpr char kDiagnosticsTopic[] =
+      "/mbzirc/diagnostics/rf_range";
+
   /// \brief The size in bytes of the request sent between sensors.
   public: static constexpr uint64_t kPayloadSize = 100;
 };
@@ -341,6 +513,23 @@ void RFRangePrivate::Load(std::shared_ptr<const sdf::Element> _sdf)
 
   igndbg << "RFRange sensor radio configuration:" << std::endl
          << this->radioConfig << std::endl;
+
+  this->ConfigureLinkBudget();
+}
+
+//////////////////////////////////////////////////
+void RFRangePrivate::ConfigureLinkBudget()
+{
+  mbzirc::LinkBudget::Params params;
+  params.maxRange = this->rangeConfig.maxRange;
+  params.fadingExponent = this->rangeConfig.fadingExponent;
+  params.l0 = this->rangeConfig.l0;
+  params.sigma = this->rangeConfig.sigma;
+  params.rssi1 = this->rangeConfig.rssi1;
+  params.txPower = this->radioConfig.txPower;
+  params.noiseFloor = this->radioConfig.noiseFloor;
+  params.numBytes = kPayloadSize;
+  this->linkBudget.Configure(params);
 }
 
 /////////////////////////////////////////////
@@ -381,17 +570,19 @@ double RFRangePrivate::RSSIToRange(double _rssi) const
 
 /////////////////////////////////////////////
 std::tuple<bool, double> RFRangePrivate::AttemptSend(
-  math::Vector3d &_txPos, math::Vector3d &_rxPos, const uint64_t &_numBytes)
+  const math::Vector3d &_txPos, const math::Vector3d &_rxPos,
+  const uint64_t &_numBytes, double _loss, mbzirc::CounterRng &_rng) const
 {
   // Get the received power based on TX power and position of each node.
   auto rxPowerDist =
     this->LogNormalReceivedPower(this->radioConfig.txPower, _txPos, _rxPos);
+  rxPowerDist.mean -= _loss;
 
   double rxPower = rxPowerDist.mean;
   if (rxPowerDist.variance > 0.0)
   {
-    std::normal_distribution<> d{rxPowerDist.mean, sqrt(rxPowerDist.variance)};
-    rxPower = d(this->rndEngine);
+    rxPower = rxPowerDist.mean +
+      sqrt(rxPowerDist.variance) * _rng.Normal(0.0, 1.0);
   }
 
   // Based on rx_power, and noise value, compute the bit error rate (BER).
@@ -406,7 +597,7 @@ std::tuple<bool, double> RFRangePrivate::AttemptSend(
   //           "# Bytes: " << _numBytes << "\n" <<
   //           "PER: " << packetDropProb << std::endl;
 
-  double randDraw = ignition::math::Rand::DblUniform();
+  double randDraw = _rng.Uniform();
   bool packetReceived = randDraw > packetDropProb;
 
   if (!packetReceived)
@@ -415,6 +606,220 @@ std::tuple<bool, double> RFRangePrivate::AttemptSend(
   return std::make_tuple(true, rxPower);
 }
 
+//////////////////////////////////////////////////
+void RFRangePrivate::Evaluate(size_t _begin, size_t _end,
+    const std::chrono::steady_clock::duration &_simTime)
+{
+  const uint64_t tick = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      _simTime).count();
+  const bool fading = this->linkBudget.Stddev() > 0.0;
+  mbzirc::LinkBudget::Batch batch;
+
+  for (size_t k = _begin; k < _end; ++k)
+  {
+    const size_t from = this->due[k];
+    auto &dataFrom = *this->sensors[from];
+    auto &outputMsg = this->outputs[from];
+    auto &compactMsg = this->compactOutputs[from];
+    outputMsg.Clear();
+    compactMsg.Clear();
+
+    // Receivers in the order of the entity map.
+    auto &to = this->neighbors[from];
+    std::sort(to.begin(), to.end());
+
+    // Draw the links in the same order as AttemptSend, so both give the
+    // same readings up to the accuracy of the batched link budget.
+    batch.Resize(to.size());
+    for (size_t i = 0; i < to.size(); ++i)
+    {
+      mbzirc::CounterRng rng(this->seed, dataFrom.key,
+          this->sensors[to[i]]->key, tick);
+      const double loss = this->occlusion &&
+          !this->occlusionGrid.LineOfSight(this->positions[from],
+          this->positions[to[i]]) ? this->occlusionLoss : 0.0;
+      if (this->exactLinkBudget)
+      {
+        auto [sendPacket, rssi] = this->AttemptSend(this->positions[from],
+            this->positions[to[i]], this->kPayloadSize, loss, rng);
+        batch.received[i] = sendPacket;
+        batch.rssi[i] = rssi;
+        batch.range[i] = sendPacket ? this->RSSIToRange(rssi) : 0.0;
+        continue;
+      }
+      batch.rxPos[i] = this->positions[to[i]];
+      batch.loss[i] = loss;
+      batch.fading[i] = fading ? rng.Normal(0.0, 1.0) : 0.0;
+      batch.draw[i] = rng.Uniform();
+    }
+    if (!this->exactLinkBudget)
+      this->linkBudget.Evaluate(this->positions[from], batch);
+
+    // Only this thread evaluates the links from this sensor.
+    if (this->diagnosticsPeriod.count() > 0)
+    {
+      for (size_t i = 0; i < to.size(); ++i)
+      {
+        auto &stats = dataFrom.linkStats[this->sensors[to[i]]->key];
+        ++stats.first;
+        stats.second += !batch.received[i];
+      }
+    }
+
+    for (size_t i = 0; i < to.size(); ++i)
+    {
+      if (!batch.received[i])
+        continue;
+
+      const auto &dataTo = *this->sensors[to[i]];
+      const double rssi = batch.rssi[i];
+      const double range = batch.range[i];
+
+      // Peer id, range and rssi of each reading.
+      if (this->compactOutput)
+      {
+        compactMsg.add_data(dataTo.id);
+        compactMsg.add_data(range);
+        compactMsg.add_data(rssi);
+        continue;
+      }
+
+      auto *param = outputMsg.add_param()->mutable_params();
+
+      ignition::msgs::Any modelValue;
+      modelValue.set_type(ignition::msgs::Any_ValueType::Any_ValueType_STRING);
+      modelValue.set_string_value(dataTo.name);
+
+      // Set the model field.
+      (*param)["model"] = modelValue;
+
+      ignition::msgs::Any rangeValue;
+      rangeValue.set_type(ignition::msgs::Any_ValueType::Any_ValueType_DOUBLE);
+      rangeValue.set_double_value(range);
+
+      // Set the playback field.
+      (*param)["range"] = rangeValue;
+
+      ignition::msgs::Any rssiValue;
+      rssiValue.set_type(ignition::msgs::Any_ValueType::Any_ValueType_DOUBLE);
+      rssiValue.set_double_value(rssi);
+
+      // Set the playback field.
+      (*param)["rssi"] = rssiValue;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void RFRangePrivate::BuildOcclusionGrid(const EntityComponentManager &_ecm)
+{
+  std::vector<math::Vector3d> vertices;
+  std::vector<uint32_t> indices;
+  _ecm.Each<components::Collision, components::Geometry>(
+    [&](const Entity &_entity, const components::Collision *,
+        const components::Geometry *_geometry) -> bool
+    {
+      const Entity model = topLevelModel(_entity, _ecm);
+      auto isStatic = _ecm.Component<components::Static>(model);
+      auto name = _ecm.Component<components::Name>(model);
+      if (!(isStatic && isStatic->Data()) &&
+          !(name && this->occluderModels.count(name->Data())))
+      {
+        return true;
+      }
+
+      mbzirc::AppendGeometryTriangles(_geometry->Data(),
+          worldPose(_entity, _ecm), vertices, indices);
+      return true;
+    });
+
+  this->occlusionGrid.Build(vertices, indices, this->occlusionCellSize);
+  this->occlusionBuilt = true;
+  igndbg << "RFRange occlusion grid: " << indices.size() / 3
+         << " triangles, " << this->occlusionGrid.CellCount() << " cells of "
+         << this->occlusionGrid.CellSize() << " m" << std::endl;
+}
+
+//////////////////////////////////////////////////
+void RFRangePrivate::EndStep(
+    const std::chrono::steady_clock::time_point &_start,
+    const std::chrono::steady_clock::duration &_simTime)
+{
+  if (this->diagnosticsPeriod.count() <= 0)
+    return;
+
+  auto &diag = this->diagnostics;
+  const auto wallTime = std::chrono::steady_clock::now() - _start;
+  ++diag.steps;
+  diag.updateTime += wallTime;
+  diag.maxUpdateTime = std::max(diag.maxUpdateTime, wallTime);
+
+  auto elapsed = _simTime - this->lastDiagnosticsTime;
+  if (elapsed > std::chrono::steady_clock::duration::zero() &&
+      elapsed < this->diagnosticsPeriod)
+  {
+    return;
+  }
+  this->lastDiagnosticsTime = _simTime;
+
+  msgs::Param_V msg;
+  auto stamp = math::durationToSecNsec(_simTime);
+  msg.mutable_header()->mutable_stamp()->set_sec(stamp.first);
+  msg.mutable_header()->mutable_stamp()->set_nsec(stamp.second);
+  auto *params = msg.add_param()->mutable_params();
+  auto setInt = [params](const std::string &_key, uint64_t _value)
+  {
+    auto &value = (*params)[_key];
+    value.set_type(msgs::Any_ValueType::Any_ValueType_INT32);
+    value.set_int_value(static_cast<int32_t>(std::min<uint64_t>(_value,
+        std::numeric_limits<int32_t>::max())));
+  };
+  auto setDouble = [params](const std::string &_key, double _value)
+  {
+    auto &value = (*params)[_key];
+    value.set_type(msgs::Any_ValueType::Any_ValueType_DOUBLE);
+    value.set_double_value(_value);
+  };
+
+  // Drop rate of each link, keyed by the model names.
+  std::unordered_map<uint64_t, const std::string *> names;
+  for (const auto &[entity, data] : this->entityMap)
+    names[data.key] = &data.name;
+  uint64_t attempts = 0;
+  uint64_t drops = 0;
+  for (auto &[entity, data] : this->entityMap)
+  {
+    for (const auto &[key, stats] : data.linkStats)
+    {
+      attempts += stats.first;
+      drops += stats.second;
+      auto name = names.find(key);
+      if (name == names.end() || stats.first == 0)
+        continue;
+      setDouble("drop_rate/" + data.name + "/" + *name->second,
+          static_cast<double>(stats.second) / stats.first);
+    }
+    data.linkStats.clear();
+  }
+
+  using Seconds = std::chrono::duration<double>;
+  setInt("sensors", this->entityMap.size());
+  setInt("updates", diag.updates);
+  setInt("pairs_evaluated", diag.pairsEvaluated);
+  setInt("pairs_culled", diag.pairsCulled);
+  setDouble("drop_rate", attempts ? static_cast<double>(drops) / attempts :
+      0.0);
+  setDouble("update_time_mean",
+      std::chrono::duration_cast<Seconds>(diag.updateTime).count() /
+      diag.steps);
+  setDouble("update_time_max",
+      std::chrono::duration_cast<Seconds>(diag.maxUpdateTime).count());
+  setInt("bytes_published", diag.bytesPublished);
+  this->diagnosticsPub.Publish(msg);
+
+  diag = Diagnostics();
+}
+
 //////////////////////////////////////////////////
 void RFRangePrivate::UpdateSensorPoses(gazebo::EntityComponentManager &_ecm)
 {
@@ -432,6 +837,14 @@ void RFRangePrivate::UpdateSensorPoses(gazebo::EntityComponentManager &_ecm)
 
     data.pose = modelPose->Data();
   }
+
+  this->sensors.clear();
+  this->positions.clear();
+  for (auto &[entityId, data] : this->entityMap)
+  {
+    this->sensors.push_back(&data);
+    this->positions.push_back(data.pose.Pos());
+  }
 }
 
 //////////////////////////////////////////////////
@@ -464,6 +877,75 @@ void RFRange::Configure(const Entity &_entity,
   std::chrono::duration<double> period{rate > 0 ? 1 / rate : 0};
   this->dataPtr->updatePeriod =
       std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+
+  // Random streams. Without a seed, every run differs.
+  if (_sdf->HasElement("seed"))
+  {
+    this->dataPtr->seed = _sdf->Get<uint64_t>("seed");
+  }
+  else
+  {
+    std::random_device rd;
+    this->dataPtr->seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+  }
+  ignmsg << "RFRange seed: " << this->dataPtr->seed << std::endl;
+
+  int threads = _sdf->Get<int>("threads", 0).first;
+  this->dataPtr->threads = static_cast<unsigned int>(std::max(threads, 0));
+  if (this->dataPtr->threads > 0)
+  {
+    this->dataPtr->pool =
+        std::make_unique<common::WorkerPool>(this->dataPtr->threads);
+  }
+
+  this->dataPtr->staggered = _sdf->Get<bool>("staggered", false).first;
+
+  double diagnosticsRate = _sdf->Get<double>("diagnostics_rate", 1).first;
+  if (diagnosticsRate > 0)
+  {
+    std::chrono::duration<double> diagnosticsPeriod{1 / diagnosticsRate};
+    this->dataPtr->diagnosticsPeriod =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        diagnosticsPeriod);
+    this->dataPtr->diagnosticsPub =
+        this->dataPtr->node.Advertise<msgs::Param_V>(
+        RFRangePrivate::kDiagnosticsTopic);
+  }
+
+  if (_sdf->HasElement("occlusion"))
+  {
+    auto elem = _sdf->Clone()->GetElement("occlusion");
+    this->dataPtr->occlusion = true;
+    this->dataPtr->occlusionCellSize = elem->Get<double>("cell_size",
+        this->dataPtr->occlusionCellSize).first;
+    this->dataPtr->occlusionLoss = elem->Get<double>("attenuation",
+        this->dataPtr->occlusionLoss).first;
+    for (auto model = elem->FindElement("model"); model;
+         model = model->GetNextElement("model"))
+    {
+      this->dataPtr->occluderModels.insert(model->Get<std::string>());
+    }
+  }
+
+  this->dataPtr->exactLinkBudget =
+      _sdf->Get<bool>("exact_link_budget", false).first;
+
+  this->dataPtr->compactOutput =
+      _sdf->Get<bool>("compact_output", false).first;
+  if (this->dataPtr->compactOutput)
+  {
+    auto worldName = _ecm.Component<components::Name>(_entity);
+    if (!worldName)
+    {
+      ignerr << "Unable to get the world name, disabling <compact_output>"
+             << std::endl;
+      this->dataPtr->compactOutput = false;
+      return;
+    }
+    this->dataPtr->peersPub =
+        this->dataPtr->node.Advertise<msgs::StringMsg_V>(
+        "/world/" + worldName->Data() + "/rfsensor/peers");
+  }
 }
 
 //////////////////////////////////////////////////
@@ -488,9 +970,21 @@ void RFRange::PreUpdate(
         // Keep track of this sensor.
         RFRangePrivate::RFRangeData rfRangeData;
         rfRangeData.name = this->dataPtr->RemoveAllScope(modelName, "/");
+        rfRangeData.key = mbzirc::CounterRng::Key(rfRangeData.name);
         rfRangeData.pose = math::Pose3d::Zero;
-        rfRangeData.pub = this->dataPtr->node.Advertise<msgs::Param_V>(
-          sensorName + "/rfsensor");
+        if (this->dataPtr->compactOutput)
+        {
+          rfRangeData.id = this->dataPtr->peers.data_size();
+          this->dataPtr->peers.add_data(rfRangeData.name);
+          this->dataPtr->peersChanged = true;
+          rfRangeData.pub = this->dataPtr->node.Advertise<msgs::Double_V>(
+            sensorName + "/rfsensor/compact");
+        }
+        else
+        {
+          rfRangeData.pub = this->dataPtr->node.Advertise<msgs::Param_V>(
+            sensorName + "/rfsensor");
+        }
 
         // We store the ID of the robot model.
         this->dataPtr->entityMap[modelId] = rfRangeData;
@@ -514,6 +1008,7 @@ void RFRange::PreUpdate(
           }
           if (this->dataPtr->rfConfigOverriden)
           {
+            this->dataPtr->ConfigureLinkBudget();
             igndbg << "RFRange sensor range configuration override:" << std::endl
                    << this->dataPtr->rangeConfig << std::endl;
             igndbg << "RFRange sensor radio configuration override:" << std::endl
@@ -524,72 +1019,140 @@ void RFRange::PreUpdate(
         return true;
       });
 
+  // The occluders are loaded with the world, build their grid once.
+  if (this->dataPtr->occlusion && !this->dataPtr->occlusionBuilt)
+    this->dataPtr->BuildOcclusionGrid(_ecm);
+
   if (_info.paused)
     return;
 
+  const auto start = std::chrono::steady_clock::now();
+
   // Update the poses of all detected RF sensors.
   this->dataPtr->UpdateSensorPoses(_ecm);
 
-  // Throttle update rate.
-  auto elapsed = _info.simTime - this->dataPtr->lastUpdateTime;
-  if (elapsed > std::chrono::steady_clock::duration::zero() &&
-      elapsed < this->dataPtr->updatePeriod)
+  auto &d = *this->dataPtr;
+  const size_t count = d.sensors.size();
+  d.due.clear();
+  auto elapsed = _info.simTime - d.lastUpdateTime;
+  if (d.staggered && d.updatePeriod.count() > 0 && count > 0)
   {
-    return;
+    // Sensor i of N is serviced at phase i / N of the update period.
+    mbzirc::StaggeredDue(d.lastUpdateTime.count(), _info.simTime.count(),
+        d.updatePeriod.count(), count, d.due);
   }
-  this->dataPtr->lastUpdateTime = _info.simTime;
-
-  for (auto &[from, dataFrom] : this->dataPtr->entityMap)
+  else
   {
-    ignition::msgs::Param_V outputMsg;
-
-    for (auto &[to, dataTo] : this->dataPtr->entityMap)
+    // Throttle update rate.
+    if (elapsed > std::chrono::steady_clock::duration::zero() &&
+        elapsed < d.updatePeriod)
     {
-      if (from == to)
-        continue;
+      d.EndStep(start, _info.simTime);
+      return;
+    }
+    for (size_t i = 0; i < count; ++i)
+      d.due.push_back(i);
+  }
+  d.lastUpdateTime = _info.simTime;
 
-      auto [sendPacket, rssi] = this->dataPtr->AttemptSend(
-        dataFrom.pose.Pos(), dataTo.pose.Pos(), this->dataPtr->kPayloadSize);
+  // Only evaluate the sensors someone listens to.
+  d.due.erase(std::remove_if(d.due.begin(), d.due.end(), [&d](size_t _i)
+      {
+        return !d.sensors[_i]->pub.HasConnections();
+      }), d.due.end());
 
-      if (!sendPacket)
-        continue;
+  if (d.due.empty())
+  {
+    d.EndStep(start, _info.simTime);
+    return;
+  }
 
-      auto *param = outputMsg.add_param()->mutable_params();
+  // Only the pairs within max range can communicate. Evaluate sorts the
+  // receivers on the worker threads.
+  d.grid.Build(d.positions, d.rangeConfig.maxRange);
+  auto &neighbors = d.neighbors;
+  neighbors.resize(count);
+  for (size_t from : d.due)
+  {
+    auto &to = neighbors[from];
+    to.clear();
+    d.grid.ForEachNeighbor(from, [&to](size_t _j) { to.push_back(_j); });
+  }
 
-      ignition::msgs::Any modelValue;
-      modelValue.set_type(ignition::msgs::Any_ValueType::Any_ValueType_STRING);
-      modelValue.set_string_value(dataTo.name);
+  ++d.diagnostics.updates;
+  for (size_t from : d.due)
+  {
+    d.diagnostics.pairsEvaluated += neighbors[from].size();
+    d.diagnostics.pairsCulled += count - 1 - neighbors[from].size();
+  }
 
-      // Set the model field.
-      (*param)["model"] = modelValue;
+  auto stamp = math::durationToSecNsec(_info.simTime);
 
-      double range = this->dataPtr->RSSIToRange(rssi);
-      ignition::msgs::Any rangeValue;
-      rangeValue.set_type(ignition::msgs::Any_ValueType::Any_ValueType_DOUBLE);
-      rangeValue.set_double_value(range);
+  // The peer table of the compact output, republished now and then since
+  // the transport does not keep it for late subscribers.
+  if (this->dataPtr->compactOutput && (this->dataPtr->peersChanged ||
+      _info.simTime - this->dataPtr->lastPeersTime >=
+      RFRangePrivate::kPeersPeriod))
+  {
+    auto &peers = this->dataPtr->peers;
+    peers.mutable_header()->mutable_stamp()->set_sec(stamp.first);
+    peers.mutable_header()->mutable_stamp()->set_nsec(stamp.second);
+    this->dataPtr->peersPub.Publish(peers);
+    d.diagnostics.bytesPublished += peers.ByteSizeLong();
+    this->dataPtr->peersChanged = false;
+    this->dataPtr->lastPeersTime = _info.simTime;
+  }
 
-      // Set the playback field.
-      (*param)["range"] = rangeValue;
+  // Evaluate the links, one contiguous range of transmitters per thread.
+  // Each link draws from its own stream, so the results do not depend on
+  // the number of threads.
+  d.outputs.resize(count);
+  d.compactOutputs.resize(count);
+  const auto simTime = _info.simTime;
+  const size_t dueCount = d.due.size();
+  if (!d.pool || dueCount < 2)
+  {
+    d.Evaluate(0, dueCount, simTime);
+  }
+  else
+  {
+    const size_t chunk = (dueCount + d.threads - 1) / d.threads;
+    for (size_t begin = 0; begin < dueCount; begin += chunk)
+    {
+      const size_t end = std::min(dueCount, begin + chunk);
+      d.pool->AddWork([&d, begin, end, simTime]()
+          {
+            d.Evaluate(begin, end, simTime);
+          });
+    }
+    d.pool->WaitForResults();
+  }
 
-      ignition::msgs::Any rssiValue;
-      rssiValue.set_type(ignition::msgs::Any_ValueType::Any_ValueType_DOUBLE);
-      rssiValue.set_double_value(rssi);
+  // Publish output, in the order of the entity map.
+  for (size_t from : d.due)
+  {
+    auto &compactMsg = d.compactOutputs[from];
+    auto &outputMsg = d.outputs[from];
+    if (compactMsg.data_size() > 0)
+    {
+      compactMsg.mutable_header()->mutable_stamp()->set_sec(stamp.first);
+      compactMsg.mutable_header()->mutable_stamp()->set_nsec(stamp.second);
 
-      // Set the playback field.
-      (*param)["rssi"] = rssiValue;
+      d.sensors[from]->pub.Publish(compactMsg);
+      d.diagnostics.bytesPublished += compactMsg.ByteSizeLong();
     }
-
-    // Publish output.
-    if (outputMsg.param_size() > 0)
+    else if (outputMsg.param_size() > 0)
     {
       // Header.
-      auto stamp = math::durationToSecNsec(_info.simTime);
       outputMsg.mutable_header()->mutable_stamp()->set_sec(stamp.first);
       outputMsg.mutable_header()->mutable_stamp()->set_nsec(stamp.second);
 
-      dataFrom.pub.Publish(outputMsg);
+      d.sensors[from]->pub.Publish(outputMsg);
+      d.diagnostics.bytesPublished += outputMsg.ByteSizeLong();
     }
   }
+
+  d.EndStep(start, _info.simTime);
 }
 
 IGNITION_ADD_PLUGIN(RFRange,
@@ -74,6 +74,23 @@ namespace systems
   ///
   /// * Optional parameters:
   /// <update_rate> Sensor update rate (Hz).
+  /// <staggered> If true, the N sensors are updated in turn instead of all
+  ///             at once, sensor i at phase i / N of the update period, so
+  ///             the cost of each step is flat. Each sensor keeps the
+  ///             update rate. Default is false.
+  ///
+  /// Only the sensors with subscribers are evaluated and published.
+  ///
+  /// <diagnostics_rate> Rate (Hz) of the diagnostics published as an
+  ///                    ignition::msgs::Param_V on
+  ///                    /mbzirc/diagnostics/rf_range, 0 to disable them.
+  ///                    Each message covers the steps since the previous
+  ///                    one: sensors, updates, pairs_evaluated,
+  ///                    pairs_culled (beyond max range), drop_rate,
+  ///                    update_time_mean and update_time_max (wall time of
+  ///                    PreUpdate, s), bytes_published, and the drop rate
+  ///                    of each link as drop_rate/<from model>/<to model>.
+  ///                    Default is 1.
   /// <range_config> Element used to capture the range configuration based on a
   ///                log-normal distribution. This block can contain any of the
   ///                next parameters:
@@ -93,6 +110,39 @@ namespace systems
   ///    * <tx_power>: Transmitter power in dBm. Default is 27dBm (500mW).
   ///    * <noise_floor>: Noise floor in dBm.  Default is -90dBm.
   ///
+  /// <occlusion> If present, links without line of sight are attenuated.
+  ///             The line of sight is tested against a height grid of the
+  ///             collisions of the static models, built at the first
+  ///             update. This block can contain any of the next parameters:
+  ///    * <cell_size>: Cell size of the height grid (meters). Default is 2.
+  ///    * <attenuation>: Extra loss of obstructed links (dB).
+  ///                     Default is 20.
+  ///    * <model>: Name of a non-static model to include in the grid at its
+  ///               pose at the first update. The grid is not rebuilt, so
+  ///               the model must not move. Can be repeated.
+  ///
+  /// <seed> Seed of the random draws. Each link draws from its own stream,
+  ///        keyed by the seed, the model names and the sim time, so runs
+  ///        with the same seed give the same readings. Default is a random
+  ///        seed, which is logged.
+  /// <threads> Number of worker threads evaluating the links, 0 to evaluate
+  ///           them on the simulation thread. The readings do not depend on
+  ///           the number of threads. Default is 0.
+  /// <exact_link_budget> If true, each link is evaluated with the exact
+  ///                     model instead of the batched link budget, whose
+  ///                     packet error rate is tabulated with an absolute
+  ///                     error below 1e-4. Used for validation.
+  ///                     Default is false.
+  /// <compact_output> If true, each sensor publishes its readings as an
+  ///                  ignition::msgs::Double_V on <sensor>/rfsensor/compact
+  ///                  instead of an ignition::msgs::Param_V on
+  ///                  <sensor>/rfsensor. The data holds a
+  ///                  (peer id, range, rssi) triplet per reading, and the
+  ///                  peer ids index the model names of the
+  ///                  ignition::msgs::StringMsg_V published on
+  ///                  /world/<world>/rfsensor/peers when a sensor is added
+  ///                  and every 10 s. Default is false.
+  ///
   /// Here's an example:
   /// <plugin
   ///   filename="libRFRange.so"
@@ -15,8 +15,8 @@
  *
  */
 
+#include <chrono>
 #include <string>
-#include <Eigen/Eigen>
 #include <ignition/common/Profiler.hh>
 #include <ignition/math/Vector3.hh>
 #include <ignition/plugin/Register.hh>
@@ -24,9 +24,12 @@
 
 #include "ignition/gazebo/Link.hh"
 #include "ignition/gazebo/Model.hh"
+#include "ignition/gazebo/Util.hh"
 
 #include "Components.hh"
+#include "HydrodynamicsKernel.hh"
 #include "SimpleHydrodynamics.hh"
+#include "WrenchThrottle.hh"
 
 using namespace ignition;
 using namespace gazebo;
@@ -40,63 +43,22 @@ class ignition::gazebo::systems::SimpleHydrodynamicsPrivate
   /// \brief Model interface.
   public: Model model{kNullEntity};
 
-  /// \brief Added mass in surge, X_\dot{u}.
-  public: double paramXdotU{0.0};
+  /// \brief Hydrodynamic parameters, also published on the link for the
+  /// MarineDynamics system.
+  public: mbzirc::HydrodynamicsParameters params;
 
-  /// \brief Added mass in sway, Y_\dot{v}.
-  public: double paramYdotV{0.0};
+  /// \brief The world entity.
+  public: Entity world{kNullEntity};
 
-  /// \brief Added mass in heave, Z_\dot{w}.
-  public: double paramZdotW{0.0};
+  /// \brief Runs the loads below the physics rate.
+  public: mbzirc::WrenchThrottle throttle;
 
-  /// \brief Added mass in roll, K_\dot{p}.
-  public: double paramKdotP{0.0};
+  /// \brief Added mass and drag model, see
+  /// https://en.wikipedia.org/wiki/Added_mass
+  public: mbzirc::HydrodynamicsKernel<double> kernel;
 
-  /// \brief Added mass in pitch, M_\dot{q}.
-  public: double paramMdotQ{0.0};
-
-  /// \brief Added mass in yaw, N_\dot{r}.
-  public: double paramNdotR{0.0};
-
-  /// \brief Linear drag in surge.
-  public: double paramXu{0.0};
-
-  /// \brief Quadratic drag in surge.
-  public: double paramXuu{0.0};
-
-  /// \brief Linear drag in sway.
-  public: double paramYv{0.0};
-
-  /// \brief Quadratic drag in sway.
-  public: double paramYvv{0.0};
-
-  /// \brief Linear drag in heave.
-  public: double paramZw{0.0};
-
-  /// \brief Quadratic drag in heave.
-  public: double paramZww{0.0};
-
-  /// \brief Linear drag in roll.
-  public: double paramKp{0.0};
-
-  /// \brief Quadratic drag in roll.
-  public: double paramKpp{0.0};
-
-  /// \brief Linear drag in pitch.
-  public: double paramMq{0.0};
-
-  /// \brief Quadratic drag in pitch.
-  public: double paramMqq{0.0};
-
-  /// \brief Linear drag in yaw.
-  public: double paramNr{0.0};
-
-  /// \brief Quadratic drag in yaw.
-  public: double paramNrr{0.0};
-
-  /// \brief Added mass of vehicle.
-  /// See: https://en.wikipedia.org/wiki/Added_mass
-  public: Eigen::MatrixXd Ma;
+  /// \brief Smooths the acceleration of the added mass term.
+  public: mbzirc::AccelerationFilter<double> accelerationFilter;
 };
 
 
@@ -135,56 +97,77 @@ void SimpleHydrodynamics::Configure(const Entity &_entity,
   this->dataPtr->link.EnableVelocityChecks(_ecm);
   this->dataPtr->link.EnableAccelerationChecks(_ecm);
 
-  this->dataPtr->paramXdotU       = _sdf->Get<double>("xDotU", 5  ).first;
-  this->dataPtr->paramYdotV       = _sdf->Get<double>("yDotV", 5  ).first;
-  this->dataPtr->paramZdotW       = _sdf->Get<double>("zDotW", 0.1).first;
-  this->dataPtr->paramKdotP       = _sdf->Get<double>("kDotP", 0.1).first;
-  this->dataPtr->paramMdotQ       = _sdf->Get<double>("mDotQ", 0.1).first;
-  this->dataPtr->paramNdotR       = _sdf->Get<double>("nDotR", 1  ).first;
-  this->dataPtr->paramXu          = _sdf->Get<double>("xU",   20  ).first;
-  this->dataPtr->paramXuu         = _sdf->Get<double>("xUU",   0  ).first;
-  this->dataPtr->paramYv          = _sdf->Get<double>("yV",   20  ).first;
-  this->dataPtr->paramYvv         = _sdf->Get<double>("yVV",   0  ).first;
-  this->dataPtr->paramZw          = _sdf->Get<double>("zW",   20  ).first;
-  this->dataPtr->paramZww         = _sdf->Get<double>("zWW",   0  ).first;
-  this->dataPtr->paramKp          = _sdf->Get<double>("kP",   20  ).first;
-  this->dataPtr->paramKpp         = _sdf->Get<double>("kPP",   0  ).first;
-  this->dataPtr->paramMq          = _sdf->Get<double>("mQ",   20  ).first;
-  this->dataPtr->paramMqq         = _sdf->Get<double>("mQQ",   0  ).first;
-  this->dataPtr->paramNr          = _sdf->Get<double>("nR",   20  ).first;
-  this->dataPtr->paramNrr         = _sdf->Get<double>("nRR",   0  ).first;
-
-  // Added mass according to Fossen's equations (p 37).
-  this->dataPtr->Ma = Eigen::MatrixXd::Zero(6, 6);
-
-  this->dataPtr->Ma(0, 0) = this->dataPtr->paramXdotU;
-  this->dataPtr->Ma(1, 1) = this->dataPtr->paramYdotV;
-  this->dataPtr->Ma(2, 2) = this->dataPtr->paramZdotW;
-  this->dataPtr->Ma(3, 3) = this->dataPtr->paramKdotP;
-  this->dataPtr->Ma(4, 4) = this->dataPtr->paramMdotQ;
-  this->dataPtr->Ma(5, 5) = this->dataPtr->paramNdotR;
+  auto &params = this->dataPtr->params;
+  params.xDotU = _sdf->Get<double>("xDotU", 5  ).first;
+  params.yDotV = _sdf->Get<double>("yDotV", 5  ).first;
+  params.zDotW = _sdf->Get<double>("zDotW", 0.1).first;
+  params.kDotP = _sdf->Get<double>("kDotP", 0.1).first;
+  params.mDotQ = _sdf->Get<double>("mDotQ", 0.1).first;
+  params.nDotR = _sdf->Get<double>("nDotR", 1  ).first;
+  params.xU    = _sdf->Get<double>("xU",   20  ).first;
+  params.xUU   = _sdf->Get<double>("xUU",   0  ).first;
+  params.yV    = _sdf->Get<double>("yV",   20  ).first;
+  params.yVV   = _sdf->Get<double>("yVV",   0  ).first;
+  params.zW    = _sdf->Get<double>("zW",   20  ).first;
+  params.zWW   = _sdf->Get<double>("zWW",   0  ).first;
+  params.kP    = _sdf->Get<double>("kP",   20  ).first;
+  params.kPP   = _sdf->Get<double>("kPP",   0  ).first;
+  params.mQ    = _sdf->Get<double>("mQ",   20  ).first;
+  params.mQQ   = _sdf->Get<double>("mQQ",   0  ).first;
+  params.nR    = _sdf->Get<double>("nR",   20  ).first;
+  params.nRR   = _sdf->Get<double>("nRR",   0  ).first;
+  params.accelerationCutoff =
+      _sdf->Get<double>("acceleration_cutoff", 0).first;
+
+  // Added mass and drag according to Fossen's equations (p 37).
+  this->dataPtr->kernel.SetParameters(params);
+  this->dataPtr->accelerationFilter.SetCutoff(params.accelerationCutoff);
+
+  // Sub-rate updates.
+  const double updateRate = _sdf->Get<double>("update_rate", 0).first;
+  const std::string updateHold = _sdf->Get<std::string>("update_hold",
+      "hold").first;
+  if (updateHold != "hold" && updateHold != "linear")
+  {
+    ignerr << "Unknown <update_hold> [" << updateHold << "], using [hold]"
+           << std::endl;
+  }
+  this->dataPtr->throttle.Configure(updateRate, updateHold == "linear",
+      _sdf->Get<bool>("update_error_check", false).first);
+
+  // Let the MarineDynamics system take over the vessel, it runs at the full
+  // rate.
+  this->dataPtr->world = worldEntity(_ecm);
+  if (!this->dataPtr->throttle.Enabled())
+  {
+    _ecm.CreateComponent(this->dataPtr->link.Entity(),
+        mbzirc::components::HydrodynamicsParameters(params));
+  }
 
   igndbg << "SimpleHydrodynamics plugin successfully configured with the "
-         << "following parameters:"                        << std::endl;
-  igndbg << "  <link_name>: " << linkName                  << std::endl;
-  igndbg << "  <xDotU>: "     << this->dataPtr->paramXdotU << std::endl;
-  igndbg << "  <yDotV>: "     << this->dataPtr->paramYdotV << std::endl;
-  igndbg << "  <zDotW>: "     << this->dataPtr->paramZdotW << std::endl;
-  igndbg << "  <kDotP>: "     << this->dataPtr->paramKdotP << std::endl;
-  igndbg << "  <mDotQ>: "     << this->dataPtr->paramMdotQ << std::endl;
-  igndbg << "  <nDotR>: "     << this->dataPtr->paramNdotR << std::endl;
-  igndbg << "  <xU>: "        << this->dataPtr->paramXu    << std::endl;
-  igndbg << "  <xUU>: "       << this->dataPtr->paramXuu   << std::endl;
-  igndbg << "  <yV>: "        << this->dataPtr->paramYv    << std::endl;
-  igndbg << "  <yVV>: "       << this->dataPtr->paramYvv   << std::endl;
-  igndbg << "  <zW>: "        << this->dataPtr->paramZw    << std::endl;
-  igndbg << "  <zWW>: "       << this->dataPtr->paramZww   << std::endl;
-  igndbg << "  <kP>: "        << this->dataPtr->paramKp    << std::endl;
-  igndbg << "  <kPP>: "       << this->dataPtr->paramKpp   << std::endl;
-  igndbg << "  <mQ>: "        << this->dataPtr->paramMq    << std::endl;
-  igndbg << "  <mQQ>: "       << this->dataPtr->paramMqq   << std::endl;
-  igndbg << "  <nR>: "        << this->dataPtr->paramNr    << std::endl;
-  igndbg << "  <nRR>: "       << this->dataPtr->paramNrr   << std::endl;
+         << "following parameters:"           << std::endl;
+  igndbg << "  <link_name>: " << linkName     << std::endl;
+  igndbg << "  <xDotU>: "     << params.xDotU << std::endl;
+  igndbg << "  <yDotV>: "     << params.yDotV << std::endl;
+  igndbg << "  <zDotW>: "     << params.zDotW << std::endl;
+  igndbg << "  <kDotP>: "     << params.kDotP << std::endl;
+  igndbg << "  <mDotQ>: "     << params.mDotQ << std::endl;
+  igndbg << "  <nDotR>: "     << params.nDotR << std::endl;
+  igndbg << "  <xU>: "        << params.xU    << std::endl;
+  igndbg << "  <xUU>: "       << params.xUU   << std::endl;
+  igndbg << "  <yV>: "        << params.yV    << std::endl;
+  igndbg << "  <yVV>: "       << params.yVV   << std::endl;
+  igndbg << "  <zW>: "        << params.zW    << std::endl;
+  igndbg << "  <zWW>: "       << params.zWW   << std::endl;
+  igndbg << "  <kP>: "        << params.kP    << std::endl;
+  igndbg << "  <kPP>: "       << params.kPP   << std::endl;
+  igndbg << "  <mQ>: "        << params.mQ    << std::endl;
+  igndbg << "  <mQQ>: "       << params.mQQ   << std::endl;
+  igndbg << "  <nR>: "        << params.nR    << std::endl;
+  igndbg << "  <nRR>: "       << params.nRR   << std::endl;
+  igndbg << "  <acceleration_cutoff>: " << params.accelerationCutoff
+         << std::endl;
+  igndbg << "  <update_rate>: " << updateRate << std::endl;
 }
 
 //////////////////////////////////////////////////
@@ -200,10 +183,34 @@ void SimpleHydrodynamics::PreUpdate(
   if (!this->dataPtr->link.Valid(_ecm))
     return;
 
-  Eigen::VectorXd stateDot = Eigen::VectorXd(6);
-  Eigen::VectorXd state    = Eigen::VectorXd(6);
-  Eigen::MatrixXd Cmat     = Eigen::MatrixXd::Zero(6, 6);
-  Eigen::MatrixXd Dmat     = Eigen::MatrixXd::Zero(6, 6);
+  // Parked vessels ride the waves kinematically, see Surface.
+  if (_ecm.Component<mbzirc::components::Parked>(
+      this->dataPtr->link.Entity()))
+  {
+    return;
+  }
+
+  // The MarineDynamics system applies the hydrodynamic loads.
+  auto &throttle = this->dataPtr->throttle;
+  if (!throttle.Enabled() &&
+      _ecm.Component<mbzirc::components::MarineDynamics>(this->dataPtr->world))
+  {
+    return;
+  }
+
+  // Between sub-rate updates, reapply the last loads.
+  if (!throttle.NeedsUpdate(_info.simTime))
+  {
+    ignition::math::Vector3d force;
+    ignition::math::Vector3d torque;
+    throttle.Hold(_info.simTime, force, torque);
+    this->dataPtr->link.AddWorldWrench(_ecm, force, torque);
+    return;
+  }
+
+  using Vector6 = mbzirc::HydrodynamicsKernel<double>::Vector6;
+  Vector6 stateDot;
+  Vector6 state;
 
   // Get vehicle state.
   auto worldAngularVel = this->dataPtr->link.WorldAngularVelocity(_ecm);
@@ -246,36 +253,15 @@ void SimpleHydrodynamics::PreUpdate(
   stateDot << localLinearAccel.X(), localLinearAccel.Y(), localLinearAccel.Z(),
    localAngularAccel.X(), localAngularAccel.Y(), localAngularAccel.Z();
 
+  stateDot = this->dataPtr->accelerationFilter.Update(stateDot,
+      std::chrono::duration<double>(_info.simTime).count());
+
   state << localLinearVel.X(), localLinearVel.Y(), localLinearVel.Z(),
     localAngularVel.X(), localAngularVel.Y(), localAngularVel.Z();
 
-  // Added Mass.
-  const Eigen::VectorXd kAmassVec = -1.0 * this->dataPtr->Ma * stateDot;
-
-  // Coriolis - added mass components.
-  Cmat(0, 5) = this->dataPtr->paramYdotV * localLinearVel.Y();
-  Cmat(1, 5) = this->dataPtr->paramXdotU * localLinearVel.X();
-  Cmat(5, 0) = this->dataPtr->paramYdotV * localLinearVel.Y();
-  Cmat(5, 1) = this->dataPtr->paramXdotU * localLinearVel.X();
-
-  // Drag.
-  Dmat(0, 0) = this->dataPtr->paramXu +
-    this->dataPtr->paramXuu * std::abs(localLinearVel.X());
-  Dmat(1, 1) = this->dataPtr->paramYv +
-    this->dataPtr->paramYvv * std::abs(localLinearVel.Y());
-  Dmat(2, 2) = this->dataPtr->paramZw +
-    this->dataPtr->paramZww * std::abs(localLinearVel.Z());
-  Dmat(3, 3) = this->dataPtr->paramKp +
-    this->dataPtr->paramKpp * std::abs(localAngularVel.X());
-  Dmat(4, 4) = this->dataPtr->paramMq +
-    this->dataPtr->paramMqq * std::abs(localAngularVel.Y());
-  Dmat(5, 5) = this->dataPtr->paramNr +
-    this->dataPtr->paramNrr * std::abs(localAngularVel.Z());
-
-  const Eigen::VectorXd kDvec = -1.0 * Dmat * state;
-
-  // Sum all forces - in body frame.
-  const Eigen::VectorXd kForceSum = kAmassVec + kDvec;
+  // Added mass and drag, summed in the body frame. The added mass Coriolis
+  // loads are not applied.
+  const Vector6 kForceSum = this->dataPtr->kernel.Force(state, stateDot);
 
   // Transform the force and torque to the world frame.
   ignition::math::Vector3d forceWorld = (*comPose).Rot().RotateVector(
@@ -283,6 +269,15 @@ void SimpleHydrodynamics::PreUpdate(
   ignition::math::Vector3d torqueWorld = (*comPose).Rot().RotateVector(
     ignition::math::Vector3d(kForceSum(3), kForceSum(4), kForceSum(5)));
 
+  throttle.Filter(_info.simTime, forceWorld, torqueWorld);
+  if (auto error = throttle.TakeError(_info.simTime, std::chrono::seconds(10)))
+  {
+    ignmsg << "SimpleHydrodynamics loads of link ["
+           << this->dataPtr->link.Entity()
+           << "] held at <update_rate>, error against the full rate: "
+           << *error << std::endl;
+  }
+
   // Apply the force and torque at COM.
   this->dataPtr->link.AddWorldWrench(_ecm, forceWorld, torqueWorld);
 }
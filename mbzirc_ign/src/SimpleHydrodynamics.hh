@@ -42,6 +42,11 @@ namespace systems
   /// forces like linear and quadratic drag, buoyancy (not provided by this
   /// plugin), etc.
   ///
+  /// The parameters are published as a HydrodynamicsParameters component on
+  /// the link. If the world loads the MarineDynamics system, it applies the
+  /// hydrodynamic loads instead and this system stays passive, unless
+  /// `<update_rate>` is set.
+  ///
   /// ## Required system parameters
   ///
   ///  * <link_name> - The link of the model that is being subject to
@@ -70,6 +75,22 @@ namespace systems
   ///  * <mQ>    - Stability derivative, 1st order, pitch component [kg/m]
   ///  * <nRR>   - Stability derivative, 2nd order, yaw component [kg/m^2]
   ///  * <nR>    - Stability derivative, 1st order, yaw component [kg/m]
+  ///  * <acceleration_cutoff> - Cutoff frequency of a first order low-pass
+  ///     filter on the body frame acceleration of the added mass term [Hz].
+  ///     Smoothing the noisy acceleration from the physics keeps large added
+  ///     masses stable at larger step sizes. Defaults to 0, unfiltered.
+  ///
+  /// The loads can be computed below the physics rate. The drag is then a
+  /// delayed damping term, so keep the rate well above the vessel's motion
+  /// frequencies.
+  ///
+  ///  * <update_rate> - Rate of the load computation [Hz], 0 (default) for
+  ///     every step. The last wrench is reapplied in between.
+  ///  * <update_hold> - "hold" (default) to reapply the last wrench or
+  ///     "linear" to extrapolate it from the last two updates.
+  ///  * <update_error_check> - Still compute the loads every step to report
+  ///     the error of the held wrench every 10 s of sim time. Defaults to
+  ///     false.
   ///
   /// # Example
   /// <plugin
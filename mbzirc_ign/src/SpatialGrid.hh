@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef MBZIRC_IGN__SPATIALGRID_HH_
+#define MBZIRC_IGN__SPATIALGRID_HH_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+namespace mbzirc
+{
+/// \brief Uniform grid over a set of points, used to enumerate the pairs of
+/// points closer than a range without testing every pair.
+///
+/// The cells are as large as the range, so the neighbours of a point are in
+/// its own cell or in one of the 26 adjacent cells. The points are sorted by
+/// cell, and each cell is found by binary search, so a rebuild allocates
+/// only when the number of points grows. The points must stay within 2^20
+/// cells of the origin.
+class SpatialGrid
+{
+  /// \brief Rebuild the grid.
+  /// \param[in] _points The points.
+  /// \param[in] _range Pair range [m], 0 or less to pair every point.
+  public: void Build(const std::vector<ignition::math::Vector3d> &_points,
+                     double _range)
+  {
+    this->points = &_points;
+    this->range = _range;
+    this->cells.clear();
+    if (_range <= 0.0)
+      return;
+
+    for (size_t i = 0; i < _points.size(); ++i)
+    {
+      this->cells.push_back({this->Key(this->Cell(_points[i].X()),
+          this->Cell(_points[i].Y()), this->Cell(_points[i].Z())), i});
+    }
+    std::sort(this->cells.begin(), this->cells.end());
+  }
+
+  /// \brief Call a function for every pair of points within the range,
+  /// once per pair.
+  /// \param[in] _f Function called with the indices i < j of the points.
+  public: template <typename F>
+          void ForEachPair(F _f) const
+  {
+    if (!this->points)
+      return;
+    const auto &pts = *this->points;
+
+    if (this->range <= 0.0)
+    {
+      for (size_t i = 0; i < pts.size(); ++i)
+      {
+        for (size_t j = i + 1; j < pts.size(); ++j)
+          _f(i, j);
+      }
+      return;
+    }
+
+    const double rangeSquared = this->range * this->range;
+    auto visit = [&](size_t _i, size_t _j)
+    {
+      if ((pts[_i] - pts[_j]).SquaredLength() <= rangeSquared)
+        _f(std::min(_i, _j), std::max(_i, _j));
+    };
+
+    for (auto begin = this->cells.begin(); begin != this->cells.end();)
+    {
+      const uint64_t key = begin->first;
+      auto end = std::upper_bound(begin, this->cells.end(),
+          Entry{key, SIZE_MAX});
+
+      // Pairs within the cell.
+      for (auto a = begin; a != end; ++a)
+      {
+        for (auto b = a + 1; b != end; ++b)
+          visit(a->second, b->second);
+      }
+
+      // Pairs with the adjacent cells of larger key, so each pair of cells
+      // is visited once.
+      const auto &p = pts[begin->second];
+      const int64_t cx = this->Cell(p.X());
+      const int64_t cy = this->Cell(p.Y());
+      const int64_t cz = this->Cell(p.Z());
+      for (int64_t dx = -1; dx <= 1; ++dx)
+      {
+        for (int64_t dy = -1; dy <= 1; ++dy)
+        {
+          for (int64_t dz = -1; dz <= 1; ++dz)
+          {
+            const uint64_t other = this->Key(cx + dx, cy + dy, cz + dz);
+            if (other <= key)
+              continue;
+            auto first = std::lower_bound(end, this->cells.end(),
+                Entry{other, 0});
+            for (auto b = first; b != this->cells.end() && b->first == other;
+                 ++b)
+            {
+              for (auto a = begin; a != end; ++a)
+                visit(a->second, b->second);
+            }
+          }
+        }
+      }
+      begin = end;
+    }
+  }
+
+  /// \brief Call a function for every point within the range of a point.
+  /// \param[in] _i Index of the point.
+  /// \param[in] _f Function called with the index j != _i of each point,
+  /// in cell order.
+  public: template <typename F>
+          void ForEachNeighbor(size_t _i, F _f) const
+  {
+    if (!this->points)
+      return;
+    const auto &pts = *this->points;
+
+    if (this->range <= 0.0)
+    {
+      for (size_t j = 0; j < pts.size(); ++j)
+      {
+        if (j != _i)
+          _f(j);
+      }
+      return;
+    }
+
+    const double rangeSquared = this->range * this->range;
+    const auto &p = pts[_i];
+    const int64_t cx = this->Cell(p.X());
+    const int64_t cy = this->Cell(p.Y());
+    const int64_t cz = this->Cell(p.Z());
+    for (int64_t dx = -1; dx <= 1; ++dx)
+    {
+      for (int64_t dy = -1; dy <= 1; ++dy)
+      {
+        for (int64_t dz = -1; dz <= 1; ++dz)
+        {
+          const uint64_t key = this->Key(cx + dx, cy + dy, cz + dz);
+          auto first = std::lower_bound(this->cells.begin(),
+              this->cells.end(), Entry{key, 0});
+          for (auto b = first; b != this->cells.end() && b->first == key; ++b)
+          {
+            if (b->second != _i &&
+                (pts[b->second] - p).SquaredLength() <= rangeSquared)
+            {
+              _f(b->second);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  /// \brief Cell index of a coordinate.
+  /// \param[in] _x Coordinate [m].
+  /// \return The cell index.
+  private: int64_t Cell(double _x) const
+  {
+    return static_cast<int64_t>(std::floor(_x / this->range));
+  }
+
+  /// \brief Sortable key of a cell, 21 bits per axis, so the points must be
+  /// within 2^20 cells of the origin.
+  /// \param[in] _x Cell index along x.
+  /// \param[in] _y Cell index along y.
+  /// \param[in] _z Cell index along z.
+  /// \return The key.
+  private: static uint64_t Key(int64_t _x, int64_t _y, int64_t _z)
+  {
+    constexpr int64_t kOffset = int64_t{1} << 20;
+    constexpr uint64_t kMask = (uint64_t{1} << 21) - 1;
+    return ((static_cast<uint64_t>(_x + kOffset) & kMask) << 42) |
+        ((static_cast<uint64_t>(_y + kOffset) & kMask) << 21) |
+        (static_cast<uint64_t>(_z + kOffset) & kMask);
+  }
+
+  /// \brief Cell key and point index.
+  private: using Entry = std::pair<uint64_t, size_t>;
+
+  /// \brief The points, sorted by cell.
+  private: std::vector<Entry> cells;
+
+  /// \brief The points of the last build.
+  private: const std::vector<ignition::math::Vector3d> *points = nullptr;
+
+  /// \brief Pair range [m].
+  private: double range = 0.0;
+};
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__SPATIALGRID_HH_
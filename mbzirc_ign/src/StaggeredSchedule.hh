@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef MBZIRC_IGN__STAGGEREDSCHEDULE_HH_
+#define MBZIRC_IGN__STAGGEREDSCHEDULE_HH_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace mbzirc
+{
+/// \brief Items due at an update of a staggered schedule.
+///
+/// Item i of N is serviced at phase i / N of the update period, so each
+/// update does about the same work and each item keeps the update rate.
+/// The period is split into N slots, slot s starting at s * period / N,
+/// and an update services the slots that started since the previous one.
+/// If time did not advance, e.g. at the first update or after a reset, only
+/// the slots that started during the last nanosecond are serviced. If N
+/// changes, the slots are mapped to the new items from then on.
+/// \param[in] _last Time of the previous update [ns].
+/// \param[in] _now Time of this update [ns].
+/// \param[in] _period Update period [ns], greater than 0.
+/// \param[in] _count Number of items N.
+/// \param[out] _due Indices of the items due, ascending. Appended to.
+inline void StaggeredDue(int64_t _last, int64_t _now, int64_t _period,
+    size_t _count, std::vector<size_t> &_due)
+{
+  if (_count == 0 || _period <= 0)
+    return;
+
+  const int64_t n = static_cast<int64_t>(_count);
+  const int64_t last = _last < _now ? _last : _now - 1;
+  // Slot of time t is floor(t * n / period); division truncates towards
+  // zero, so negative times are mapped to slot 0.
+  const int64_t first = last < 0 ? 0 : last * n / _period + 1;
+  const int64_t end = _now < 0 ? 0 : _now * n / _period + 1;
+  if (end - first >= n)
+  {
+    for (size_t i = 0; i < _count; ++i)
+      _due.push_back(i);
+    return;
+  }
+
+  const size_t size = _due.size();
+  for (int64_t slot = first; slot < end; ++slot)
+    _due.push_back(static_cast<size_t>(slot % n));
+  std::sort(_due.begin() + size, _due.end());
+}
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__STAGGEREDSCHEDULE_HH_
@@ -15,24 +15,40 @@
  *
  */
 #include <ignition/msgs/wrench.pb.h>
+#include <algorithm>
 #include <chrono>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <string>
+#include <unordered_set>
+#include <vector>
 #include <ignition/common/Profiler.hh>
 #include <ignition/common/Time.hh>
+#include <ignition/math/Helpers.hh>
 #include <ignition/math/Pose3.hh>
 #include <ignition/math/Vector3.hh>
 #include <ignition/plugin/Register.hh>
 #include <sdf/sdf.hh>
 
+#include "ignition/gazebo/components/AngularVelocityCmd.hh"
+#include "ignition/gazebo/components/Geometry.hh"
 #include "ignition/gazebo/components/Inertial.hh"
+#include "ignition/gazebo/components/LinearVelocityCmd.hh"
+#include "ignition/gazebo/components/Name.hh"
 #include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/components/Sensor.hh"
 #include "ignition/gazebo/Link.hh"
 #include "ignition/gazebo/Model.hh"
 #include "ignition/gazebo/Util.hh"
 #include "ignition/gazebo/World.hh"
 
+#include "Components.hh"
+#include "GeometryMesh.hh"
+#include "HullMesh.hh"
 #include "Surface.hh"
 #include "Wavefield.hh"
+#include "WrenchThrottle.hh"
 
 using namespace ignition;
 using namespace gazebo;
@@ -46,29 +62,318 @@ class ignition::gazebo::systems::SurfacePrivate
   /// \brief Model interface
   public: Model model{kNullEntity};
 
-  /// \brief Vessel length [m].
-  public: double vehicleLength = 4.9;
+  /// \brief Buoyancy parameters, also published on the link for the
+  /// MarineDynamics system.
+  public: mbzirc::SurfaceParameters params;
 
-  /// \brief Vessel width [m].
-  public: double vehicleWidth = 2.4;
+  /// \brief Whether the MarineDynamics system can take over this vessel.
+  public: bool shared = false;
 
-  /// \brief Demi-hull radius [m].
-  public: double hullRadius = 0.213;
+  /// \brief The world entity.
+  public: Entity world{kNullEntity};
 
-  /// \brief Length discretization, i.e., "N"
-  public: int numSamples = 2;
+  /// \brief The world's gravity [m/s^2].
+  public: ignition::math::Vector3d gravity;
 
-  /// \brief Fluid height [m].
-  public: double fluidLevel = 0;
+  /// \brief The wavefield, shared with the other plugins of the world.
+  public: std::shared_ptr<Wavefield> wavefield;
 
-  /// \brief Fluid density [kg/m^3].
-  public: double fluidDensity = 997.7735;
+  /// \brief Whether the wave components are truncated to an error budget.
+  public: bool lod = false;
 
-  /// \brief The world's gravity [m/s^2].
-  public: ignition::math::Vector3d gravity;
+  /// \brief Fixed error budget [m], negative to derive it from the distance
+  /// to the nearest competitor.
+  public: double lodError = -1.0;
+
+  /// \brief Budget growth with distance to the nearest competitor [m/m].
+  public: double lodErrorPerMeter = 0.0;
+
+  /// \brief Smallest distance based budget [m].
+  public: double lodMinError = 0.0;
+
+  /// \brief Largest distance based budget [m], also used when there is no
+  /// competitor.
+  public: double lodMaxError = std::numeric_limits<double>::infinity();
+
+  /// \brief Competitor models, i.e. top level models carrying sensors.
+  public: std::unordered_set<Entity> competitors;
+
+  /// \brief Sim time of the last competitor scan.
+  public: std::optional<std::chrono::steady_clock::duration> lastScanTime;
+
+  /// \brief Update the list of competitors. Platforms are spawned while the
+  /// simulation runs, so this is repeated every second.
+  /// \param[in] _ecm The entity component manager.
+  /// \param[in] _simTime The current sim time.
+  public: void ScanCompetitors(const EntityComponentManager &_ecm,
+                               const std::chrono::steady_clock::duration
+                               &_simTime)
+  {
+    if (this->lastScanTime &&
+        _simTime - *this->lastScanTime < std::chrono::seconds(1))
+    {
+      return;
+    }
+    this->lastScanTime = _simTime;
+
+    this->competitors.clear();
+    _ecm.Each<components::Sensor>(
+        [&](const Entity &_entity, const components::Sensor *) -> bool
+        {
+          Entity top = topLevelModel(_entity, _ecm);
+          if (top != kNullEntity && top != this->model.Entity())
+            this->competitors.insert(top);
+          return true;
+        });
+  }
+
+  /// \brief Error budget for the current step.
+  /// \param[in] _ecm The entity component manager.
+  /// \param[in] _position Position of the vessel.
+  /// \return The budget [m].
+  public: double LodBudget(const EntityComponentManager &_ecm,
+                           const ignition::math::Vector3d &_position)
+  {
+    if (this->lodError >= 0.0)
+      return this->lodError;
+
+    double distance = std::numeric_limits<double>::infinity();
+    for (const auto &competitor : this->competitors)
+    {
+      auto pose = _ecm.Component<components::Pose>(competitor);
+      if (pose)
+        distance = std::min(distance, pose->Data().Pos().Distance(_position));
+    }
+    return std::clamp(this->lodErrorPerMeter * distance, this->lodMinError,
+        this->lodMaxError);
+  }
+
+  /// \brief Sample points in the link frame, one row of numSamples points
+  /// along each hull.
+  public: std::vector<ignition::math::Vector3d> samples;
+
+  /// \brief Sample points in the world frame, updated every step.
+  public: std::vector<ignition::math::Vector3d> points;
+
+  /// \brief Wave depth at each sample point, updated every step.
+  public: std::vector<double> depths;
+
+  /// \brief Warm started Gerstner solver, null when using the linear
+  /// approximation.
+  public: std::unique_ptr<WavefieldSolver> solver;
+
+  /// \brief Whether the buoyancy is integrated over the hull mesh instead
+  /// of the cylinder samples.
+  public: bool meshBuoyancy = false;
+
+  /// \brief Runs the buoyancy below the physics rate.
+  public: mbzirc::WrenchThrottle throttle;
+
+  /// \brief Decimated collision mesh of the link.
+  public: mbzirc::HullMesh hull;
+
+  /// \brief Height of the fluid surface above each hull vertex, updated
+  /// every step.
+  public: std::vector<double> surface;
+
+  /// \brief Load the collision geometry of the link into the hull mesh.
+  /// \param[in] _ecm The entity component manager.
+  /// \param[in] _collision Name of the collision to load, empty for all
+  /// of them.
+  /// \return True if any triangle was loaded.
+  public: bool LoadHull(const EntityComponentManager &_ecm,
+                        const std::string &_collision)
+  {
+    std::vector<ignition::math::Vector3d> vertices;
+    std::vector<uint32_t> indices;
+    for (const auto &collision : this->link.Collisions(_ecm))
+    {
+      auto name = _ecm.Component<components::Name>(collision);
+      if (!_collision.empty() && (!name || name->Data() != _collision))
+        continue;
+
+      auto geometry = _ecm.Component<components::Geometry>(collision);
+      auto pose = _ecm.Component<components::Pose>(collision);
+      if (!geometry || !pose)
+        continue;
+
+      if (!mbzirc::AppendGeometryTriangles(geometry->Data(), pose->Data(),
+          vertices, indices))
+      {
+        ignwarn << "Skipping the geometry of collision [" << collision
+                << "] for the buoyancy mesh" << std::endl;
+      }
+    }
+
+    this->hull.SetMesh(vertices, indices);
+    return this->hull.TriangleCount() > 0;
+  }
 
-  /// \brief The wavefield.
-  public: Wavefield wavefield;
+  /// \brief Distance to the nearest competitor beyond which the vessel is
+  /// parked [m], zero to never park.
+  public: double parkDistance = 0.0;
+
+  /// \brief Whether the vessel rode the waves at the last step.
+  public: bool parked = false;
+
+  /// \brief Fixed horizontal position and yaw of the parked vessel.
+  public: ignition::math::Vector3d parkAnchor;
+
+  /// \brief Offsets of the link's heave, roll and pitch from the wave
+  /// surface, taken when parking so that the ride starts where the vessel
+  /// was.
+  public: ignition::math::Vector3d parkOffset;
+
+  /// \brief Model world pose commanded at the last parked step.
+  public: std::optional<ignition::math::Pose3d> lastRidePose;
+
+  /// \brief Heave, roll and pitch of the wave surface under the vessel,
+  /// from the wave height at its bow, stern, port and starboard.
+  /// \param[in] _simTime Current sim time [s].
+  /// \return Heave [m], roll and pitch [rad].
+  public: ignition::math::Vector3d WaveAttitude(double _simTime)
+  {
+    const double x = this->parkAnchor.X();
+    const double y = this->parkAnchor.Y();
+    const double yaw = this->parkAnchor.Z();
+    const double halfLength = 0.5 * this->params.vehicleLength;
+    const double halfWidth = 0.5 * this->params.vehicleWidth;
+    const ignition::math::Vector3d forward(std::cos(yaw), std::sin(yaw), 0);
+    const ignition::math::Vector3d left(-std::sin(yaw), std::cos(yaw), 0);
+    const ignition::math::Vector3d center(x, y, 0);
+    this->points = {center + forward * halfLength,
+        center - forward * halfLength, center + left * halfWidth,
+        center - left * halfWidth};
+    this->wavefield->ComputeDepthBatch(this->points, _simTime, this->depths);
+    const double bow = this->depths[0];
+    const double stern = this->depths[1];
+    const double port = this->depths[2];
+    const double starboard = this->depths[3];
+    return ignition::math::Vector3d(
+        0.25 * (bow + stern + port + starboard),
+        std::atan2(port - starboard, 2.0 * halfWidth),
+        std::atan2(stern - bow, 2.0 * halfLength));
+  }
+
+  /// \brief Move the parked vessel with the wave surface, commanding the
+  /// model pose and the matching velocity so that the dynamics resume from
+  /// a consistent state when the vessel is unparked.
+  /// \param[in] _ecm The entity component manager.
+  /// \param[in] _info The update info.
+  public: void Ride(EntityComponentManager &_ecm, const UpdateInfo &_info)
+  {
+    const double simTime =
+        std::chrono::duration<double>(_info.simTime).count();
+    auto linkPose = this->link.WorldPose(_ecm);
+    auto linkInModel = _ecm.Component<components::Pose>(this->link.Entity());
+    if (!linkPose || !linkInModel)
+      return;
+
+    if (!this->parked)
+    {
+      const auto rot = linkPose->Rot();
+      this->parkAnchor.Set(linkPose->Pos().X(), linkPose->Pos().Y(),
+          rot.Yaw());
+      const auto wave = this->WaveAttitude(simTime);
+      this->parkOffset.Set(
+          linkPose->Pos().Z() - this->params.fluidLevel - wave.X(),
+          rot.Roll() - wave.Y(), rot.Pitch() - wave.Z());
+      this->lastRidePose.reset();
+      this->parked = true;
+      igndbg << "Parking vessel link [" << this->link.Entity() << "]"
+             << std::endl;
+    }
+
+    // Target link pose, then the model pose that puts the link there.
+    const auto wave = this->WaveAttitude(simTime);
+    const ignition::math::Quaterniond linkRot(
+        wave.Y() + this->parkOffset.Y(), wave.Z() + this->parkOffset.Z(),
+        this->parkAnchor.Z());
+    const ignition::math::Vector3d linkPos(this->parkAnchor.X(),
+        this->parkAnchor.Y(),
+        this->params.fluidLevel + wave.X() + this->parkOffset.X());
+    const auto modelRot = linkRot * linkInModel->Data().Rot().Inverse();
+    const ignition::math::Pose3d modelPose(
+        linkPos - modelRot * linkInModel->Data().Pos(), modelRot);
+    this->model.SetWorldPoseCmd(_ecm, modelPose);
+
+    // Velocity of the ride, in the model frame.
+    ignition::math::Vector3d linearVel(0, 0, 0);
+    ignition::math::Vector3d angularVel(0, 0, 0);
+    const double dt = std::chrono::duration<double>(_info.dt).count();
+    if (this->lastRidePose && dt > 0.0)
+    {
+      linearVel = (modelPose.Pos() - this->lastRidePose->Pos()) / dt;
+      ignition::math::Vector3d axis;
+      double angle;
+      (modelRot * this->lastRidePose->Rot().Inverse()).ToAxis(axis, angle);
+      if (angle > IGN_PI)
+        angle -= 2.0 * IGN_PI;
+      angularVel = axis * (angle / dt);
+    }
+    this->lastRidePose = modelPose;
+    _ecm.SetComponentData<components::LinearVelocityCmd>(
+        this->model.Entity(), modelRot.Inverse() * linearVel);
+    _ecm.SetComponentData<components::AngularVelocityCmd>(
+        this->model.Entity(), modelRot.Inverse() * angularVel);
+  }
+
+  /// \brief Hand the vessel back to the dynamics. The physics keeps the
+  /// last commanded ride velocity.
+  /// \param[in] _ecm The entity component manager.
+  public: void Unpark(EntityComponentManager &_ecm)
+  {
+    if (!this->parked)
+      return;
+    this->parked = false;
+    this->lastRidePose.reset();
+    _ecm.RemoveComponent<components::LinearVelocityCmd>(this->model.Entity());
+    _ecm.RemoveComponent<components::AngularVelocityCmd>(
+        this->model.Entity());
+    igndbg << "Unparking vessel link [" << this->link.Entity() << "]"
+           << std::endl;
+  }
+
+  /// \brief Compute the wave depth at every point.
+  /// \param[in] _ecm The entity component manager.
+  /// \param[in] _info The update info.
+  /// \param[in] _position Position of the vessel.
+  /// \param[in] _points Points in the world frame.
+  public: void ComputeDepths(const EntityComponentManager &_ecm,
+                             const UpdateInfo &_info,
+                             const ignition::math::Vector3d &_position,
+                             const std::vector<ignition::math::Vector3d>
+                             &_points)
+  {
+    const double simTime =
+        std::chrono::duration<double>(_info.simTime).count();
+    this->depths.resize(_points.size());
+    if (this->solver)
+    {
+      for (size_t s = 0; s < _points.size(); ++s)
+        this->depths[s] = this->solver->ComputeDepth(s, _points[s], simTime);
+    }
+    else if (this->lod)
+    {
+      // Error budget of the wave height for this step.
+      this->ScanCompetitors(_ecm, _info.simTime);
+      const double lodBudget = this->LodBudget(_ecm, _position);
+      for (size_t s = 0; s < _points.size(); ++s)
+      {
+        this->depths[s] = this->wavefield->ComputeDepthLod(_points[s],
+            lodBudget, simTime);
+      }
+    }
+    else if (this->wavefield->GridCacheEnabled())
+    {
+      for (size_t s = 0; s < _points.size(); ++s)
+        this->depths[s] = this->wavefield->ComputeDepth(_points[s], simTime);
+    }
+    else
+    {
+      this->wavefield->ComputeDepthBatch(_points, simTime, this->depths);
+    }
+  }
 };
 
 
@@ -102,42 +407,72 @@ void Surface::Configure(const Entity &_entity,
     return;
   }
 
-  // Required parameters.
-  if (!_sdf->HasElement("vehicle_length"))
+  // Required parameters, unless the buoyancy comes from the hull mesh.
+  auto &params = this->dataPtr->params;
+  this->dataPtr->meshBuoyancy = _sdf->HasElement("buoyancy_mesh");
+  if (this->dataPtr->meshBuoyancy)
   {
-    ignerr << "No <vehicle_length> specified" << std::endl;
-    return;
+    auto meshElem =
+        const_cast<sdf::Element *>(_sdf.get())->GetElement("buoyancy_mesh");
+    const std::string collision =
+        meshElem->Get<std::string>("collision", "").first;
+    const int maxTriangles = meshElem->Get<int>("max_triangles", 500).first;
+    if (!this->dataPtr->LoadHull(_ecm, collision))
+    {
+      ignerr << "No collision mesh found for <buoyancy_mesh> on link ["
+             << linkName << "]" << std::endl;
+      return;
+    }
+    const size_t loaded = this->dataPtr->hull.TriangleCount();
+    this->dataPtr->hull.Decimate(std::max(maxTriangles, 1));
+    igndbg << "Buoyancy mesh of link [" << linkName << "] decimated from "
+           << loaded << " to " << this->dataPtr->hull.TriangleCount()
+           << " triangles, volume " << this->dataPtr->hull.Volume()
+           << " m^3" << std::endl;
+
+    // The parked ride samples the waves at the ends of the hull.
+    const auto box = this->dataPtr->hull.BoundingBox();
+    params.vehicleLength = box.XLength();
+    params.vehicleWidth = box.YLength();
   }
-  this->dataPtr->vehicleLength = _sdf->Get<double>("vehicle_length");
-
-  if (!_sdf->HasElement("vehicle_width"))
+  else
   {
-    ignerr << "No <vehicle_width> specified" << std::endl;
-    return;
-  }
-  this->dataPtr->vehicleWidth = _sdf->Get<double>("vehicle_width");
+    if (!_sdf->HasElement("vehicle_length"))
+    {
+      ignerr << "No <vehicle_length> specified" << std::endl;
+      return;
+    }
+    params.vehicleLength = _sdf->Get<double>("vehicle_length");
 
-  if (!_sdf->HasElement("hull_radius"))
-  {
-    ignerr << "No <hull_radius> specified" << std::endl;
-    return;
+    if (!_sdf->HasElement("vehicle_width"))
+    {
+      ignerr << "No <vehicle_width> specified" << std::endl;
+      return;
+    }
+    params.vehicleWidth = _sdf->Get<double>("vehicle_width");
+
+    if (!_sdf->HasElement("hull_radius"))
+    {
+      ignerr << "No <hull_radius> specified" << std::endl;
+      return;
+    }
+    params.hullRadius = _sdf->Get<double>("hull_radius");
   }
-  this->dataPtr->hullRadius = _sdf->Get<double>("hull_radius");
 
   // Optional parameters.
   if (_sdf->HasElement("num_samples"))
   {
-    this->dataPtr->numSamples = _sdf->Get<int>("num_samples");
+    params.numSamples = _sdf->Get<int>("num_samples");
   }
 
   if (_sdf->HasElement("fluid_level"))
   {
-    this->dataPtr->fluidLevel = _sdf->Get<double>("fluid_level");
+    params.fluidLevel = _sdf->Get<double>("fluid_level");
   }
 
   if (_sdf->HasElement("fluid_density"))
   {
-    this->dataPtr->fluidDensity = _sdf->Get<double>("fluid_density");
+    params.fluidDensity = _sdf->Get<double>("fluid_density");
   }
 
   // Get the gravity from the world.
@@ -152,21 +487,95 @@ void Surface::Configure(const Entity &_entity,
   this->dataPtr->gravity = *gravityOpt;
 
   // Wavefield
-  this->dataPtr->wavefield.Load(_sdf);
+  this->dataPtr->wavefield = Wavefield::Acquire(worldEntity, _sdf);
+  this->dataPtr->world = worldEntity;
+  params.wavefield = Wavefield::Key(_sdf);
+
+  if (_sdf->HasElement("lod"))
+  {
+    auto lodElem = const_cast<sdf::Element *>(_sdf.get())->GetElement("lod");
+    this->dataPtr->lod = true;
+    this->dataPtr->lodError = lodElem->Get<double>("error",
+        this->dataPtr->lodError).first;
+    this->dataPtr->lodErrorPerMeter = lodElem->Get<double>("error_per_meter",
+        this->dataPtr->lodErrorPerMeter).first;
+    this->dataPtr->lodMinError = lodElem->Get<double>("min_error",
+        this->dataPtr->lodMinError).first;
+    this->dataPtr->lodMaxError = lodElem->Get<double>("max_error",
+        this->dataPtr->lodMaxError).first;
+  }
+
+  // Sample lattice in the link frame.
+  this->dataPtr->samples.clear();
+  if (!this->dataPtr->meshBuoyancy)
+    params.AppendSamples(this->dataPtr->samples);
+  const size_t pointCount = this->dataPtr->meshBuoyancy ?
+      this->dataPtr->hull.VertexCount() : this->dataPtr->samples.size();
+
+  std::string depthMethod = _sdf->Get<std::string>("depth_method",
+      "simple").first;
+  if (depthMethod == "direct")
+  {
+    this->dataPtr->solver = std::make_unique<WavefieldSolver>(
+        *this->dataPtr->wavefield, pointCount);
+    if (_sdf->HasElement("depth_tolerance"))
+    {
+      this->dataPtr->solver->SetTolerance(
+          _sdf->Get<double>("depth_tolerance"));
+    }
+  }
+  else if (depthMethod != "simple")
+  {
+    ignerr << "Unknown <depth_method> [" << depthMethod
+           << "], using [simple]" << std::endl;
+  }
+
+  // Sub-rate updates.
+  const double updateRate = _sdf->Get<double>("update_rate", 0).first;
+  const std::string updateHold = _sdf->Get<std::string>("update_hold",
+      "hold").first;
+  if (updateHold != "hold" && updateHold != "linear")
+  {
+    ignerr << "Unknown <update_hold> [" << updateHold << "], using [hold]"
+           << std::endl;
+  }
+  this->dataPtr->throttle.Configure(updateRate, updateHold == "linear",
+      _sdf->Get<bool>("update_error_check", false).first);
+
+  // Parking far from the competitors, decided by the GameLogicPlugin.
+  this->dataPtr->parkDistance = _sdf->Get<double>("park_distance", 0).first;
+  if (this->dataPtr->parkDistance > 0.0)
+  {
+    _ecm.CreateComponent(this->dataPtr->link.Entity(),
+        mbzirc::components::ParkDistance(this->dataPtr->parkDistance));
+  }
 
   // Create necessary components if not present.
   enableComponent<components::Inertial>(_ecm, this->dataPtr->link.Entity());
   enableComponent<components::WorldPose>(_ecm, this->dataPtr->link.Entity());
 
+  // Let the MarineDynamics system take over the vessel if it supports the
+  // configuration.
+  this->dataPtr->shared = !this->dataPtr->solver && !this->dataPtr->lod &&
+      !this->dataPtr->meshBuoyancy && !this->dataPtr->throttle.Enabled();
+  if (this->dataPtr->shared)
+  {
+    _ecm.CreateComponent(this->dataPtr->link.Entity(),
+        mbzirc::components::SurfaceParameters(params));
+  }
+
   igndbg << "Surface plugin successfully configured with the following "
          << "parameters:" << std::endl;
   igndbg << "  <link_name>: " << linkName << std::endl;
-  igndbg << "  <vehicle_length>: " << this->dataPtr->vehicleLength << std::endl;
-  igndbg << "  <vehicle_width>: " << this->dataPtr->vehicleWidth << std::endl;
-  igndbg << "  <hull_radius>: " << this->dataPtr->hullRadius << std::endl;
-  igndbg << "  <num_samples>: " << this->dataPtr->numSamples << std::endl;
-  igndbg << "  <fluid_level>: " << this->dataPtr->fluidLevel << std::endl;
-  igndbg << "  <fluid_density>: " << this->dataPtr->fluidDensity << std::endl;
+  igndbg << "  <buoyancy_mesh>: " << this->dataPtr->meshBuoyancy << std::endl;
+  igndbg << "  <vehicle_length>: " << params.vehicleLength << std::endl;
+  igndbg << "  <vehicle_width>: " << params.vehicleWidth << std::endl;
+  igndbg << "  <hull_radius>: " << params.hullRadius << std::endl;
+  igndbg << "  <num_samples>: " << params.numSamples << std::endl;
+  igndbg << "  <fluid_level>: " << params.fluidLevel << std::endl;
+  igndbg << "  <fluid_density>: " << params.fluidDensity << std::endl;
+  igndbg << "  <update_rate>: " << updateRate << std::endl;
+  igndbg << "  <park_distance>: " << this->dataPtr->parkDistance << std::endl;
 }
 
 //////////////////////////////////////////////////
@@ -175,105 +584,121 @@ void Surface::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
 {
   IGN_PROFILE("Surface::PreUpdate");
 
+  if (!this->dataPtr->wavefield)
+    return;
+
+  // Far from the competitors, ride the waves instead of simulating them.
+  if (this->dataPtr->parkDistance > 0.0)
+  {
+    if (_ecm.Component<mbzirc::components::Parked>(
+        this->dataPtr->link.Entity()))
+    {
+      this->dataPtr->wavefield->ApplyPendingUpdate();
+      if (!_info.paused)
+        this->dataPtr->Ride(_ecm, _info);
+      return;
+    }
+    this->dataPtr->Unpark(_ecm);
+  }
+
+  // The MarineDynamics system applies the buoyancy.
+  if (this->dataPtr->shared &&
+      _ecm.Component<mbzirc::components::MarineDynamics>(this->dataPtr->world))
+  {
+    return;
+  }
+
+  // Pick up sea state changes at the step boundary.
+  this->dataPtr->wavefield->ApplyPendingUpdate();
+
   if (_info.paused)
     return;
 
   // Vehicle frame transform
   const auto kPose = this->dataPtr->link.WorldPose(_ecm);
-  // std::optional<ignition::math::Pose3d> kPose;
-  // *kPose = {-532, 162, -0.008054, 0, 0, 1};
   if (!kPose)
   {
     ignerr << "Unable to get world pose from link ["
            << this->dataPtr->link.Entity() << "]" << std::endl;
     return;
   }
-  const ignition::math::Vector3d kEuler = (*kPose).Rot().Euler();
-  ignition::math::Quaternion vq(kEuler.X(), kEuler.Y(), kEuler.Z());
-
-  // Loop over boat grid points
-  // Grid point location in boat frame - might be able to precalculate these?
-  ignition::math::Vector3d bpnt(0, 0, 0);
-  // Grid point location in world frame
-  ignition::math::Vector3d bpntW(0, 0, 0);
-  // For each hull
-  // Debug output:
-  // igndbg << "===" << std::endl;
-  for (int i = 0; i < 2; ++i)
-  {
-    // Grid point in boat frame
-    bpnt.Set(bpnt.X(), (i * 2.0 - 1.0) * this->dataPtr->vehicleWidth / 2.0,
-      bpnt.Z());
-
-    // For each length segment
-    for (int j = 1; j <= this->dataPtr->numSamples; ++j)
-    {
-      bpnt.Set(((j - 0.5) / (static_cast<float>(this->dataPtr->numSamples)) -
-        0.5) * this->dataPtr->vehicleLength, bpnt.Y(), bpnt.Z());
 
-      // Transform from vessel to fluid/world frame.
-      bpntW = vq * bpnt;
-
-      // Vertical location of boat grid point in world frame.
-      const float kDdz = (*kPose).Pos().Z() + bpntW.Z();
-
-      // Find vertical displacement of wave field
-      // World location of grid point
-      ignition::math::Vector3d point;
-      point.X() = (*kPose).Pos().X() + bpntW.X();
-      point.Y() = (*kPose).Pos().Y() + bpntW.Y();
-
-      // Compute the depth at the grid point.
-      double simTime = std::chrono::duration<double>(_info.simTime).count();
-      double depth =
-        this->dataPtr->wavefield.ComputeDepthSimply(point, simTime);
+  const auto kInertialPose = this->dataPtr->link.WorldInertialPose(_ecm);
+  if (!kInertialPose)
+    return;
 
-      // Vertical wave displacement.
-      double dz = depth + point.Z();
+  // Between sub-rate updates, reapply the last buoyancy.
+  auto &throttle = this->dataPtr->throttle;
+  ignition::math::Vector3d force(0, 0, 0);
+  ignition::math::Vector3d torque(0, 0, 0);
+  if (!throttle.NeedsUpdate(_info.simTime))
+  {
+    throttle.Hold(_info.simTime, force, torque);
+    if (force != ignition::math::Vector3d::Zero)
+      this->dataPtr->link.AddWorldWrench(_ecm, force, torque);
+    return;
+  }
 
+  const auto &params = this->dataPtr->params;
+  if (this->dataPtr->meshBuoyancy)
+  {
+    // Hydrostatic pressure integrated over the submerged hull.
+    const auto &vertices = this->dataPtr->hull.Transform(*kPose);
+    this->dataPtr->ComputeDepths(_ecm, _info, kPose->Pos(), vertices);
+    auto &surface = this->dataPtr->surface;
+    surface.resize(vertices.size());
+    for (size_t v = 0; v < vertices.size(); ++v)
+      surface[v] = params.fluidLevel + this->dataPtr->depths[v];
+
+    this->dataPtr->hull.Integrate(surface, params.fluidDensity,
+        -this->dataPtr->gravity.Z(), kInertialPose->Pos(), force, torque);
+  }
+  else
+  {
+    // Sample points in the world frame.
+    const auto &samples = this->dataPtr->samples;
+    auto &points = this->dataPtr->points;
+    points.resize(samples.size());
+    for (size_t s = 0; s < samples.size(); ++s)
+      points[s] = kPose->Pos() + kPose->Rot() * samples[s];
+    this->dataPtr->ComputeDepths(_ecm, _info, kPose->Pos(), points);
+    const auto &depths = this->dataPtr->depths;
+
+    // The buoyancy forces are all vertical, so their sum applied at the
+    // force weighted mean of the sample points gives the same wrench as
+    // applying each of them at its sample point.
+    double buoyancy = 0.0;
+    ignition::math::Vector3d moment(0, 0, 0);
+    for (size_t s = 0; s < samples.size(); ++s)
+    {
       // Total z location of boat grid point relative to fluid surface
-      double deltaZ = (this->dataPtr->fluidLevel + dz) - kDdz;
-      // enforce only upward buoy force
-      deltaZ = std::max(deltaZ, 0.0);
-      deltaZ = std::min(deltaZ, this->dataPtr->hullRadius);
+      const double kDeltaZ = params.fluidLevel + depths[s] - points[s].Z();
 
       // Buoyancy force at grid point
-      const float kBuoyForce =
-        this->CircleSegment(this->dataPtr->hullRadius, deltaZ) *
-          this->dataPtr->vehicleLength /
-          (static_cast<float>(this->dataPtr->numSamples)) *
-          -this->dataPtr->gravity.Z() * this->dataPtr->fluidDensity;
-
-      // Apply force at grid point
-      // Position is in the link frame and force is in world frame.
-      this->dataPtr->link.AddWorldForce(_ecm,
-        ignition::math::Vector3d(0, 0, kBuoyForce),
-        bpnt);
-
-      // Debug output:
-      // igndbg << bpnt.X() << "," << bpnt.Y() << "," << bpnt.Z() << std::endl;
-      // igndbg << "-" << std::endl;
-      // igndbg << bpntW.X() << "," << bpntW.Y() << "," << bpntW.Z() << std::endl;
-      // igndbg << "X: " << X << std::endl;
-      // igndbg << "depth: " << depth << std::endl;
-      // igndbg << "dz: " << dz << std::endl;
-      // igndbg << "kDdz: " << kDdz << std::endl;
-      // igndbg << "deltaZ: " << deltaZ << std::endl;
-      // igndbg << "hull radius: " << this->dataPtr->hullRadius << std::endl;
-      // igndbg << "vehicle length: " << this->dataPtr->vehicleLength << std::endl;
-      // igndbg << "num samples: " << this->dataPtr->numSamples << std::endl;
-      // igndbg << "gravity z: " << -this->dataPtr->gravity.Z() << std::endl;
-      // igndbg << "fluid density: " << this->dataPtr->fluidDensity << std::endl;
-      // igndbg << "Force: " << kBuoyForce << std::endl << std::endl;
+      const double kBuoyForce =
+          params.SampleBuoyancy(kDeltaZ, -this->dataPtr->gravity.Z());
+      buoyancy += kBuoyForce;
+      moment += points[s] * kBuoyForce;
+    }
+
+    if (buoyancy > 0.0)
+    {
+      force.Set(0, 0, buoyancy);
+      torque = (moment / buoyancy - kInertialPose->Pos()).Cross(force);
     }
   }
-}
 
-//////////////////////////////////////////////////
-double Surface::CircleSegment(double _r, double _h) const
-{
-  return _r * _r * acos((_r -_h) / _r ) -
-    (_r - _h) * sqrt(2 * _r * _h - _h * _h);
+  throttle.Filter(_info.simTime, force, torque);
+  if (auto error = throttle.TakeError(_info.simTime, std::chrono::seconds(10)))
+  {
+    ignmsg << "Surface buoyancy of link [" << this->dataPtr->link.Entity()
+           << "] held at <update_rate>, error against the full rate: "
+           << *error << std::endl;
+  }
+
+  // Force and torque about the center of mass in the world frame.
+  if (force != ignition::math::Vector3d::Zero)
+    this->dataPtr->link.AddWorldWrench(_ecm, force, torque);
 }
 
 IGNITION_ADD_PLUGIN(Surface,
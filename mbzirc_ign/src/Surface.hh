@@ -34,7 +34,18 @@ namespace systems
 
   /// \brief A system that simulates the buoyancy of an object at the surface of
   /// a fluid. This system must be attached to a model and the system will apply
-  /// buoyancy to a few sample points around a given link.
+  /// buoyancy to a few sample points around a given link. The sample forces
+  /// are summed into a single force applied at the center of buoyancy.
+  ///
+  /// The parameters are published as a SurfaceParameters component on the
+  /// link. If the world loads the MarineDynamics system, it applies the
+  /// buoyancy instead and this system stays passive, except with the
+  /// "direct" `<depth_method>`, `<lod>`, `<buoyancy_mesh>` or `<update_rate>`.
+  ///
+  /// With `<buoyancy_mesh>`, the hull is the collision geometry of the link
+  /// instead of two cylinders. It is decimated to a triangle budget at load
+  /// time, and every step the hydrostatic pressure is integrated over the
+  /// triangles below the wave surface, clipped at the waterline.
   ///
   /// ## Required system parameters
   ///
@@ -43,11 +54,49 @@ namespace systems
   /// * `<vehicle_width>` is the width of the vessel [m].
   /// * `<hull_radius>` is the radius of the vessel's hull [m].
   ///
+  /// The last three are not used with `<buoyancy_mesh>`, the length and
+  /// width then come from the bounding box of the hull mesh.
+  ///
   /// ## Optional system parameters
   ///
   /// * `<num_samples>` is the number of samples where forces will be applied.
   /// * `<fluid_level>` is the depth at which the fluid should be in the vehicle
   /// * `<fluid_density>` is the density of the fluid.
+  /// * `<depth_method>` is "simple" (default) to use the linear wave height
+  /// or "direct" to solve for the Gerstner surface height with a warm
+  /// started Newton iteration per sample.
+  /// * `<depth_tolerance>` is the Newton tolerance [m] of the "direct"
+  /// method.
+  /// * `<lod>` truncates the wave components of the "simple" method to an
+  /// error budget on the wave height, largest components first:
+  ///   * `<error>` fixed budget [m].
+  ///   * `<error_per_meter>` budget per meter of distance to the nearest
+  ///   competitor platform, used if `<error>` is not set.
+  ///   * `<min_error>` and `<max_error>` clamp the distance based budget
+  ///   [m]. `<max_error>` also applies when there is no competitor and
+  ///   defaults to no limit.
+  /// * `<buoyancy_mesh>` integrates the pressure over the collision mesh:
+  ///   * `<collision>` name of the collision to use, defaults to all the
+  ///   collisions of the link.
+  ///   * `<max_triangles>` triangle budget of the decimated mesh, defaults
+  ///   to 500.
+  /// * `<update_rate>` computes the buoyancy at this rate [Hz] instead of
+  /// every step, reapplying the last wrench in between. Defaults to 0,
+  /// every step.
+  /// * `<update_hold>` is "hold" (default) to reapply the last wrench or
+  /// "linear" to extrapolate it from the last two updates.
+  /// * `<update_error_check>` still computes the buoyancy every step to
+  /// report the error of the held wrench every 10 s of sim time, which
+  /// costs as much as the full rate. Defaults to false.
+  /// * `<park_distance>` parks the vessel while every competitor platform
+  /// is farther than this distance [m], as decided by the GameLogicPlugin.
+  /// A parked vessel keeps its horizontal position and heading and rides
+  /// the wave surface: its heave, roll and pitch follow the wave height at
+  /// its bow, stern, port and starboard, and the SimpleHydrodynamics and
+  /// MarineDynamics systems skip it. The model pose and the matching
+  /// velocity are commanded, so the dynamics resume from the ride state
+  /// when a platform comes near. Objects resting loose on the deck are not
+  /// carried along. Defaults to 0, never parked.
   ///
   /// ## Example
   /// <plugin
@@ -80,13 +129,6 @@ namespace systems
                 const ignition::gazebo::UpdateInfo &_info,
                 ignition::gazebo::EntityComponentManager &_ecm) override;
 
-    /// \brief Convenience function for calculating the area of circle segment.
-    /// \param[in] _r Radius of circle.
-    /// \param[in] _h Height of the chord line.
-    /// \return The area.
-    /// \ref https://www.mathopenref.com/segmentareaht.html
-    private: double CircleSegment(double _r, double _h) const;
-
     /// \brief Private data pointer.
     private: std::unique_ptr<SurfacePrivate> dataPtr;
   };
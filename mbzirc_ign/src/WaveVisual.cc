@@ -18,7 +18,9 @@
 #include "Wavefield.hh"
 #include "WaveVisual.hh"
 
+#include <algorithm>
 #include <list>
+#include <memory>
 #include <chrono>
 #include <mutex>
 #include <string>
@@ -78,8 +80,9 @@ class ignition::gazebo::systems::WaveVisualPrivate
   /// \brief Path to model
   public: std::string modelPath;
 
-  /// \brief Wavefield for computing wave params
-  public: Wavefield wavefield;
+  /// \brief Wavefield for computing wave params, shared with the other
+  /// plugins of the world.
+  public: std::shared_ptr<Wavefield> wavefield;
 
   /// \brief Indicate whether the shader params have been set or not
   public: bool paramsSet = false;
@@ -105,8 +108,15 @@ class ignition::gazebo::systems::WaveVisualPrivate
   /// \brief Shader param. Color of deep water.
   public: math::Color deepColor = math::Color(0.0f, 0.05f, 0.2f, 1.0f);
 
+  /// \brief Wavefield revision last uploaded to the shader.
+  public: uint64_t uploadedRevision = 0;
+
   /// \brief All rendering operations must happen within this call
   public: void OnUpdate();
+
+  /// \brief Upload the wave components to the vertex shader.
+  /// \param[in] _vsParams The vertex shader params.
+  public: void UploadWaveParams(const rendering::ShaderParamsPtr &_vsParams);
 };
 
 /////////////////////////////////////////////////
@@ -142,7 +152,7 @@ void WaveVisual::Configure(const Entity &_entity,
     return;
   }
 
-  this->dataPtr->wavefield.Load(_sdf);
+  this->dataPtr->wavefield = Wavefield::Acquire(worldEntity(_ecm), _sdf);
 
   if (this->dataPtr->modelPath.empty())
   {
@@ -223,6 +233,8 @@ void WaveVisual::PreUpdate(
   ignition::gazebo::EntityComponentManager &)
 {
   IGN_PROFILE("WaveVisual::PreUpdate");
+  if (this->dataPtr->wavefield)
+    this->dataPtr->wavefield->ApplyPendingUpdate();
   std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
   this->dataPtr->currentSimTime = _info.simTime;
 }
@@ -230,7 +242,7 @@ void WaveVisual::PreUpdate(
 //////////////////////////////////////////////////
 void WaveVisualPrivate::OnUpdate()
 {
-  if (this->visualName.empty())
+  if (this->visualName.empty() || !this->wavefield)
     return;
 
   if (!this->scene)
@@ -311,58 +323,7 @@ void WaveVisualPrivate::OnUpdate()
     (*vsParams)["bumpSpeed"].UpdateBuffer(bumpSpeedV);
 
     // wavefield parameters:
-    (*vsParams)["Nwaves"] = static_cast<int>(this->wavefield.Number());
-    float amplitudeV[3] = {
-        static_cast<float>(this->wavefield.Amplitude_V()[0]),
-        static_cast<float>(this->wavefield.Amplitude_V()[1]),
-        static_cast<float>(this->wavefield.Amplitude_V()[2])};
-    (*vsParams)["amplitude"].InitializeBuffer(3);
-    (*vsParams)["amplitude"].UpdateBuffer(amplitudeV);
-
-    float wavenumberV[3] = {
-        static_cast<float>(this->wavefield.Wavenumber_V()[0]),
-        static_cast<float>(this->wavefield.Wavenumber_V()[1]),
-        static_cast<float>(this->wavefield.Wavenumber_V()[2])};
-    (*vsParams)["wavenumber"].InitializeBuffer(3);
-    (*vsParams)["wavenumber"].UpdateBuffer(wavenumberV);
-
-    float omegaV[3] = {
-        static_cast<float>(this->wavefield.AngularFrequency_V()[0]),
-        static_cast<float>(this->wavefield.AngularFrequency_V()[1]),
-        static_cast<float>(this->wavefield.AngularFrequency_V()[2])};
-    (*vsParams)["omega"].InitializeBuffer(3);
-    (*vsParams)["omega"].UpdateBuffer(omegaV);
-
-    auto directions0 = this->wavefield.Direction_V()[0];
-    float dir0[2] = {
-        static_cast<float>(directions0.X()),
-        static_cast<float>(directions0.Y())};
-    (*vsParams)["dir0"].InitializeBuffer(2);
-    (*vsParams)["dir0"].UpdateBuffer(dir0);
-
-    auto directions1 = this->wavefield.Direction_V()[1];
-    float dir1[2] = {
-        static_cast<float>(directions1.X()),
-        static_cast<float>(directions1.Y())};
-    (*vsParams)["dir1"].InitializeBuffer(2);
-    (*vsParams)["dir1"].UpdateBuffer(dir1);
-
-    auto directions2 = this->wavefield.Direction_V()[2];
-    float dir2[2] = {
-        static_cast<float>(directions2.X()),
-        static_cast<float>(directions2.Y())};
-    (*vsParams)["dir2"].InitializeBuffer(2);
-    (*vsParams)["dir2"].UpdateBuffer(dir2);
-
-    float steepnessV[3] = {
-        static_cast<float>(this->wavefield.Steepness_V()[0]),
-        static_cast<float>(this->wavefield.Steepness_V()[1]),
-        static_cast<float>(this->wavefield.Steepness_V()[2])};
-    (*vsParams)["steepness"].InitializeBuffer(3);
-    (*vsParams)["steepness"].UpdateBuffer(steepnessV);
-
-    float tau = this->wavefield.Tau();
-    (*vsParams)["tau"] = tau;
+    this->UploadWaveParams(vsParams);
 
     // camera_position_object_space is a constant defined by ogre.
     (*vsParams)["camera_position_object_space"] = 1;
@@ -407,6 +368,11 @@ void WaveVisualPrivate::OnUpdate()
         rendering::ShaderParam::ParamType::PARAM_TEXTURE_CUBE, 1u);
     this->paramsSet = true;
   }
+  else if (this->wavefield->Revision() != this->uploadedRevision)
+  {
+    // The sea state changed.
+    this->UploadWaveParams(this->material->VertexShaderParams());
+  }
 
   // time variables need to be updated every iteration
   {
@@ -419,6 +385,52 @@ void WaveVisualPrivate::OnUpdate()
   }
 }
 
+//////////////////////////////////////////////////
+void WaveVisualPrivate::UploadWaveParams(
+    const rendering::ShaderParamsPtr &_vsParams)
+{
+  // Read the revision first so a concurrent update is picked up again on
+  // the next call rather than lost.
+  this->uploadedRevision = this->wavefield->Revision();
+  auto c = this->wavefield->Components();
+
+  // The shader sums up to three components.
+  const size_t n = std::min<size_t>(c->Size(), 3);
+  float amplitudeV[3] = {0, 0, 0};
+  float wavenumberV[3] = {0, 0, 0};
+  float omegaV[3] = {0, 0, 0};
+  float steepnessV[3] = {0, 0, 0};
+  float dirV[3][2] = {{1, 0}, {1, 0}, {1, 0}};
+  for (size_t i = 0; i < n; ++i)
+  {
+    amplitudeV[i] = static_cast<float>(c->a[i]);
+    wavenumberV[i] = static_cast<float>(c->k[i]);
+    omegaV[i] = static_cast<float>(c->omega[i]);
+    steepnessV[i] = static_cast<float>(c->q[i]);
+    dirV[i][0] = static_cast<float>(c->dx[i]);
+    dirV[i][1] = static_cast<float>(c->dy[i]);
+  }
+
+  (*_vsParams)["Nwaves"] = static_cast<int>(n);
+  (*_vsParams)["amplitude"].InitializeBuffer(3);
+  (*_vsParams)["amplitude"].UpdateBuffer(amplitudeV);
+  (*_vsParams)["wavenumber"].InitializeBuffer(3);
+  (*_vsParams)["wavenumber"].UpdateBuffer(wavenumberV);
+  (*_vsParams)["omega"].InitializeBuffer(3);
+  (*_vsParams)["omega"].UpdateBuffer(omegaV);
+  (*_vsParams)["dir0"].InitializeBuffer(2);
+  (*_vsParams)["dir0"].UpdateBuffer(dirV[0]);
+  (*_vsParams)["dir1"].InitializeBuffer(2);
+  (*_vsParams)["dir1"].UpdateBuffer(dirV[1]);
+  (*_vsParams)["dir2"].InitializeBuffer(2);
+  (*_vsParams)["dir2"].UpdateBuffer(dirV[2]);
+  (*_vsParams)["steepness"].InitializeBuffer(3);
+  (*_vsParams)["steepness"].UpdateBuffer(steepnessV);
+
+  float tau = this->wavefield->Tau();
+  (*_vsParams)["tau"] = tau;
+}
+
 IGNITION_ADD_PLUGIN(WaveVisual,
                     ignition::gazebo::System,
                     WaveVisual::ISystemConfigure,
@@ -15,11 +15,15 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <string>
 
-#include <Eigen/Dense>
 #include <ignition/common/Console.hh>
 #include <ignition/math/Pose3.hh>
 #include <ignition/math/Vector2.hh>
@@ -27,6 +31,7 @@
 #include <ignition/transport/Node.hh>
 
 #include "Wavefield.hh"
+#include "WavefieldFFT.hh"
 
 using namespace ignition;
 using namespace gazebo;
@@ -40,6 +45,328 @@ std::ostream& operator<<(std::ostream &_os, const std::vector<double> &_vec)
   return _os;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Heightfield rasterized from the wave components on a regular grid,
+/// split into tiles that are only rebuilt when a query touches them.
+///
+/// The grid covers a rectangle of the given size centered at the origin.
+/// Rebuilds happen at most once per refresh period (an "epoch") and all tiles
+/// built during an epoch are sampled at the same time, so neighbouring tiles
+/// always agree.
+class WavefieldGridCache
+{
+  /// \brief Build the grid layout and the separable spatial phase tables.
+  /// \param[in] _components The wave components.
+  /// \param[in] _size Size of the cached region [m].
+  /// \param[in] _cellCount Number of cells in each direction.
+  public: void Reset(std::shared_ptr<const WavefieldComponents> _components,
+                     const ignition::math::Vector2d &_size,
+                     const ignition::math::Vector2d &_cellCount)
+  {
+    this->components = std::move(_components);
+    this->nx = std::max(1, static_cast<int>(_cellCount.X())) + 1;
+    this->ny = std::max(1, static_cast<int>(_cellCount.Y())) + 1;
+    this->x0 = -_size.X() / 2.0;
+    this->y0 = -_size.Y() / 2.0;
+    this->cellX = _size.X() / (this->nx - 1);
+    this->cellY = _size.Y() / (this->ny - 1);
+    this->tilesX = (this->nx + this->tileSize - 1) / this->tileSize;
+    this->tilesY = (this->ny + this->tileSize - 1) / this->tileSize;
+    this->tileEpoch.assign(this->tilesX * this->tilesY, -1);
+    this->heights.assign(this->nx * this->ny, 0.0);
+    this->gradX.assign(this->normals ? this->nx * this->ny : 0, 0.0);
+    this->gradY.assign(this->normals ? this->nx * this->ny : 0, 0.0);
+    this->epoch = -1;
+    if (!this->components)
+      return;
+
+    // cos(k (dx x + dy y)) = cos(k dx x) cos(k dy y) - sin(k dx x) sin(k dy y)
+    // so per-column and per-row tables give the spatial phase at every node
+    // without any transcendental call when a tile is rebuilt.
+    const auto &c = *this->components;
+    const size_t n = c.Size();
+    this->cosX.resize(n * this->nx);
+    this->sinX.resize(n * this->nx);
+    this->cosY.resize(n * this->ny);
+    this->sinY.resize(n * this->ny);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (int col = 0; col < this->nx; ++col)
+      {
+        const double phase = c.k[i] * c.dx[i] * (this->x0 + col * this->cellX);
+        this->cosX[i * this->nx + col] = std::cos(phase);
+        this->sinX[i * this->nx + col] = std::sin(phase);
+      }
+      for (int row = 0; row < this->ny; ++row)
+      {
+        const double phase = c.k[i] * c.dy[i] * (this->y0 + row * this->cellY);
+        this->cosY[i * this->ny + row] = std::cos(phase);
+        this->sinY[i * this->ny + row] = std::sin(phase);
+      }
+    }
+  }
+
+  /// \brief Whether the cache was built for the given components.
+  /// \param[in] _components The wave components.
+  /// \return True if the cache is up to date with the components.
+  public: bool Matches(
+              const std::shared_ptr<const WavefieldComponents> &_components)
+              const
+  {
+    return this->components == _components;
+  }
+
+  /// \brief Advance the refresh epoch if a query is made at a new time.
+  /// \param[in] _time The query time.
+  /// \return True if the epoch changed and the caller must provide a new
+  /// snapshot through SetSnapshot.
+  public: bool Advance(double _time)
+  {
+    int64_t e = this->refreshPeriod > 0.0 ?
+        static_cast<int64_t>(std::floor(_time / this->refreshPeriod)) :
+        this->epoch + (_time != this->epochTime ? 1 : 0);
+    if (e == this->epoch && this->epoch >= 0)
+      return false;
+    this->epoch = std::max<int64_t>(e, 0);
+    this->epochTime = _time;
+    return true;
+  }
+
+  /// \brief Set the snapshot used to rebuild tiles in the current epoch.
+  /// \param[in] _snapshot The snapshot.
+  public: void SetSnapshot(std::shared_ptr<const WavefieldSnapshot> _snapshot)
+  {
+    this->snapshot = std::move(_snapshot);
+  }
+
+  /// \brief Time of the current epoch.
+  /// \return Time at which the tiles of the current epoch are sampled.
+  public: double EpochTime() const
+  {
+    return this->epochTime;
+  }
+
+  /// \brief Interpolate the height at a point.
+  /// \param[in] _x x coordinate of the point.
+  /// \param[in] _y y coordinate of the point.
+  /// \param[out] _h The interpolated height.
+  /// \return False if the point is outside the cached region.
+  public: bool Height(double _x, double _y, double &_h)
+  {
+    return this->Interpolate(this->heights, _x, _y, _h);
+  }
+
+  /// \brief Interpolate the height gradient at a point.
+  /// \param[in] _x x coordinate of the point.
+  /// \param[in] _y y coordinate of the point.
+  /// \param[out] _dhdx The interpolated gradient along x.
+  /// \param[out] _dhdy The interpolated gradient along y.
+  /// \return False if normals are not cached or the point is outside the
+  /// cached region.
+  public: bool Gradient(double _x, double _y, double &_dhdx, double &_dhdy)
+  {
+    if (!this->normals)
+      return false;
+    return this->Interpolate(this->gradX, _x, _y, _dhdx) &&
+        this->Interpolate(this->gradY, _x, _y, _dhdy);
+  }
+
+  /// \brief Interpolate a node layer at a point.
+  /// \param[in] _layer The node values.
+  /// \param[in] _x x coordinate of the point.
+  /// \param[in] _y y coordinate of the point.
+  /// \param[out] _value The interpolated value.
+  /// \return False if the point is outside the cached region.
+  private: bool Interpolate(const std::vector<double> &_layer,
+                            double _x, double _y, double &_value)
+  {
+    const double u = (_x - this->x0) / this->cellX;
+    const double v = (_y - this->y0) / this->cellY;
+    const int margin = this->bicubic ? 1 : 0;
+    const int col = static_cast<int>(std::floor(u));
+    const int row = static_cast<int>(std::floor(v));
+    if (col < margin || row < margin ||
+        col + 1 + margin >= this->nx || row + 1 + margin >= this->ny)
+    {
+      return false;
+    }
+    const double fu = u - col;
+    const double fv = v - row;
+
+    if (!this->bicubic)
+    {
+      const double h00 = this->Node(_layer, col, row);
+      const double h10 = this->Node(_layer, col + 1, row);
+      const double h01 = this->Node(_layer, col, row + 1);
+      const double h11 = this->Node(_layer, col + 1, row + 1);
+      _value = (h00 * (1 - fu) + h10 * fu) * (1 - fv) +
+               (h01 * (1 - fu) + h11 * fu) * fv;
+      return true;
+    }
+
+    // Catmull-Rom over the 4x4 neighbourhood.
+    double rows[4];
+    for (int j = 0; j < 4; ++j)
+    {
+      rows[j] = CatmullRom(
+          this->Node(_layer, col - 1, row - 1 + j),
+          this->Node(_layer, col, row - 1 + j),
+          this->Node(_layer, col + 1, row - 1 + j),
+          this->Node(_layer, col + 2, row - 1 + j), fu);
+    }
+    _value = CatmullRom(rows[0], rows[1], rows[2], rows[3], fv);
+    return true;
+  }
+
+  /// \brief Catmull-Rom spline through four equally spaced samples.
+  /// \param[in] _p0 Sample before the interval.
+  /// \param[in] _p1 Sample at the start of the interval.
+  /// \param[in] _p2 Sample at the end of the interval.
+  /// \param[in] _p3 Sample after the interval.
+  /// \param[in] _t Position in the interval in [0, 1].
+  /// \return The interpolated value.
+  private: static double CatmullRom(double _p0, double _p1, double _p2,
+                                    double _p3, double _t)
+  {
+    return _p1 + 0.5 * _t * (_p2 - _p0 + _t * (2.0 * _p0 - 5.0 * _p1 +
+        4.0 * _p2 - _p3 + _t * (3.0 * (_p1 - _p2) + _p3 - _p0)));
+  }
+
+  /// \brief Get a node value, rebuilding its tile first if it is stale.
+  /// \param[in] _layer The node values.
+  /// \param[in] _col Node column.
+  /// \param[in] _row Node row.
+  /// \return The node value.
+  private: double Node(const std::vector<double> &_layer, int _col, int _row)
+  {
+    const int tile = (_row / this->tileSize) * this->tilesX +
+        _col / this->tileSize;
+    if (this->tileEpoch[tile] != this->epoch)
+      this->RebuildTile(tile);
+    return _layer[_row * this->nx + _col];
+  }
+
+  /// \brief Rasterize the wavefield over one tile.
+  /// \param[in] _tile Tile index.
+  private: void RebuildTile(int _tile)
+  {
+    const int colBegin = (_tile % this->tilesX) * this->tileSize;
+    const int rowBegin = (_tile / this->tilesX) * this->tileSize;
+    const int colEnd = std::min(colBegin + this->tileSize, this->nx);
+    const int rowEnd = std::min(rowBegin + this->tileSize, this->ny);
+
+    const auto &c = *this->components;
+    const auto &cwt = this->snapshot->CosOmegaT();
+    const auto &swt = this->snapshot->SinOmegaT();
+    const double ramp = this->snapshot->Ramp();
+    const size_t n = c.Size();
+
+    for (int row = rowBegin; row < rowEnd; ++row)
+    {
+      for (int col = colBegin; col < colEnd; ++col)
+      {
+        double h = 0.0;
+        double gx = 0.0;
+        double gy = 0.0;
+        for (size_t i = 0; i < n; ++i)
+        {
+          const double cx = this->cosX[i * this->nx + col];
+          const double sx = this->sinX[i * this->nx + col];
+          const double cy = this->cosY[i * this->ny + row];
+          const double sy = this->sinY[i * this->ny + row];
+          const double cosKx = cx * cy - sx * sy;
+          const double sinKx = sx * cy + cx * sy;
+          // cos(kx - wt) and sin(kx - wt) by angle addition.
+          const double cosTheta = cosKx * cwt[i] + sinKx * swt[i];
+          h += c.a[i] * cosTheta;
+          if (this->normals)
+          {
+            const double sinTheta = sinKx * cwt[i] - cosKx * swt[i];
+            gx -= c.a[i] * c.k[i] * c.dx[i] * sinTheta;
+            gy -= c.a[i] * c.k[i] * c.dy[i] * sinTheta;
+          }
+        }
+        const int idx = row * this->nx + col;
+        this->heights[idx] = h * ramp;
+        if (this->normals)
+        {
+          this->gradX[idx] = gx * ramp;
+          this->gradY[idx] = gy * ramp;
+        }
+      }
+    }
+    this->tileEpoch[_tile] = this->epoch;
+  }
+
+  /// \brief Refresh period [s]. Zero refreshes on every new query time.
+  public: double refreshPeriod{0.0};
+
+  /// \brief Number of grid nodes per tile side.
+  public: int tileSize{16};
+
+  /// \brief Use bicubic instead of bilinear interpolation.
+  public: bool bicubic{false};
+
+  /// \brief Also cache the height gradient.
+  public: bool normals{false};
+
+  /// \brief Query a reference value every this many lookups. Zero disables
+  /// the error check.
+  public: unsigned int errorSamplePeriod{100};
+
+  /// \brief Lookups since the last error check.
+  public: unsigned int lookupsSinceCheck{0};
+
+  /// \brief Interpolation error against ComputeDepthSimply.
+  public: WavefieldError error;
+
+  /// \brief Components the cache was built for.
+  private: std::shared_ptr<const WavefieldComponents> components;
+
+  /// \brief Snapshot used to rebuild tiles in the current epoch.
+  private: std::shared_ptr<const WavefieldSnapshot> snapshot;
+
+  /// \brief Number of nodes along x and y.
+  private: int nx{0};
+  private: int ny{0};
+
+  /// \brief Number of tiles along x and y.
+  private: int tilesX{0};
+  private: int tilesY{0};
+
+  /// \brief Position of the first node [m].
+  private: double x0{0.0};
+  private: double y0{0.0};
+
+  /// \brief Node spacing [m].
+  private: double cellX{1.0};
+  private: double cellY{1.0};
+
+  /// \brief Current refresh epoch.
+  private: int64_t epoch{-1};
+
+  /// \brief Time at which tiles are sampled in the current epoch.
+  private: double epochTime{0.0};
+
+  /// \brief Epoch in which each tile was last rebuilt.
+  private: std::vector<int64_t> tileEpoch;
+
+  /// \brief Node heights, row major.
+  private: std::vector<double> heights;
+
+  /// \brief Node height gradients, row major.
+  private: std::vector<double> gradX;
+  private: std::vector<double> gradY;
+
+  /// \brief Per component and column cos/sin(k dx x).
+  private: std::vector<double> cosX;
+  private: std::vector<double> sinX;
+
+  /// \brief Per component and row cos/sin(k dy y).
+  private: std::vector<double> cosY;
+  private: std::vector<double> sinY;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief Private data for the WavefieldParameters.
 class ignition::gazebo::WavefieldPrivate
@@ -71,7 +398,7 @@ class ignition::gazebo::WavefieldPrivate
   /// \brief The number of grid cells in the wavefield.
   public: ignition::math::Vector2d cellCount;
 
-  /// \brief Name of wavefield model to use - must be "PMS" or "CWR"
+  /// \brief Name of wavefield model to use - must be "PMS", "CWR" or "FFT"
   public: std::string model;
 
   /// \brief The number of component waves.
@@ -131,9 +458,201 @@ class ignition::gazebo::WavefieldPrivate
   /// \brief The component wave dirctions (derived).
   public: std::vector<ignition::math::Vector2d> directions;
 
+  /// \brief The component waves in a structure-of-arrays layout (derived).
+  public: std::shared_ptr<const WavefieldComponents> components{
+    std::make_shared<WavefieldComponents>()};
+
+  /// \brief The most recent snapshot of the time dependent terms.
+  public: std::shared_ptr<WavefieldSnapshot> snapshot;
+
+  /// \brief Scratch x coordinates used by the batched depth query.
+  public: std::vector<double> batchX;
+
+  /// \brief Scratch y coordinates used by the batched depth query.
+  public: std::vector<double> batchY;
+
   /// \brief The transport node
   public: ignition::transport::Node node;
 
+  /// \brief FFT ocean engine, only used by the FFT model.
+  public: std::unique_ptr<WavefieldFFT> fft;
+
+  /// \brief FFT grid nodes along each side.
+  public: size_t fftResolution{64};
+
+  /// \brief FFT patch side length [m], 0 to derive it from the period.
+  public: double fftPatchSize{0.0};
+
+  /// \brief Seed of the FFT spectrum realisation.
+  public: unsigned int fftSeed{0};
+
+  /// \brief Depth from the FFT engine.
+  /// \param[in] _point The query point.
+  /// \param[in] _time The query time.
+  /// \param[in] _timeInit Start time of the wavefield.
+  /// \return The depth at the point.
+  public: double FftDepth(const ignition::math::Vector3d &_point,
+                          double _time, double _timeInit)
+  {
+    this->fft->Update(_time);
+    const double ramp = 1 - exp(-1.0 * (_time - _timeInit) / this->tau);
+    return ramp * this->fft->Height(_point.X(), _point.Y());
+  }
+
+  /// \brief A sea state waiting to be applied.
+  public: struct SeaState
+  {
+    /// \brief Gain.
+    double gain;
+
+    /// \brief Period [s].
+    double period;
+
+    /// \brief Direction, zero to keep the current one.
+    ignition::math::Vector2d direction;
+  };
+
+  /// \brief Protects pendingUpdate and hasPendingUpdate.
+  public: std::mutex updateMutex;
+
+  /// \brief The queued sea state.
+  public: SeaState pendingUpdate;
+
+  /// \brief Whether a sea state is queued. Checked without the lock on
+  /// every step.
+  public: std::atomic<bool> hasPendingUpdate{false};
+
+  /// \brief Whether the update topic is subscribed.
+  public: bool subscribed{false};
+
+  /// \brief Protects components when read from other threads.
+  public: mutable std::mutex componentsMutex;
+
+  /// \brief Number of times the components have been packed.
+  public: std::atomic<uint64_t> revision{0};
+
+  /// \brief Callback for sea state updates.
+  /// \param[in] _msg [gain, period] or [gain, period, dir x, dir y].
+  public: void OnSeaStateUpdate(const msgs::Float_V &_msg)
+  {
+    if (_msg.data_size() < 2 || _msg.data(0) < 0.0 || _msg.data(1) <= 0.0)
+    {
+      ignerr << "Ignoring invalid wavefield update, expected "
+             << "[gain, period] or [gain, period, dir x, dir y]" << std::endl;
+      return;
+    }
+    ignition::math::Vector2d dir;
+    if (_msg.data_size() >= 4)
+      dir.Set(_msg.data(2), _msg.data(3));
+
+    std::lock_guard<std::mutex> lock(this->updateMutex);
+    this->pendingUpdate = {_msg.data(0), _msg.data(1), dir};
+    this->hasPendingUpdate = true;
+  }
+
+  /// \brief ComputeDepthLod checks itself every this many queries of a
+  /// level of detail. 0 disables the check.
+  public: unsigned int lodErrorSamplePeriod{100};
+
+  /// \brief ComputeDepthLod queries since the last check, per level of
+  /// detail.
+  public: std::map<size_t, unsigned int> lodQueries;
+
+  /// \brief ComputeDepthLod error per level of detail.
+  public: std::map<size_t, WavefieldError> lodError;
+
+  /// \brief Optional heightfield cache, null when disabled.
+  public: std::unique_ptr<WavefieldGridCache> grid;
+
+  /// \brief Make sure the grid cache matches the current components and
+  /// refresh epoch.
+  /// \param[in] _time The query time.
+  /// \param[in] _timeInit Start time of the wavefield.
+  public: void UpdateGrid(double _time, double _timeInit)
+  {
+    if (!this->grid->Matches(this->components))
+    {
+      this->grid->Reset(this->components, this->size, this->cellCount);
+    }
+    if (this->grid->Advance(_time))
+    {
+      this->SnapshotAt(_time, _timeInit);
+      this->grid->SetSnapshot(this->snapshot);
+    }
+  }
+
+  /// \brief Publish the derived component parameters in packed form.
+  public: void Pack()
+  {
+    auto packed = std::make_shared<WavefieldComponents>();
+    const size_t n = this->amplitudes.size();
+
+    // Largest amplitude first so truncating keeps the most energy.
+    std::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i)
+      order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t _a, size_t _b)
+        {
+          return std::fabs(this->amplitudes[_a]) >
+              std::fabs(this->amplitudes[_b]);
+        });
+
+    packed->a.resize(n);
+    packed->k.resize(n);
+    packed->omega.resize(n);
+    packed->q.resize(n);
+    packed->dx.resize(n);
+    packed->dy.resize(n);
+    packed->tail.assign(n + 1, 0.0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const size_t j = order[i];
+      packed->a[i] = this->amplitudes[j];
+      packed->k[i] = this->wavenumbers[j];
+      packed->omega[i] = this->angularFrequencies[j];
+      packed->q[i] = this->steepnesses[j];
+      packed->dx[i] = this->directions[j].X();
+      packed->dy[i] = this->directions[j].Y();
+    }
+    for (size_t i = n; i > 0; --i)
+      packed->tail[i - 1] = packed->tail[i] + std::fabs(packed->a[i - 1]);
+    {
+      std::lock_guard<std::mutex> lock(this->componentsMutex);
+      this->components = packed;
+    }
+    this->snapshot.reset();
+    this->revision++;
+  }
+
+  /// \brief Get the snapshot at a given time, reusing the last one if it
+  /// was taken at the same time. Otherwise the last snapshot is updated in
+  /// place, unless a caller still holds it.
+  /// \param[in] _time Time of the snapshot.
+  /// \param[in] _timeInit Start time of the wavefield.
+  /// \return The snapshot.
+  public: const WavefieldSnapshot &SnapshotAt(double _time, double _timeInit)
+  {
+    if (!this->snapshot)
+    {
+      this->snapshot = std::make_shared<WavefieldSnapshot>(
+          this->components, _time, _timeInit, this->tau);
+    }
+    else if (this->snapshot->Time() != _time ||
+        this->snapshot->TimeInit() != _timeInit)
+    {
+      if (this->snapshot.use_count() == 1)
+      {
+        this->snapshot->Update(_time, _timeInit, this->tau);
+      }
+      else
+      {
+        this->snapshot = std::make_shared<WavefieldSnapshot>(
+            this->components, _time, _timeInit, this->tau);
+      }
+    }
+    return *this->snapshot;
+  }
+
   /// \brief Recalculate for constant wavelength-amplitude ratio
   public: void RecalculateCwr()
   {
@@ -214,16 +733,44 @@ class ignition::gazebo::WavefieldPrivate
     this->steepnesses.clear();
     this->directions.clear();
 
+    // Up to three components sit at scale^-1, scale^0 and scale^1 times the
+    // mean frequency. More components are spread evenly (in log frequency)
+    // over the same range.
+    std::vector<double> exponents(this->number);
+    for (size_t i = 0; i < this->number; ++i)
+    {
+      exponents[i] = this->number <= 3 ? static_cast<double>(i) - 1.0 :
+          -1.0 + 2.0 * i / (this->number - 1.0);
+    }
+
     // Vector for spaceing
     std::vector<double> omegaSpacing;
-    omegaSpacing.push_back(this->angularFrequency * (1.0 - 1.0 / this->scale));
-    omegaSpacing.push_back(this->angularFrequency * \
-                            (this->scale - 1.0 / this->scale) / 2.0);
-    omegaSpacing.push_back(this->angularFrequency * (this->scale - 1.0));
+    if (this->number <= 3)
+    {
+      omegaSpacing.push_back(
+          this->angularFrequency * (1.0 - 1.0 / this->scale));
+      omegaSpacing.push_back(this->angularFrequency * \
+                              (this->scale - 1.0 / this->scale) / 2.0);
+      omegaSpacing.push_back(this->angularFrequency * (this->scale - 1.0));
+    }
+    else
+    {
+      // Width of the band around each frequency, which gives the same
+      // spacing as above for three components.
+      auto omegaAt = [&](size_t _i)
+      {
+        return this->angularFrequency * std::pow(this->scale, exponents[_i]);
+      };
+      const size_t last = this->number - 1;
+      omegaSpacing.push_back(omegaAt(1) - omegaAt(0));
+      for (size_t i = 1; i < last; ++i)
+        omegaSpacing.push_back((omegaAt(i + 1) - omegaAt(i - 1)) / 2.0);
+      omegaSpacing.push_back(omegaAt(last) - omegaAt(last - 1));
+    }
 
     for (size_t i = 0; i < this->number; ++i)
     {
-      const int n = i - 1;
+      const double n = exponents[i];
       const double scaleFactor = std::pow(this->scale, n);
       const double omega = this->angularFrequency * scaleFactor;
       const double pms = pm(omega, this->angularFrequency);
@@ -253,6 +800,26 @@ class ignition::gazebo::WavefieldPrivate
     }
   }
 
+  /// \brief Recalculate the FFT engine from the PMS parameters.
+  public: void RecalculateFft()
+  {
+    if (!this->fft)
+    {
+      this->fft = std::make_unique<WavefieldFFT>();
+      this->fft->SetResolution(this->fftResolution);
+      this->fft->SetSeed(this->fftSeed);
+    }
+    // Default to a patch several peak wavelengths across so the spectral
+    // peak is well resolved.
+    double patchSize = this->fftPatchSize;
+    if (patchSize <= 0.0)
+      patchSize = 8.0 * this->wavelength;
+    this->fft->SetPatchSize(patchSize);
+    this->fft->SetChoppiness(this->steepness);
+    this->fft->SetSpectrum(this->gain, this->period, this->direction,
+        this->angle);
+  }
+
   /// \brief Recalculate all derived quantities from inputs.
   public: void Recalculate()
   {
@@ -268,12 +835,23 @@ class ignition::gazebo::WavefieldPrivate
             << std::endl;
       this->RecalculateCwr();
     }
+    else if (!this->model.compare("FFT"))
+    {
+      ignmsg << "Using FFT (Tessendorf) wavefield model " << std::endl;
+      // The sampled PMS components still describe the sea state for
+      // consumers of the component vectors such as the wave shader.
+      this->RecalculatePms();
+      this->RecalculateFft();
+    }
     else
     {
       ignwarn<< "Wavefield model specified as <" << this->model
-            << "> which is not one of the two supported wavefield models: "
-            << "PMS or CWR!!!" << std::endl;
+            << "> which is not one of the supported wavefield models: "
+            << "PMS, CWR or FFT!!!" << std::endl;
     }
+    if (this->model.compare("FFT"))
+      this->fft.reset();
+    this->Pack();
   }
 
   /////////////////////////////////////////////////
@@ -316,6 +894,35 @@ void Wavefield::Load(const std::shared_ptr<const sdf::Element> &_sdf)
     this->data->size).first;
   this->data->cellCount = sdfWavefield->Get<ignition::math::Vector2d>("cell_count",
     this->data->cellCount).first;
+  if (sdfWavefield->HasElement("grid_cache"))
+  {
+    auto sdfGrid = sdfWavefield->GetElement("grid_cache");
+    auto grid = std::make_unique<WavefieldGridCache>();
+    double rate = sdfGrid->Get<double>("refresh_rate", 0.0).first;
+    grid->refreshPeriod = rate > 0.0 ? 1.0 / rate : 0.0;
+    grid->tileSize = std::max(1,
+        sdfGrid->Get<int>("tile_size", grid->tileSize).first);
+    grid->bicubic =
+        sdfGrid->Get<std::string>("interpolation", "bilinear").first ==
+        "bicubic";
+    grid->normals = sdfGrid->Get<bool>("normals", grid->normals).first;
+    grid->errorSamplePeriod = sdfGrid->Get<unsigned int>(
+        "error_sample_period", grid->errorSamplePeriod).first;
+    this->data->grid = std::move(grid);
+  }
+
+  if (sdfWavefield->HasElement("fft"))
+  {
+    auto sdfFft = sdfWavefield->GetElement("fft");
+    this->data->fftResolution = sdfFft->Get<unsigned int>("resolution",
+        this->data->fftResolution).first;
+    this->data->fftPatchSize = sdfFft->Get<double>("patch_size",
+        this->data->fftPatchSize).first;
+    this->data->fftSeed = sdfFft->Get<unsigned int>("seed",
+        this->data->fftSeed).first;
+    this->data->fft.reset();
+  }
+
   if (sdfWavefield->HasElement("wave"))
   {
     auto sdfWave = sdfWavefield->GetElement("wave");
@@ -358,14 +965,96 @@ void Wavefield::Load(const std::shared_ptr<const sdf::Element> &_sdf)
       {
         this->data->gain = gain;
         this->data->period = period;
+        if (res.data_size() >= 4)
+          this->data->direction.Set(res.data(2), res.data(3));
         this->data->Recalculate();
       }
     }
   }
 
+  if (!this->data->subscribed)
+  {
+    this->data->subscribed = this->data->node.Subscribe(
+        "/mbzirc/wavefield/update", &WavefieldPrivate::OnSeaStateUpdate,
+        this->data.get());
+  }
+
   this->DebugPrint();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Wavefields loaded so far, keyed by world and the text of their
+/// <wavefield> element.
+struct WavefieldRegistry
+{
+  /// \brief Protects the entries.
+  std::mutex mutex;
+
+  /// \brief The wavefields.
+  std::map<std::pair<Entity, std::string>, std::weak_ptr<Wavefield>> entries;
+};
+
+/// \brief The process wide wavefield registry.
+/// \return The registry.
+static WavefieldRegistry &Registry()
+{
+  static WavefieldRegistry registry;
+  return registry;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::shared_ptr<Wavefield> Wavefield::Acquire(Entity _world,
+  const std::shared_ptr<const sdf::Element> &_sdf)
+{
+  auto &registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto key = std::make_pair(_world, Key(_sdf));
+  auto wavefield = registry.entries[key].lock();
+  if (!wavefield)
+  {
+    wavefield = std::make_shared<Wavefield>();
+    wavefield->Load(_sdf);
+    registry.entries[key] = wavefield;
+
+    // Drop entries of released wavefields.
+    for (auto it = registry.entries.begin(); it != registry.entries.end();)
+    {
+      if (it->second.expired())
+        it = registry.entries.erase(it);
+      else
+        ++it;
+    }
+  }
+  return wavefield;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::shared_ptr<Wavefield> Wavefield::Find(Entity _world,
+  const std::string &_key)
+{
+  auto &registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto it = registry.entries.find(std::make_pair(_world, _key));
+  if (it == registry.entries.end())
+    return nullptr;
+  return it->second.lock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::string Wavefield::Key(const std::shared_ptr<const sdf::Element> &_sdf)
+{
+  if (!_sdf->HasElement("wavefield"))
+    return "";
+  auto ptr = const_cast<sdf::Element *>(_sdf.get());
+  return ptr->GetElement("wavefield")->ToString("");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::string Wavefield::Model() const
+{
+  return this->data->model;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 size_t Wavefield::Number() const
 {
@@ -444,6 +1133,13 @@ ignition::math::Vector2d Wavefield::Direction() const
   return this->data->direction;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+void Wavefield::SetModel(const std::string &_model)
+{
+  this->data->model = _model;
+  this->data->Recalculate();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 void Wavefield::SetNumber(size_t _number)
 {
@@ -497,6 +1193,7 @@ void Wavefield::SetPhase(double _phase)
 void Wavefield::SetTau(double _tau)
 {
   this->data->tau = _tau;
+  this->data->snapshot.reset();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -583,135 +1280,660 @@ void Wavefield::DebugPrint() const
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-double Wavefield::ComputeDepthSimply(const ignition::math::Vector3d &_point,
-  double _time, double _timeInit)
+std::shared_ptr<const WavefieldComponents> Wavefield::Components() const
 {
-  double h = 0.0;
-  for (std::size_t i = 0; i < this->Number(); ++i)
+  std::lock_guard<std::mutex> lock(this->data->componentsMutex);
+  return this->data->components;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+uint64_t Wavefield::Revision() const
+{
+  return this->data->revision;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Wavefield::SetSeaState(double _gain, double _period,
+  const ignition::math::Vector2d &_direction)
+{
+  std::lock_guard<std::mutex> lock(this->data->updateMutex);
+  this->data->pendingUpdate = {_gain, _period, _direction};
+  this->data->hasPendingUpdate = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool Wavefield::ApplyPendingUpdate()
+{
+  if (!this->data->hasPendingUpdate)
+    return false;
+
+  WavefieldPrivate::SeaState update;
   {
-    double k = this->Wavenumber_V()[i];
-    double a = this->Amplitude_V()[i];
-    double dx =  this->Direction_V()[i].X();
-    double dy =  this->Direction_V()[i].Y();
-    double dot = _point.X() * dx + _point.Y() * dy;
-    double omega = this->AngularFrequency_V()[i];
-    double theta = k * dot - omega * _time;
-    double c = cos(theta);
-    h += a*c;
+    std::lock_guard<std::mutex> lock(this->data->updateMutex);
+    if (!this->data->hasPendingUpdate)
+      return false;
+    update = this->data->pendingUpdate;
+    this->data->hasPendingUpdate = false;
   }
 
-  // Exponentially grow the waves
-  return h * (1 - exp(-1.0 * (_time - _timeInit) / this->Tau()));
+  this->data->gain = update.gain;
+  this->data->period = update.period;
+  if (update.direction != ignition::math::Vector2d::Zero)
+    this->data->direction = update.direction;
+  this->data->Recalculate();
+  ignmsg << "Wavefield updated: gain [" << update.gain << "] period ["
+         << update.period << "] direction [" << this->data->direction << "]"
+         << std::endl;
+  return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-double Wavefield::ComputeDepthDirectly(const ignition::math::Vector3d &_point,
+std::shared_ptr<const WavefieldSnapshot> Wavefield::Snapshot(double _time,
+  double _timeInit)
+{
+  this->data->SnapshotAt(_time, _timeInit);
+  return this->data->snapshot;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ignition::math::Vector2d Wavefield::Size() const
+{
+  return this->data->size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ignition::math::Vector2d Wavefield::CellCount() const
+{
+  return this->data->cellCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Wavefield::SetSize(const ignition::math::Vector2d &_size)
+{
+  this->data->size = _size;
+  if (this->data->grid)
+    this->data->grid->Reset(this->data->components, _size,
+        this->data->cellCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Wavefield::SetCellCount(const ignition::math::Vector2d &_cellCount)
+{
+  this->data->cellCount = _cellCount;
+  if (this->data->grid)
+    this->data->grid->Reset(this->data->components, this->data->size,
+        _cellCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Wavefield::SetGridCache(bool _enable, double _refreshRate,
+  const std::string &_interpolation, bool _normals)
+{
+  if (!_enable)
+  {
+    this->data->grid.reset();
+    return;
+  }
+  auto grid = std::make_unique<WavefieldGridCache>();
+  grid->refreshPeriod = _refreshRate > 0.0 ? 1.0 / _refreshRate : 0.0;
+  grid->bicubic = _interpolation == "bicubic";
+  grid->normals = _normals;
+  this->data->grid = std::move(grid);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool Wavefield::GridCacheEnabled() const
+{
+  return this->data->grid != nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WavefieldError Wavefield::GridCacheError() const
+{
+  if (!this->data->grid)
+    return WavefieldError();
+  return this->data->grid->error;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double Wavefield::ComputeDepth(const ignition::math::Vector3d &_point,
   double _time, double _timeInit)
 {
-  // Struture for passing wave parameters to lambdas
-  struct WaveParams
-  {
-    WaveParams(
-      const std::vector<double>& _a,
-      const std::vector<double>& _k,
-      const std::vector<double>& _omega,
-      const std::vector<double>& _phi,
-      const std::vector<double>& _q,
-      const std::vector<ignition::math::Vector2d>& _dir) :
-      a(_a), k(_k), omega(_omega), phi(_phi), q(_q), dir(_dir) {}
-
-    const std::vector<double>& a;
-    const std::vector<double>& k;
-    const std::vector<double>& omega;
-    const std::vector<double>& phi;
-    const std::vector<double>& q;
-    const std::vector<ignition::math::Vector2d>& dir;
-  };
+  if (this->data->fft)
+    return this->data->FftDepth(_point, _time, _timeInit);
+  if (!this->data->grid)
+    return this->ComputeDepthSimply(_point, _time, _timeInit);
+
+  auto &grid = *this->data->grid;
+  this->data->UpdateGrid(_time, _timeInit);
+  double h;
+  if (!grid.Height(_point.X(), _point.Y(), h))
+    return this->ComputeDepthSimply(_point, _time, _timeInit);
+
+  // Periodically check the lookup against the exact sum.
+  if (grid.errorSamplePeriod > 0 &&
+      ++grid.lookupsSinceCheck >= grid.errorSamplePeriod)
+  {
+    grid.lookupsSinceCheck = 0;
+    grid.error.Add(h - this->ComputeDepthSimply(_point, _time, _timeInit));
+    if (grid.error.count % 1000 == 0)
+    {
+      igndbg << "Wavefield grid cache error over " << grid.error.count
+             << " samples: max " << grid.error.max << " m, rms "
+             << grid.error.Rms() << " m" << std::endl;
+    }
+  }
+  return h;
+}
 
-  // Compute the target function and Jacobian. Also calculate pz,
-  // the z-component of the Gerstner wave, which we essentially get for free.
-  // cppcheck-suppress constParameter
-  auto wave_fdf = [=](auto x, auto p, auto t, auto &wp, auto &F, auto &J)
-  {
-    double pz = 0;
-    F(0) = p.x() - x.x();
-    F(1) = p.y() - x.y();
-    J(0, 0) = -1;
-    J(0, 1) =  0;
-    J(1, 0) =  0;
-    J(1, 1) = -1;
-    const size_t n = wp.a.size();
-    for (auto&& i = 0; i < n; ++i) // NOLINT
+///////////////////////////////////////////////////////////////////////////////
+double Wavefield::ComputeDepthLod(const ignition::math::Vector3d &_point,
+  double _maxError, double _time, double _timeInit)
+{
+  if (this->data->fft || this->data->grid)
+    return this->ComputeDepth(_point, _time, _timeInit);
+
+  const auto &snapshot = this->data->SnapshotAt(_time, _timeInit);
+  const auto &c = snapshot.Components();
+  const size_t count = c.Truncation(_maxError);
+  const double h = snapshot.ComputeDepth(_point, count);
+
+  auto &period = this->data->lodErrorSamplePeriod;
+  auto &queries = this->data->lodQueries[count];
+  if (period > 0 && ++queries >= period)
+  {
+    queries = 0;
+    auto &error = this->data->lodError[count];
+    error.Add(h - snapshot.ComputeDepth(_point));
+    if (error.count % 1000 == 0)
     {
-      const double dx = wp.dir[i].X();
-      const double dy = wp.dir[i].Y();
-      const double q = wp.q[i];
-      const double a = wp.a[i];
-      const double k = wp.k[i];
-      const double dot = x.x() * dx + x.y() * dy;
-      const double theta = k * dot - wp.omega[i] * t;
-      const double s = std::sin(theta);
-      const double c = std::cos(theta);
-      const double qakc = q * a * k * c;
-      const double df1x = qakc * dx * dx;
-      const double df1y = qakc * dx * dy;
-      const double df2x = df1y;
-      const double df2y = qakc * dy * dy;
-      pz += a * c;
-      F(0) += a * dx * s;
-      F(1) += a * dy * s;
-      J(0, 0) += df1x;
-      J(0, 1) += df1y;
-      J(1, 0) += df2x;
-      J(1, 1) += df2y;
+      igndbg << "Wavefield error with " << count << " of " << c.Size()
+             << " components over " << error.count << " samples: max "
+             << error.max << " m, rms " << error.Rms() << " m" << std::endl;
     }
-    // Exponentially grow the waves
-    return pz * (1 - exp(-1.0 * (_time - _timeInit) / this->Tau()));
-  };
+  }
+  return h;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+std::map<size_t, WavefieldError> Wavefield::LodError() const
+{
+  return this->data->lodError;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Wavefield::SetLodErrorSamplePeriod(unsigned int _period)
+{
+  this->data->lodErrorSamplePeriod = _period;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ignition::math::Vector3d Wavefield::ComputeNormal(
+  const ignition::math::Vector3d &_point, double _time, double _timeInit)
+{
+  double dhdx = 0.0;
+  double dhdy = 0.0;
+  bool cached = false;
+  if (this->data->fft)
+  {
+    this->data->fft->Update(_time);
+    const double ramp = 1 - exp(-1.0 * (_time - _timeInit) / this->data->tau);
+    auto gradient = this->data->fft->Gradient(_point.X(), _point.Y());
+    dhdx = ramp * gradient.X();
+    dhdy = ramp * gradient.Y();
+    cached = true;
+  }
+  else if (this->data->grid)
+  {
+    this->data->UpdateGrid(_time, _timeInit);
+    cached = this->data->grid->Gradient(_point.X(), _point.Y(), dhdx, dhdy);
+  }
+
+  if (!cached)
+  {
+    auto kin = this->data->SnapshotAt(_time, _timeInit).ComputeKinematics(
+        _point);
+    dhdx = kin.dhdx;
+    dhdy = kin.dhdy;
+  }
 
-  // Simple multi-variate Newton solver -
-  // this version returns the z-component of the
-  // wave field at the desired point p.
-  // cppcheck-suppress constParameter
-  auto solver = [=](auto& fdfunc, auto x0, auto p, auto t, \
-                    auto& wp, auto tol, auto nmax)
-  {
-    int n = 0;
-    double err = 1;
-    double pz = 0;
-    auto xn = x0;
-    Eigen::Vector2d F;
-    Eigen::Matrix2d J;
-    while (std::abs(err) > tol && n < nmax)
+  return ignition::math::Vector3d(-dhdx, -dhdy, 1.0).Normalize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WavefieldKinematics Wavefield::ComputeKinematics(
+  const ignition::math::Vector3d &_point, double _time, double _timeInit)
+{
+  if (this->data->fft)
+  {
+    WavefieldKinematics kin;
+    kin.height = this->data->FftDepth(_point, _time, _timeInit);
+    const double ramp = 1 - exp(-1.0 * (_time - _timeInit) / this->data->tau);
+    auto gradient = this->data->fft->Gradient(_point.X(), _point.Y());
+    kin.dhdx = ramp * gradient.X();
+    kin.dhdy = ramp * gradient.Y();
+    return kin;
+  }
+  return this->data->SnapshotAt(_time, _timeInit).ComputeKinematics(_point);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double Wavefield::ComputeDepthSimply(const ignition::math::Vector3d &_point,
+  double _time, double _timeInit)
+{
+  if (this->data->fft)
+    return this->data->FftDepth(_point, _time, _timeInit);
+  return this->data->SnapshotAt(_time, _timeInit).ComputeDepth(_point);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void Wavefield::ComputeDepthBatch(
+  const std::vector<ignition::math::Vector3d> &_points,
+  double _time, std::vector<double> &_depths, double _timeInit)
+{
+  const size_t count = _points.size();
+  _depths.resize(count);
+  if (count == 0)
+    return;
+
+  if (this->data->fft)
+  {
+    for (size_t p = 0; p < count; ++p)
+      _depths[p] = this->data->FftDepth(_points[p], _time, _timeInit);
+    return;
+  }
+
+  // Unpack the points once so the kernel only touches contiguous arrays.
+  auto &px = this->data->batchX;
+  auto &py = this->data->batchY;
+  px.resize(count);
+  py.resize(count);
+  for (size_t p = 0; p < count; ++p)
+  {
+    px[p] = _points[p].X();
+    py[p] = _points[p].Y();
+  }
+
+  this->data->SnapshotAt(_time, _timeInit).ComputeDepthBatch(
+      px.data(), py.data(), count, _depths.data());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Newton solve for the undisplaced position of the Gerstner wave
+/// surface point above (_px, _py).
+/// \param[in] _snapshot The wavefield at the query time.
+/// \param[in] _px x coordinate of the query point.
+/// \param[in] _py y coordinate of the query point.
+/// \param[in] _tol Tolerance on the residual.
+/// \param[in] _nmax Iteration limit.
+/// \param[in,out] _x Initial guess and solved x.
+/// \param[in,out] _y Initial guess and solved y.
+/// \param[out] _iterations Number of iterations taken.
+/// \return The wave height pz at the point.
+static double SolveGerstner(const WavefieldSnapshot &_snapshot,
+  double _px, double _py, double _tol, size_t _nmax,
+  double &_x, double &_y, size_t &_iterations)
+{
+  const auto &c = _snapshot.Components();
+  const auto &omegaT = _snapshot.OmegaT();
+  const size_t n = c.Size();
+
+  double pz = 0;
+  double err = 1;
+  _iterations = 0;
+  while (std::abs(err) > _tol && _iterations < _nmax)
+  {
+    // Target function F and Jacobian J at the current guess. pz, the
+    // z-component of the Gerstner wave, comes for free.
+    pz = 0;
+    double f0 = _px - _x;
+    double f1 = _py - _y;
+    double j00 = -1;
+    double j01 = 0;
+    double j11 = -1;
+    for (size_t i = 0; i < n; ++i)
     {
-      pz = fdfunc(x0, p, t, wp, F, J);
-      xn = x0 - J.inverse() * F;
-      x0 = xn;
-      err = F.norm();
-      n++;
+      const double dx = c.dx[i];
+      const double dy = c.dy[i];
+      const double a = c.a[i];
+      const double k = c.k[i];
+      const double theta = k * (_x * dx + _y * dy) - omegaT[i];
+      const double s = std::sin(theta);
+      const double cs = std::cos(theta);
+      const double qakc = c.q[i] * a * k * cs;
+      pz += a * cs;
+      f0 += a * dx * s;
+      f1 += a * dy * s;
+      j00 += qakc * dx * dx;
+      j01 += qakc * dx * dy;
+      j11 += qakc * dy * dy;
     }
-    return pz;
-  };
 
-  // Set up parameter references
-  WaveParams wp(
-    this->Amplitude_V(),
-    this->Wavenumber_V(),
-    this->AngularFrequency_V(),
-    this->Phase_V(),
-    this->Steepness_V(),
-    this->Direction_V());
+    // Closed form solve of the symmetric 2x2 system J d = F.
+    const double det = j00 * j11 - j01 * j01;
+    _x -= (j11 * f0 - j01 * f1) / det;
+    _y -= (j00 * f1 - j01 * f0) / det;
+    err = std::sqrt(f0 * f0 + f1 * f1);
+    _iterations++;
+  }
+  // Exponentially grow the waves
+  return pz * _snapshot.Ramp();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double Wavefield::ComputeDepthDirectly(const ignition::math::Vector3d &_point,
+  double _time, double _timeInit)
+{
+  // The FFT engine inverts its own horizontal displacement.
+  if (this->data->fft)
+    return this->data->FftDepth(_point, _time, _timeInit);
 
-  // Tolerances etc.
-  const double tol = 1.0E-10;
-  const double nmax = 30;
+  const auto &snapshot = this->data->SnapshotAt(_time, _timeInit);
 
   // Use the target point as the initial guess
   // (this is within sum{amplitudes} of the solution)
-  Eigen::Vector2d p2(_point.X(), _point.Y());
-  const double pz = solver(wave_fdf, p2, p2, _time, wp, tol, nmax);
-  // Removed so that height is reported relative to mean water level
-  // const double h = pz - _point.Z();
-  const double h = pz;
-  return h;
+  double x = _point.X();
+  double y = _point.Y();
+  size_t iterations;
+  // Height is reported relative to mean water level
+  return SolveGerstner(snapshot, _point.X(), _point.Y(), 1.0E-10, 30,
+      x, y, iterations);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WavefieldSnapshot::WavefieldSnapshot(
+  std::shared_ptr<const WavefieldComponents> _components,
+  double _time, double _timeInit, double _tau)
+  : components(std::move(_components))
+{
+  this->Update(_time, _timeInit, _tau);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldSnapshot::Update(double _time, double _timeInit, double _tau)
+{
+  this->time = _time;
+  this->timeInit = _timeInit;
+
+  // Exponentially grow the waves
+  this->ramp = 1 - exp(-1.0 * (_time - _timeInit) / _tau);
+
+  const size_t n = this->components->Size();
+  this->omegaT.resize(n);
+  this->cosOmegaT.resize(n);
+  this->sinOmegaT.resize(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    this->omegaT[i] = this->components->omega[i] * _time;
+    this->cosOmegaT[i] = std::cos(this->omegaT[i]);
+    this->sinOmegaT[i] = std::sin(this->omegaT[i]);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldSnapshot::Time() const
+{
+  return this->time;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldSnapshot::TimeInit() const
+{
+  return this->timeInit;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldSnapshot::Ramp() const
+{
+  return this->ramp;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const WavefieldComponents &WavefieldSnapshot::Components() const
+{
+  return *this->components;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const std::vector<double> &WavefieldSnapshot::OmegaT() const
+{
+  return this->omegaT;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const std::vector<double> &WavefieldSnapshot::CosOmegaT() const
+{
+  return this->cosOmegaT;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const std::vector<double> &WavefieldSnapshot::SinOmegaT() const
+{
+  return this->sinOmegaT;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldSnapshot::ComputeDepth(
+  const ignition::math::Vector3d &_point) const
+{
+  // cos(k.x - wt) with the cached wt, one cosine per component. The spatial
+  // phase of an arbitrary point is not cached, so angle addition with the
+  // cos/sin(wt) tables would cost a cosine and a sine instead.
+  const auto &c = *this->components;
+  const size_t n = c.Size();
+  double h = 0.0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    double dot = _point.X() * c.dx[i] + _point.Y() * c.dy[i];
+    double theta = c.k[i] * dot - this->omegaT[i];
+    h += c.a[i] * cos(theta);
+  }
+  return h * this->ramp;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldSnapshot::ComputeDepth(const ignition::math::Vector3d &_point,
+  size_t _count) const
+{
+  const auto &c = *this->components;
+  const size_t n = std::min(_count, c.Size());
+  double h = 0.0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    double dot = _point.X() * c.dx[i] + _point.Y() * c.dy[i];
+    double theta = c.k[i] * dot - this->omegaT[i];
+    h += c.a[i] * cos(theta);
+  }
+  return h * this->ramp;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WavefieldKinematics WavefieldSnapshot::ComputeKinematics(
+  const ignition::math::Vector3d &_point) const
+{
+  const auto &c = *this->components;
+  const size_t n = c.Size();
+  const double z = std::min(_point.Z(), 0.0);
+  WavefieldKinematics kin;
+  double u = 0.0;
+  double v = 0.0;
+  double w = 0.0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    const double dot = _point.X() * c.dx[i] + _point.Y() * c.dy[i];
+    const double theta = c.k[i] * dot - this->omegaT[i];
+    const double cs = std::cos(theta);
+    const double sn = std::sin(theta);
+    const double aks = c.a[i] * c.k[i] * sn;
+    kin.height += c.a[i] * cs;
+    kin.dhdx -= aks * c.dx[i];
+    kin.dhdy -= aks * c.dy[i];
+
+    const double aw = c.a[i] * c.omega[i] * std::exp(c.k[i] * z);
+    u += aw * cs * c.dx[i];
+    v += aw * cs * c.dy[i];
+    w += aw * sn;
+  }
+  kin.height *= this->ramp;
+  kin.dhdx *= this->ramp;
+  kin.dhdy *= this->ramp;
+  kin.velocity.Set(u * this->ramp, v * this->ramp, w * this->ramp);
+  return kin;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldSnapshot::ComputeDepthBatch(const double *_x, const double *_y,
+  size_t _count, double *_depths) const
+{
+  for (size_t p = 0; p < _count; ++p)
+    _depths[p] = 0.0;
+
+  // One pass per component over all points. The per-point arithmetic is the
+  // same as in ComputeDepth and components are accumulated in the same
+  // order, so both paths agree to within floating point contraction.
+  const auto &c = *this->components;
+  const size_t n = c.Size();
+  for (size_t i = 0; i < n; ++i)
+  {
+    const double a = c.a[i];
+    const double k = c.k[i];
+    const double dx = c.dx[i];
+    const double dy = c.dy[i];
+    const double omegaT = this->omegaT[i];
+    for (size_t p = 0; p < _count; ++p)
+    {
+      const double theta = k * (_x[p] * dx + _y[p] * dy) - omegaT;
+      _depths[p] += a * cos(theta);
+    }
+  }
+
+  for (size_t p = 0; p < _count; ++p)
+    _depths[p] *= this->ramp;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldError::Add(double _error)
+{
+  const double e = std::fabs(_error);
+  this->count++;
+  this->max = std::max(this->max, e);
+  this->sumSquared += e * e;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldError::Rms() const
+{
+  return this->count > 0 ? std::sqrt(this->sumSquared / this->count) : 0.0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldSolverStats::MeanIterations() const
+{
+  return this->solves > 0 ?
+      static_cast<double>(this->iterations) / this->solves : 0.0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WavefieldSolver::WavefieldSolver(Wavefield &_wavefield, size_t _count)
+  : wavefield(_wavefield), fft(_wavefield.Model() == "FFT")
+{
+  this->Resize(_count);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldSolver::Resize(size_t _count)
+{
+  this->solvedX.assign(_count, 0.0);
+  this->solvedY.assign(_count, 0.0);
+  this->queryX.assign(_count, 0.0);
+  this->queryY.assign(_count, 0.0);
+  this->valid.assign(_count, false);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t WavefieldSolver::Size() const
+{
+  return this->valid.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldSolver::SetTolerance(double _tolerance)
+{
+  this->tolerance = _tolerance;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldSolver::SetMaxIterations(size_t _maxIterations)
+{
+  this->maxIterations = _maxIterations;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldSolver::Reset()
+{
+  this->fft = this->wavefield.Model() == "FFT";
+  std::fill(this->valid.begin(), this->valid.end(), false);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldSolver::ComputeDepth(size_t _sample,
+  const ignition::math::Vector3d &_point, double _time, double _timeInit)
+{
+  if (_sample >= this->valid.size())
+    this->Resize(_sample + 1);
+
+  if (this->fft)
+    return this->wavefield.ComputeDepthDirectly(_point, _time, _timeInit);
+
+  auto snapshot = this->wavefield.Snapshot(_time, _timeInit);
+
+  // Start from the previous solution moved along with the sample, or from
+  // the query point itself.
+  double x = _point.X();
+  double y = _point.Y();
+  if (this->valid[_sample])
+  {
+    x = this->solvedX[_sample] + _point.X() - this->queryX[_sample];
+    y = this->solvedY[_sample] + _point.Y() - this->queryY[_sample];
+  }
+
+  size_t iterations;
+  const double pz = SolveGerstner(*snapshot, _point.X(), _point.Y(),
+      this->tolerance, this->maxIterations, x, y, iterations);
+
+  this->stats.solves++;
+  this->stats.iterations += iterations;
+  this->stats.maxIterations = std::max(this->stats.maxIterations, iterations);
+  if (iterations >= this->maxIterations)
+    this->stats.unconverged++;
+
+  // Don't carry a diverged solution into the next step.
+  this->valid[_sample] = std::isfinite(x) && std::isfinite(y);
+  this->solvedX[_sample] = x;
+  this->solvedY[_sample] = y;
+  this->queryX[_sample] = _point.X();
+  this->queryY[_sample] = _point.Y();
+  return pz;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const WavefieldSolverStats &WavefieldSolver::Stats() const
+{
+  return this->stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldSolver::ResetStats()
+{
+  this->stats = WavefieldSolverStats();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t WavefieldComponents::Truncation(double _maxError) const
+{
+  // tail is non-increasing, find the first entry within the bound.
+  size_t count = 0;
+  while (count < this->Size() && this->tail[count] > _maxError)
+    ++count;
+  return count;
 }
@@ -18,10 +18,14 @@
 #ifndef IGNITION_GAZEBO_WAVEFIELD_HH_
 #define IGNITION_GAZEBO_WAVEFIELD_HH_
 
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Entity.hh>
 #include <ignition/math/Vector2.hh>
 #include <ignition/math/Vector3.hh>
 #include <sdf/sdf.hh>
@@ -35,6 +39,180 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
   /// \brief Class to hold private data for Wavefield.
   class WavefieldPrivate;
 
+  /// \brief The component waves of a wavefield in a structure-of-arrays
+  /// layout. A Wavefield publishes a new instance whenever its components are
+  /// recalculated and never modifies a published one.
+  ///
+  /// Components are sorted by decreasing amplitude, so the first K of them
+  /// are the best K component approximation of the wavefield.
+  struct WavefieldComponents
+  {
+    /// \brief Component amplitudes [m].
+    std::vector<double> a;
+
+    /// \brief Component wavenumbers [1/m].
+    std::vector<double> k;
+
+    /// \brief Component angular frequencies [rad/s].
+    std::vector<double> omega;
+
+    /// \brief Component steepness factors.
+    std::vector<double> q;
+
+    /// \brief x component of the component directions.
+    std::vector<double> dx;
+
+    /// \brief y component of the component directions.
+    std::vector<double> dy;
+
+    /// \brief Sum of the amplitudes of components i and after [m], with a
+    /// trailing zero.
+    std::vector<double> tail;
+
+    /// \brief The number of components.
+    public: size_t Size() const { return this->a.size(); }
+
+    /// \brief The number of leading components needed to keep the height
+    /// error below a bound. The error of dropping the rest is at most the
+    /// sum of their amplitudes.
+    /// \param[in] _maxError The error bound [m].
+    /// \return The number of components.
+    public: size_t Truncation(double _maxError) const;
+  };
+
+  /// \brief Error statistics of an approximate wavefield query against the
+  /// exact component sum.
+  struct WavefieldError
+  {
+    /// \brief Number of samples.
+    size_t count{0};
+
+    /// \brief Largest absolute error [m].
+    double max{0.0};
+
+    /// \brief Sum of squared errors [m^2].
+    double sumSquared{0.0};
+
+    /// \brief Add a sample.
+    /// \param[in] _error Signed error of the sample [m].
+    void Add(double _error);
+
+    /// \brief Root mean square error [m].
+    double Rms() const;
+  };
+
+  /// \brief Linear wave kinematics at a point.
+  struct WavefieldKinematics
+  {
+    /// \brief Height of the surface above the mean water level [m].
+    double height{0.0};
+
+    /// \brief Slope of the surface along x.
+    double dhdx{0.0};
+
+    /// \brief Slope of the surface along y.
+    double dhdy{0.0};
+
+    /// \brief Water particle velocity [m/s].
+    ignition::math::Vector3d velocity;
+  };
+
+  /// \brief The time dependent terms of a wavefield at one instant.
+  ///
+  /// Each component contributes a * cos(k * (d . x) - omega * t) and the sum
+  /// is scaled by the start-up ramp 1 - exp(-(t - t0) / tau). The omega * t
+  /// terms and the ramp only depend on time, so a snapshot evaluates them
+  /// once and all point queries made during the same time step share them.
+  /// A point query still costs one cosine per component. cos(omega * t) and
+  /// sin(omega * t) are also kept for callers that cache the spatial phase
+  /// k * (d . x) of fixed sample points, such as the height grid, and
+  /// combine both by angle addition without any cosine per sample.
+  class WavefieldSnapshot
+  {
+    /// \brief Constructor.
+    /// \param[in] _components The wave components.
+    /// \param[in] _time       The time of the snapshot.
+    /// \param[in] _timeInit   The time at which the wavefield started.
+    /// \param[in] _tau        Time constant of the start-up ramp.
+    public: WavefieldSnapshot(
+                std::shared_ptr<const WavefieldComponents> _components,
+                double _time, double _timeInit, double _tau);
+
+    /// \brief Move the snapshot to another time, reusing its buffers.
+    /// \param[in] _time       The time of the snapshot.
+    /// \param[in] _timeInit   The time at which the wavefield started.
+    /// \param[in] _tau        Time constant of the start-up ramp.
+    public: void Update(double _time, double _timeInit, double _tau);
+
+    /// \brief The time of the snapshot.
+    public: double Time() const;
+
+    /// \brief The time at which the wavefield started.
+    public: double TimeInit() const;
+
+    /// \brief The start-up ramp factor in [0, 1].
+    public: double Ramp() const;
+
+    /// \brief The components the snapshot was taken from.
+    public: const WavefieldComponents &Components() const;
+
+    /// \brief omega * t for each component.
+    public: const std::vector<double> &OmegaT() const;
+
+    /// \brief cos(omega * t) for each component.
+    public: const std::vector<double> &CosOmegaT() const;
+
+    /// \brief sin(omega * t) for each component.
+    public: const std::vector<double> &SinOmegaT() const;
+
+    /// \brief Wave height at a point, see Wavefield::ComputeDepthSimply.
+    /// \param[in] _point The point at which we want the depth.
+    /// \return The depth 'h' at the point.
+    public: double ComputeDepth(const ignition::math::Vector3d &_point) const;
+
+    /// \brief Wave height at a point using only the first components.
+    /// \param[in] _point The point at which we want the depth.
+    /// \param[in] _count Number of components to sum.
+    /// \return The depth 'h' at the point.
+    public: double ComputeDepth(const ignition::math::Vector3d &_point,
+                size_t _count) const;
+
+    /// \brief Wave kinematics at a point, see Wavefield::ComputeKinematics.
+    /// \param[in] _point The point at which we want the kinematics.
+    /// \return The kinematics at the point.
+    public: WavefieldKinematics ComputeKinematics(
+                const ignition::math::Vector3d &_point) const;
+
+    /// \brief Wave height at many points, see Wavefield::ComputeDepthBatch.
+    /// \param[in] _x      x coordinates of the points.
+    /// \param[in] _y      y coordinates of the points.
+    /// \param[in] _count  Number of points.
+    /// \param[out] _depths The depth 'h' at each point.
+    public: void ComputeDepthBatch(const double *_x, const double *_y,
+                size_t _count, double *_depths) const;
+
+    /// \brief The wave components.
+    private: std::shared_ptr<const WavefieldComponents> components;
+
+    /// \brief Time of the snapshot.
+    private: double time;
+
+    /// \brief Start time of the wavefield.
+    private: double timeInit;
+
+    /// \brief Start-up ramp factor.
+    private: double ramp;
+
+    /// \brief omega * t per component.
+    private: std::vector<double> omegaT;
+
+    /// \brief cos(omega * t) per component.
+    private: std::vector<double> cosOmegaT;
+
+    /// \brief sin(omega * t) per component.
+    private: std::vector<double> sinOmegaT;
+  };
+
   /// \brief A class to generate a wave field.
   /// This is a port from https://github.com/srmainwaring/asv_wave_sim
   ///
@@ -49,7 +227,9 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
   ///   A two component vector for the number of grid cells in each direction.
   ///
   /// * `<number>` (int, default: 1)
-  ///   The number of component waves.
+  ///   The number of component waves. With the PMS model, more than three
+  ///   components spread the frequencies and directions evenly over the
+  ///   same range as three components do.
   ///
   /// * `<scale>` (double, default: 2.0)
   ///   The scale between the mean and largest / smallest component waves.
@@ -77,7 +257,9 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
   ///
   /// * `<model>` (string, default: default)
   ///   The model used to generate component waves.
-  ///   Should be either "PMS" or "CWR"
+  ///   Should be "PMS", "CWR" or "FFT". FFT synthesizes the surface from the
+  ///   PMS parameters (`gain`, `period`, `direction`, `angle`) with an
+  ///   inverse FFT, see WavefieldFFT, and uses `steepness` as choppiness.
   ///
   /// * `<gain>` (double, default: 1.0)
   ///   For PMS, the multiplier applied to component amplitudes.
@@ -85,6 +267,53 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
   /// * `<tau>` (double, default: 1.0)
   ///   Time constant used to gradually increase wavefield at startup.
   ///
+  /// ## Optional FFT parameters
+  ///
+  /// Used when `<model>` is FFT, inside an `<fft>` element.
+  ///
+  /// * `<resolution>` (int, default: 64)
+  ///   Number of grid nodes along each side, a power of two.
+  ///
+  /// * `<patch_size>` (double, default: 8 mean wavelengths)
+  ///   Side length [m] of the periodic patch.
+  ///
+  /// * `<seed>` (int, default: 0)
+  ///   Seed of the random spectrum realisation.
+  ///
+  /// ## Optional grid cache
+  ///
+  /// If `<grid_cache>` is present, ComputeDepth looks heights up in a
+  /// heightfield covering `<size>` with `<cell_count>` cells instead of
+  /// summing the components. The field is split into tiles which are only
+  /// rasterized when a query touches them.
+  ///
+  /// * `<refresh_rate>` (double, default: 0)
+  ///   Rate [Hz] at which tiles are rebuilt. 0 rebuilds on every new time.
+  ///
+  /// * `<tile_size>` (int, default: 16)
+  ///   Number of grid nodes per tile side.
+  ///
+  /// * `<interpolation>` (string, default: bilinear)
+  ///   Either "bilinear" or "bicubic".
+  ///
+  /// * `<normals>` (bool, default: false)
+  ///   Also cache the height gradient used by ComputeNormal.
+  ///
+  /// * `<error_sample_period>` (int, default: 100)
+  ///   Every this many lookups the cached height is compared against
+  ///   ComputeDepthSimply, see GridCacheError. 0 disables the check.
+  ///
+  /// ## Threading
+  ///
+  /// A world shares one Wavefield between its systems. The depth queries
+  /// update a snapshot cache, the grid cache, the FFT surface and scratch
+  /// buffers without locking, so they, Snapshot and ApplyPendingUpdate must
+  /// only be called from the simulation thread. Worker threads query a
+  /// WavefieldSnapshot taken on the simulation thread instead, whose const
+  /// methods are safe to call concurrently and which is not modified while
+  /// a caller holds it. Components, Revision and SetSeaState are safe to
+  /// call from any thread.
+  ///
   /// ## Example
   /// <wavefield>
   ///   <size>1000 1000</size>
@@ -115,6 +344,35 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
     /// \param[in] _sdf The SDF Element tree containing the wavefield parameters
     public: void Load(const std::shared_ptr<const sdf::Element> &_sdf);
 
+    /// \brief Get the wavefield shared by all plugins of a world that load
+    /// the same `<wavefield>` parameters, loading it on first use.
+    ///
+    /// The components are only recalculated, and the `/mbzirc/wavefield`
+    /// service only queried, once per world and parameter set instead of
+    /// once per plugin. The wavefield is released when the last handle goes.
+    /// \param[in] _world The world entity.
+    /// \param[in] _sdf The SDF Element tree containing the wavefield parameters
+    /// \return The shared wavefield.
+    public: static std::shared_ptr<Wavefield> Acquire(Entity _world,
+                const std::shared_ptr<const sdf::Element> &_sdf);
+
+    /// \brief Get a wavefield already loaded by Acquire.
+    /// \param[in] _world The world entity.
+    /// \param[in] _key The key of the wavefield parameters, see Key.
+    /// \return The shared wavefield, null if none is loaded.
+    public: static std::shared_ptr<Wavefield> Find(Entity _world,
+                const std::string &_key);
+
+    /// \brief Key identifying the `<wavefield>` parameters of an SDF
+    /// element, wavefields with the same key are shared by Acquire.
+    /// \param[in] _sdf The SDF Element tree containing the wavefield parameters
+    /// \return The key.
+    public: static std::string Key(
+                const std::shared_ptr<const sdf::Element> &_sdf);
+
+    /// \brief The name of the wavefield model.
+    public: std::string Model() const;
+
     /// \brief The number of wave components (3 max if visualisation required).
     public: size_t Number() const;
 
@@ -158,6 +416,44 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
     /// of the mean wave.
     public: ignition::math::Vector2d Direction() const;
 
+    /// \brief The size of the wave field in each direction [m].
+    public: ignition::math::Vector2d Size() const;
+
+    /// \brief The number of grid cells in each direction.
+    public: ignition::math::Vector2d CellCount() const;
+
+    /// \brief Set the size of the wave field.
+    ///
+    /// \param[in] _size The size in each direction [m].
+    public: void SetSize(const ignition::math::Vector2d &_size);
+
+    /// \brief Set the number of grid cells.
+    ///
+    /// \param[in] _cellCount The number of cells in each direction.
+    public: void SetCellCount(const ignition::math::Vector2d &_cellCount);
+
+    /// \brief Enable or disable the heightfield cache used by ComputeDepth.
+    ///
+    /// \param[in] _enable True to enable the cache.
+    /// \param[in] _refreshRate Tile refresh rate [Hz], 0 for every new time.
+    /// \param[in] _interpolation Either "bilinear" or "bicubic".
+    /// \param[in] _normals True to also cache the height gradient.
+    public: void SetGridCache(bool _enable, double _refreshRate = 0.0,
+                const std::string &_interpolation = "bilinear",
+                bool _normals = false);
+
+    /// \brief Whether the heightfield cache is enabled.
+    public: bool GridCacheEnabled() const;
+
+    /// \brief Error of the cached heights against ComputeDepthSimply,
+    /// sampled every `<error_sample_period>` lookups.
+    public: WavefieldError GridCacheError() const;
+
+    /// \brief Set the wavefield model.
+    ///
+    /// \param[in] _model Either "PMS", "CWR" or "FFT".
+    public: void SetModel(const std::string &_model);
+
     /// \brief Set the number of wave components (3 max).
     ///
     /// \param[in] _number The number of component waves.
@@ -229,6 +525,46 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
     /// \brief Access the component directions.
     public: const std::vector<ignition::math::Vector2d> &Direction_V() const;
 
+    /// \brief Access the packed wave components. Safe to call from any
+    /// thread; the returned components are never modified.
+    public: std::shared_ptr<const WavefieldComponents> Components() const;
+
+    /// \brief Number of times the components have been recalculated.
+    /// Consumers that upload the components elsewhere, e.g. to a shader,
+    /// compare it to the revision they uploaded. Safe to call from any
+    /// thread.
+    public: uint64_t Revision() const;
+
+    /// \brief Queue a new sea state. Safe to call from any thread. The
+    /// update takes effect at the next ApplyPendingUpdate call.
+    ///
+    /// A loaded wavefield also receives updates on the
+    /// `/mbzirc/wavefield/update` topic as an ignition::msgs::Float_V
+    /// holding [gain, period] or [gain, period, direction x, direction y].
+    /// \param[in] _gain The multiplier applied to PM spectra.
+    /// \param[in] _period The mean wave period [s].
+    /// \param[in] _direction The mean wave direction, or zero to keep the
+    /// current one.
+    public: void SetSeaState(double _gain, double _period,
+                const ignition::math::Vector2d &_direction =
+                ignition::math::Vector2d::Zero);
+
+    /// \brief Apply a queued sea state, if any. Meant to be called by each
+    /// consumer at the start of a step so all queries of a step see the same
+    /// components; the recalculation only happens for the first caller.
+    /// \return True if an update was applied by this call.
+    public: bool ApplyPendingUpdate();
+
+    /// \brief Get the time dependent terms of the wavefield at a given time.
+    ///
+    /// The last snapshot is cached, so every query made during the same
+    /// time step reuses the same precomputation.
+    /// \param[in] _time       The time of the snapshot.
+    /// \param[in] _timeInit   The time at which we want the wavefield to start
+    /// \return The snapshot.
+    public: std::shared_ptr<const WavefieldSnapshot> Snapshot(
+                double _time, double _timeInit = 0);
+
     /// \brief Print a summary of the wave parameters to the gzmsg stream.
     public: void DebugPrint() const;
 
@@ -245,6 +581,93 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
             double _time,
             double _timeInit = 0);
 
+    /// \brief Compute the depth at a point using the heightfield cache if it
+    /// is enabled and covers the point, otherwise ComputeDepthSimply.
+    /// \param[in] _point       The point at which we want the depth.
+    /// \param[in] _time        The time at which we want the depth.
+    /// \param[in] _timeInit    The time at which we want the wavefield to start
+    /// \return                 The depth 'h' at the point.
+    public: double ComputeDepth(
+            const ignition::math::Vector3d &_point,
+            double _time,
+            double _timeInit = 0);
+
+    /// \brief Compute the depth at a point with only as many components as
+    /// needed to stay within an error bound, largest amplitude first.
+    ///
+    /// Every `lodErrorSamplePeriod` queries of each level of detail, i.e.
+    /// number of components used, the result is compared against the full
+    /// sum, see LodError. The FFT model and the grid cache are already
+    /// independent of the component count and ignore the bound.
+    /// \param[in] _point       The point at which we want the depth.
+    /// \param[in] _maxError    Error bound [m].
+    /// \param[in] _time        The time at which we want the depth.
+    /// \param[in] _timeInit    The time at which we want the wavefield to start
+    /// \return                 The depth 'h' at the point.
+    public: double ComputeDepthLod(
+            const ignition::math::Vector3d &_point,
+            double _maxError,
+            double _time,
+            double _timeInit = 0);
+
+    /// \brief Sampled error of ComputeDepthLod for each level of detail,
+    /// keyed by the number of components used.
+    /// \return The error statistics.
+    public: std::map<size_t, WavefieldError> LodError() const;
+
+    /// \brief Set how often ComputeDepthLod checks itself against the full
+    /// sum.
+    /// \param[in] _period Check every this many queries of a level of
+    /// detail. 0 disables the check.
+    public: void SetLodErrorSamplePeriod(unsigned int _period);
+
+    /// \brief Compute the unit normal of the wave surface at a point, using
+    /// the cached gradient if available.
+    /// \param[in] _point       The point at which we want the normal.
+    /// \param[in] _time        The time at which we want the normal.
+    /// \param[in] _timeInit    The time at which we want the wavefield to start
+    /// \return                 The surface normal.
+    public: ignition::math::Vector3d ComputeNormal(
+            const ignition::math::Vector3d &_point,
+            double _time,
+            double _timeInit = 0);
+
+    /// \brief Compute the surface height, its slope and the water particle
+    /// velocity at a point from a single evaluation of each component.
+    ///
+    /// Uses linear (Airy) wave theory: each component a cos(theta) moves
+    /// the water with horizontal velocity a omega e^{kz} cos(theta) along
+    /// its direction and vertical velocity a omega e^{kz} sin(theta), where
+    /// z is the depth of the point below the mean water level, clamped to 0
+    /// above it. The height and slope match ComputeDepthSimply. For the
+    /// FFT model only the height and slope are computed.
+    /// \param[in] _point       The point at which we want the kinematics.
+    /// \param[in] _time        The time at which we want the kinematics.
+    /// \param[in] _timeInit    The time at which we want the wavefield to start
+    /// \return                 The kinematics at the point.
+    public: WavefieldKinematics ComputeKinematics(
+            const ignition::math::Vector3d &_point,
+            double _time,
+            double _timeInit = 0);
+
+    /// \brief Batched version of ComputeDepthSimply.
+    ///
+    /// Evaluates the depth at many points in a single pass over the wave
+    /// components, which keeps the component parameters in registers and
+    /// streams the points through contiguous memory. Results agree with
+    /// calling ComputeDepthSimply on each point to within rounding.
+    ///
+    /// \param[in] _points      The points at which we want the depth.
+    /// \param[in] _time        The time at which we want the depth.
+    /// \param[out] _depths     The depth 'h' at each point. Resized to match
+    ///                         _points.
+    /// \param[in] _timeInit    The time at which we want the wavefield to start
+    public: void ComputeDepthBatch(
+            const std::vector<ignition::math::Vector3d> &_points,
+            double _time,
+            std::vector<double> &_depths,
+            double _timeInit = 0);
+
     /// \brief Compute the depth at a point directly
     /// (no sampling or interpolation).
     ///
@@ -273,6 +696,105 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
     /// \brief Pointer to the class private data.
     private: std::unique_ptr<WavefieldPrivate> data;
   };
+
+  /// \brief Iteration statistics of a WavefieldSolver.
+  struct WavefieldSolverStats
+  {
+    /// \brief Number of solves.
+    size_t solves{0};
+
+    /// \brief Total number of Newton iterations.
+    size_t iterations{0};
+
+    /// \brief Largest number of iterations taken by a single solve.
+    size_t maxIterations{0};
+
+    /// \brief Number of solves that hit the iteration limit.
+    size_t unconverged{0};
+
+    /// \brief Mean number of iterations per solve.
+    double MeanIterations() const;
+  };
+
+  /// \brief Stateful version of Wavefield::ComputeDepthDirectly for a fixed
+  /// set of sample points, e.g. the hull samples of a vessel.
+  ///
+  /// Each sample keeps the undisplaced position solved for in the previous
+  /// query, shifted by how far the sample moved, as the initial guess of
+  /// the next Newton iteration. Samples only move a little between steps so
+  /// this typically converges in one or two iterations instead of several.
+  class WavefieldSolver
+  {
+    /// \brief Constructor.
+    /// \param[in] _wavefield The wavefield to query. Must outlive the
+    /// solver.
+    /// \param[in] _count Number of sample points.
+    public: WavefieldSolver(Wavefield &_wavefield, size_t _count = 0);
+
+    /// \brief Set the number of sample points. Drops any warm start state.
+    /// \param[in] _count Number of sample points.
+    public: void Resize(size_t _count);
+
+    /// \brief Number of sample points.
+    /// \return The number of sample points.
+    public: size_t Size() const;
+
+    /// \brief Set the convergence tolerance on the horizontal residual [m].
+    /// \param[in] _tolerance The tolerance.
+    public: void SetTolerance(double _tolerance);
+
+    /// \brief Set the iteration limit of a single solve.
+    /// \param[in] _maxIterations The iteration limit.
+    public: void SetMaxIterations(size_t _maxIterations);
+
+    /// \brief Forget the warm start state, e.g. after a vessel is moved.
+    /// Also picks up a change of the wavefield model.
+    public: void Reset();
+
+    /// \brief Compute the depth at a sample point.
+    /// \param[in] _sample Index of the sample point.
+    /// \param[in] _point  The current position of the sample.
+    /// \param[in] _time   The time at which we want the depth.
+    /// \param[in] _timeInit The time at which we want the wavefield to start
+    /// \return The depth 'h' at the point, as ComputeDepthDirectly.
+    public: double ComputeDepth(size_t _sample,
+                const ignition::math::Vector3d &_point,
+                double _time, double _timeInit = 0);
+
+    /// \brief Iteration statistics since construction or ResetStats.
+    /// \return The statistics.
+    public: const WavefieldSolverStats &Stats() const;
+
+    /// \brief Clear the iteration statistics.
+    public: void ResetStats();
+
+    /// \brief The wavefield.
+    private: Wavefield &wavefield;
+
+    /// \brief Whether the wavefield uses the FFT model, which has no
+    /// Gerstner solve. Cached so queries don't compare the model name.
+    private: bool fft{false};
+
+    /// \brief Convergence tolerance [m].
+    private: double tolerance{1.0e-10};
+
+    /// \brief Iteration limit.
+    private: size_t maxIterations{30};
+
+    /// \brief Solved undisplaced position of each sample.
+    private: std::vector<double> solvedX;
+    private: std::vector<double> solvedY;
+
+    /// \brief Query position of each sample when it was last solved.
+    private: std::vector<double> queryX;
+    private: std::vector<double> queryY;
+
+    /// \brief Whether each sample has warm start state.
+    private: std::vector<bool> valid;
+
+    /// \brief Iteration statistics.
+    private: WavefieldSolverStats stats;
+  };
 }
 }
 }
@@ -0,0 +1,476 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <ignition/common/Console.hh>
+
+#include "CounterRng.hh"
+#include "WavefieldFFT.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+using Complex = std::complex<double>;
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief In place radix-2 FFT on the rows and columns of a square array.
+class Fft2d
+{
+  /// \brief Prepare bit reversal and twiddle tables.
+  /// \param[in] _n Side length, a power of two.
+  public: void Reset(size_t _n)
+  {
+    this->n = _n;
+    this->reversed.resize(_n);
+    size_t bits = 0;
+    while ((size_t(1) << bits) < _n)
+      ++bits;
+    for (size_t i = 0; i < _n; ++i)
+    {
+      size_t r = 0;
+      for (size_t b = 0; b < bits; ++b)
+        r |= ((i >> b) & 1) << (bits - 1 - b);
+      this->reversed[i] = r;
+    }
+
+    // Twiddles for the inverse transform, exp(+2 pi i k / n).
+    this->twiddles.resize(_n / 2);
+    for (size_t k = 0; k < _n / 2; ++k)
+      this->twiddles[k] = std::polar(1.0, 2.0 * M_PI * k / _n);
+    this->line.resize(_n);
+  }
+
+  /// \brief Unnormalized inverse transform of a row major n x n array.
+  /// \param[in,out] _data The array.
+  public: void Inverse(std::vector<Complex> &_data)
+  {
+    for (size_t row = 0; row < this->n; ++row)
+      this->Transform(&_data[row * this->n], 1);
+    for (size_t col = 0; col < this->n; ++col)
+      this->Transform(&_data[col], this->n);
+  }
+
+  /// \brief Inverse transform of one strided line.
+  /// \param[in,out] _data First element of the line.
+  /// \param[in] _stride Distance between elements.
+  private: void Transform(Complex *_data, size_t _stride)
+  {
+    for (size_t i = 0; i < this->n; ++i)
+      this->line[this->reversed[i]] = _data[i * _stride];
+
+    for (size_t len = 2; len <= this->n; len <<= 1)
+    {
+      const size_t half = len / 2;
+      const size_t step = this->n / len;
+      for (size_t start = 0; start < this->n; start += len)
+      {
+        for (size_t k = 0; k < half; ++k)
+        {
+          const Complex t = this->twiddles[k * step] *
+              this->line[start + k + half];
+          const Complex u = this->line[start + k];
+          this->line[start + k] = u + t;
+          this->line[start + k + half] = u - t;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < this->n; ++i)
+      _data[i * _stride] = this->line[i];
+  }
+
+  /// \brief Side length.
+  private: size_t n{0};
+
+  /// \brief Bit reversed index of each element.
+  private: std::vector<size_t> reversed;
+
+  /// \brief Twiddle factors.
+  private: std::vector<Complex> twiddles;
+
+  /// \brief Scratch line.
+  private: std::vector<Complex> line;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief Private data for WavefieldFFT.
+class ignition::gazebo::WavefieldFFTPrivate
+{
+  /// \brief Draw the initial spectrum amplitudes h0(k).
+  public: void Initialize()
+  {
+    const size_t n = this->resolution;
+    const size_t nn = n * n;
+    this->fft.Reset(n);
+    this->h0.assign(nn, Complex(0, 0));
+    this->omega.assign(nn, 0.0);
+    this->kx.assign(nn, 0.0);
+    this->ky.assign(nn, 0.0);
+    this->spectrum.resize(nn);
+    this->displacement.resize(nn);
+    this->heights.assign(nn, 0.0);
+    this->dispX.assign(nn, 0.0);
+    this->dispY.assign(nn, 0.0);
+    this->time = std::numeric_limits<double>::quiet_NaN();
+
+    if (this->period <= 0.0)
+      return;
+
+    const double g = 9.81;
+    const double dk = 2.0 * M_PI / this->patchSize;
+    const double omegaP = 2.0 * M_PI / this->period;
+    const double meanTheta = std::atan2(this->direction.Y(),
+        this->direction.X());
+    const double spread = std::max(this->angle, 1e-3);
+
+    // Normalization of the wrapped Gaussian spreading function.
+    double spreadNorm = 0.0;
+    const int spreadSamples = 360;
+    for (int i = 0; i < spreadSamples; ++i)
+    {
+      const double d = -M_PI + (i + 0.5) * 2.0 * M_PI / spreadSamples;
+      spreadNorm += std::exp(-0.5 * d * d / (spread * spread));
+    }
+    spreadNorm *= 2.0 * M_PI / spreadSamples;
+
+    // CounterRng rather than the standard library distributions, so a seed
+    // gives the same sea on every platform.
+    mbzirc::CounterRng rnd(this->seed);
+
+    const int half = static_cast<int>(n / 2);
+    for (size_t row = 0; row < n; ++row)
+    {
+      const int my = static_cast<int>(row) < half ?
+          static_cast<int>(row) : static_cast<int>(row) - static_cast<int>(n);
+      for (size_t col = 0; col < n; ++col)
+      {
+        const int mx = static_cast<int>(col) < half ?
+            static_cast<int>(col) : static_cast<int>(col) - static_cast<int>(n);
+        const size_t idx = row * n + col;
+        // Always draw so the realisation does not depend on which modes are
+        // discarded below.
+        const double xi0 = rnd.Normal(0.0, 1.0);
+        const double xi1 = rnd.Normal(0.0, 1.0);
+
+        this->kx[idx] = mx * dk;
+        this->ky[idx] = my * dk;
+        const double k = std::hypot(this->kx[idx], this->ky[idx]);
+        this->omega[idx] = std::sqrt(g * k);
+
+        // Skip the mean and the Nyquist modes, which cannot carry a
+        // travelling wave on this grid.
+        if ((mx == 0 && my == 0) || mx == -half || my == -half)
+          continue;
+
+        // Pierson-Moskowitz in omega, as used by the PMS model.
+        const double w = this->omega[idx];
+        const double alpha = 0.0081;
+        const double sOmega = alpha * g * g / std::pow(w, 5.0) *
+            std::exp(-(5.0 / 4.0) * std::pow(omegaP / w, 4.0));
+
+        // Convert to a wave vector spectrum: S(k) dk = S(w) dw with
+        // dw/dk = g / (2 w), and dkx dky = k dk dtheta.
+        double d = std::atan2(this->ky[idx], this->kx[idx]) - meanTheta;
+        d = std::remainder(d, 2.0 * M_PI);
+        const double spreading =
+            std::exp(-0.5 * d * d / (spread * spread)) / spreadNorm;
+        const double s = sOmega * g / (2.0 * w) * spreading / k;
+
+        // Each mode appears in h(k, t) and h(-k, t), so E|h0|^2 is half of
+        // the variance S(k) dk^2 of the real wave it represents.
+        this->h0[idx] = this->gain * Complex(xi0, xi1) *
+            std::sqrt(0.25 * s * dk * dk);
+      }
+    }
+  }
+
+  /// \brief Synthesize the fields at a time.
+  /// \param[in] _time Time [s].
+  public: void Synthesize(double _time)
+  {
+    const size_t n = this->resolution;
+    for (size_t row = 0; row < n; ++row)
+    {
+      const size_t negRow = (n - row) % n;
+      for (size_t col = 0; col < n; ++col)
+      {
+        const size_t idx = row * n + col;
+        const size_t neg = negRow * n + (n - col) % n;
+        const Complex e = std::polar(1.0, -this->omega[idx] * _time);
+        // h(k, t) = h0(k) e^{-iwt} + conj(h0(-k)) e^{iwt} is hermitian so
+        // the transform is real.
+        const Complex h = this->h0[idx] * e +
+            std::conj(this->h0[neg]) * std::conj(e);
+        const double k = std::hypot(this->kx[idx], this->ky[idx]);
+
+        // Pack height and x displacement into one transform, both real.
+        // D(k) = i k/|k| h(k) moves a component A cos(theta) by
+        // -k/|k| A sin(theta), towards its crests as in the Gerstner model.
+        Complex dx(0, 0);
+        Complex dy(0, 0);
+        if (k > 0.0)
+        {
+          dx = Complex(0, this->kx[idx] / k) * h;
+          dy = Complex(0, this->ky[idx] / k) * h;
+        }
+        this->spectrum[idx] = h + Complex(0, 1) * dx * this->choppiness;
+        this->displacement[idx] = dy * this->choppiness;
+      }
+    }
+
+    this->fft.Inverse(this->spectrum);
+    for (size_t i = 0; i < n * n; ++i)
+    {
+      this->heights[i] = this->spectrum[i].real();
+      this->dispX[i] = this->spectrum[i].imag();
+    }
+
+    if (this->choppiness != 0.0)
+    {
+      this->fft.Inverse(this->displacement);
+      for (size_t i = 0; i < n * n; ++i)
+        this->dispY[i] = this->displacement[i].real();
+    }
+    this->time = _time;
+  }
+
+  /// \brief Bilinear periodic interpolation of a node layer.
+  /// \param[in] _layer The node values.
+  /// \param[in] _x x coordinate [m].
+  /// \param[in] _y y coordinate [m].
+  /// \return The interpolated value.
+  public: double Sample(const std::vector<double> &_layer,
+                        double _x, double _y) const
+  {
+    const long n = static_cast<long>(this->resolution);
+    const double cell = this->patchSize / n;
+    const double u = _x / cell;
+    const double v = _y / cell;
+    const double fu = u - std::floor(u);
+    const double fv = v - std::floor(v);
+    const long c0 = ((static_cast<long>(std::floor(u)) % n) + n) % n;
+    const long r0 = ((static_cast<long>(std::floor(v)) % n) + n) % n;
+    const long c1 = (c0 + 1) % n;
+    const long r1 = (r0 + 1) % n;
+    return (_layer[r0 * n + c0] * (1 - fu) + _layer[r0 * n + c1] * fu) *
+        (1 - fv) +
+        (_layer[r1 * n + c0] * (1 - fu) + _layer[r1 * n + c1] * fu) * fv;
+  }
+
+  /// \brief Number of nodes along each side.
+  public: size_t resolution{64};
+
+  /// \brief Side length of the patch [m].
+  public: double patchSize{256.0};
+
+  /// \brief Random seed.
+  public: unsigned int seed{0};
+
+  /// \brief Horizontal displacement scale.
+  public: double choppiness{0.0};
+
+  /// \brief Amplitude multiplier.
+  public: double gain{1.0};
+
+  /// \brief Peak period [s].
+  public: double period{1.0};
+
+  /// \brief Mean direction.
+  public: ignition::math::Vector2d direction{1, 0};
+
+  /// \brief Directional spreading [rad].
+  public: double angle{2.0 * M_PI / 10.0};
+
+  /// \brief Time of the synthesized fields, NaN if none.
+  public: double time{std::numeric_limits<double>::quiet_NaN()};
+
+  /// \brief The transform.
+  public: Fft2d fft;
+
+  /// \brief Initial spectrum amplitudes.
+  public: std::vector<Complex> h0;
+
+  /// \brief Angular frequency of each mode.
+  public: std::vector<double> omega;
+
+  /// \brief Wave vector of each mode.
+  public: std::vector<double> kx;
+  public: std::vector<double> ky;
+
+  /// \brief Height and x displacement spectrum, transformed in place.
+  public: std::vector<Complex> spectrum;
+
+  /// \brief y displacement spectrum, transformed in place.
+  public: std::vector<Complex> displacement;
+
+  /// \brief Synthesized heights.
+  public: std::vector<double> heights;
+
+  /// \brief Synthesized horizontal displacements.
+  public: std::vector<double> dispX;
+  public: std::vector<double> dispY;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+WavefieldFFT::WavefieldFFT()
+  : data(std::make_unique<WavefieldFFTPrivate>())
+{
+  this->data->Initialize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+WavefieldFFT::~WavefieldFFT()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldFFT::SetResolution(size_t _resolution)
+{
+  size_t n = 2;
+  while (n < _resolution)
+    n <<= 1;
+  if (n != _resolution)
+  {
+    ignwarn << "FFT wavefield resolution [" << _resolution
+            << "] is not a power of two, using [" << n << "]" << std::endl;
+  }
+  this->data->resolution = n;
+  this->data->Initialize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+size_t WavefieldFFT::Resolution() const
+{
+  return this->data->resolution;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldFFT::SetPatchSize(double _size)
+{
+  if (_size <= 0.0)
+  {
+    ignerr << "FFT wavefield patch size must be positive" << std::endl;
+    return;
+  }
+  this->data->patchSize = _size;
+  this->data->Initialize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldFFT::PatchSize() const
+{
+  return this->data->patchSize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldFFT::SetSeed(unsigned int _seed)
+{
+  this->data->seed = _seed;
+  this->data->Initialize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldFFT::SetChoppiness(double _choppiness)
+{
+  this->data->choppiness = _choppiness;
+  this->data->time = std::numeric_limits<double>::quiet_NaN();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldFFT::SetSpectrum(double _gain, double _period,
+  const ignition::math::Vector2d &_direction, double _angle)
+{
+  this->data->gain = _gain;
+  this->data->period = _period;
+  this->data->direction = _direction;
+  this->data->angle = _angle;
+  this->data->Initialize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldFFT::SetWave(double _amplitude,
+  const ignition::math::Vector2d &_waveVector)
+{
+  const long n = static_cast<long>(this->data->resolution);
+  const double dk = 2.0 * M_PI / this->data->patchSize;
+  const long mx = std::lround(_waveVector.X() / dk);
+  const long my = std::lround(_waveVector.Y() / dk);
+  if ((mx == 0 && my == 0) || std::abs(mx) >= n / 2 || std::abs(my) >= n / 2)
+  {
+    ignerr << "FFT wavefield patch cannot represent wave vector ["
+           << _waveVector << "]" << std::endl;
+    return;
+  }
+
+  // A cos(k.x - wt) is h0 = A / 2 at k, Synthesize adds the mode at -k.
+  this->data->h0.assign(this->data->h0.size(), Complex(0, 0));
+  this->data->h0[((my + n) % n) * n + (mx + n) % n] =
+      Complex(0.5 * _amplitude, 0);
+  this->data->time = std::numeric_limits<double>::quiet_NaN();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void WavefieldFFT::Update(double _time)
+{
+  if (this->data->time == _time)
+    return;
+  this->data->Synthesize(_time);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+double WavefieldFFT::Height(double _x, double _y) const
+{
+  if (this->data->choppiness == 0.0)
+    return this->data->Sample(this->data->heights, _x, _y);
+
+  // Find the undisplaced position that is moved onto (_x, _y), as
+  // ComputeDepthDirectly does for the Gerstner model.
+  double x0 = _x;
+  double y0 = _y;
+  for (int i = 0; i < 4; ++i)
+  {
+    const double dx = this->data->Sample(this->data->dispX, x0, y0);
+    const double dy = this->data->Sample(this->data->dispY, x0, y0);
+    x0 = _x - dx;
+    y0 = _y - dy;
+  }
+  return this->data->Sample(this->data->heights, x0, y0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ignition::math::Vector2d WavefieldFFT::Gradient(double _x, double _y) const
+{
+  const double h = 0.5 * this->data->patchSize / this->data->resolution;
+  const auto &heights = this->data->heights;
+  return ignition::math::Vector2d(
+      (this->data->Sample(heights, _x + h, _y) -
+       this->data->Sample(heights, _x - h, _y)) / (2.0 * h),
+      (this->data->Sample(heights, _x, _y + h) -
+       this->data->Sample(heights, _x, _y - h)) / (2.0 * h));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const std::vector<double> &WavefieldFFT::Heights() const
+{
+  return this->data->heights;
+}
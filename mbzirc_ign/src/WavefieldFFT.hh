@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_GAZEBO_WAVEFIELDFFT_HH_
+#define IGNITION_GAZEBO_WAVEFIELDFFT_HH_
+
+#include <memory>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/math/Vector2.hh>
+
+namespace ignition
+{
+namespace gazebo
+{
+// Inline bracket to help doxygen filtering.
+inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+  /// \brief Class to hold private data for WavefieldFFT.
+  class WavefieldFFTPrivate;
+
+  /// \brief Ocean surface synthesized with an inverse FFT, following
+  /// Tessendorf, "Simulating Ocean Water".
+  ///
+  /// A random realisation of a directional Pierson-Moskowitz spectrum is
+  /// drawn once on a periodic square patch. Every time step the spectrum is
+  /// advanced with the deep water dispersion relation and transformed back
+  /// to a height and horizontal displacement field on an N x N grid, so the
+  /// cost per step is O(N^2 log N) regardless of how many spectral
+  /// components are represented. The patch tiles the plane.
+  ///
+  /// The height convention matches the sum of sinusoids models:
+  /// a component with wave vector k travels along k.
+  class WavefieldFFT
+  {
+    /// \brief Constructor.
+    public: WavefieldFFT();
+
+    /// \brief Destructor.
+    public: ~WavefieldFFT();
+
+    /// \brief Set the number of grid nodes along each side. Rounded up to a
+    /// power of two.
+    /// \param[in] _resolution Number of nodes along each side.
+    public: void SetResolution(size_t _resolution);
+
+    /// \brief Number of grid nodes along each side.
+    /// \return The resolution.
+    public: size_t Resolution() const;
+
+    /// \brief Set the side length of the periodic patch [m].
+    /// \param[in] _size Side length [m].
+    public: void SetPatchSize(double _size);
+
+    /// \brief Side length of the periodic patch [m].
+    /// \return The patch size.
+    public: double PatchSize() const;
+
+    /// \brief Set the seed of the random spectrum realisation.
+    /// \param[in] _seed The seed.
+    public: void SetSeed(unsigned int _seed);
+
+    /// \brief Set the horizontal displacement scale. 0 gives a pure height
+    /// field, 1 gives fully choppy (Gerstner like) crests.
+    /// \param[in] _choppiness The displacement scale.
+    public: void SetChoppiness(double _choppiness);
+
+    /// \brief Set the spectrum and draw a new realisation.
+    /// \param[in] _gain Multiplier applied to the wave amplitudes.
+    /// \param[in] _period Peak period of the Pierson-Moskowitz spectrum [s].
+    /// \param[in] _direction Mean wave direction.
+    /// \param[in] _angle Standard deviation of the directional spreading
+    /// about the mean direction [rad].
+    public: void SetSpectrum(double _gain, double _period,
+                const ignition::math::Vector2d &_direction, double _angle);
+
+    /// \brief Replace the spectrum with a single regular wave
+    /// A cos(k.x - w t), e.g. to compare with the sum of sinusoids models.
+    /// The wave vector is rounded to a multiple of 2 pi / PatchSize(). The
+    /// next call that draws a new realisation discards the wave.
+    /// \param[in] _amplitude Amplitude A [m].
+    /// \param[in] _waveVector Wave vector k [rad/m].
+    public: void SetWave(double _amplitude,
+                const ignition::math::Vector2d &_waveVector);
+
+    /// \brief Synthesize the fields at the given time. Does nothing if the
+    /// fields are already at that time.
+    /// \param[in] _time Time [s].
+    public: void Update(double _time);
+
+    /// \brief Height of the surface above a horizontal position, inverting
+    /// the horizontal displacement when the choppiness is non zero.
+    /// \param[in] _x x coordinate [m].
+    /// \param[in] _y y coordinate [m].
+    /// \return The height [m].
+    public: double Height(double _x, double _y) const;
+
+    /// \brief Gradient of the height field at a grid position.
+    /// \param[in] _x x coordinate [m].
+    /// \param[in] _y y coordinate [m].
+    /// \return dh/dx and dh/dy.
+    public: ignition::math::Vector2d Gradient(double _x, double _y) const;
+
+    /// \brief The synthesized heights at the grid nodes, row major with node
+    /// (i, j) at (i, j) * PatchSize() / Resolution().
+    /// \return The heights [m].
+    public: const std::vector<double> &Heights() const;
+
+    /// \internal
+    /// \brief Private data pointer.
+    private: std::unique_ptr<WavefieldFFTPrivate> data;
+  };
+}
+}
+}
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef MBZIRC_IGN__WRENCHTHROTTLE_HH_
+#define MBZIRC_IGN__WRENCHTHROTTLE_HH_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <ostream>
+
+#include <ignition/math/Vector3.hh>
+
+namespace mbzirc
+{
+/// \brief Error of the throttled wrench against the wrench computed at every
+/// step, accumulated over a report period.
+struct WrenchThrottleError
+{
+  /// \brief Number of steps the wrench was held.
+  int count = 0;
+
+  /// \brief Sum of the squared force errors [N^2].
+  double forceSquared = 0.0;
+
+  /// \brief Largest force error [N].
+  double forceMax = 0.0;
+
+  /// \brief Sum of the squared torque errors [N^2 m^2].
+  double torqueSquared = 0.0;
+
+  /// \brief Largest torque error [Nm].
+  double torqueMax = 0.0;
+
+  /// \brief Sum of the squared full rate force magnitudes [N^2].
+  double forceNormSquared = 0.0;
+
+  /// \brief Root mean square force error [N].
+  double ForceRms() const
+  {
+    return this->count ? std::sqrt(this->forceSquared / this->count) : 0.0;
+  }
+
+  /// \brief Root mean square torque error [Nm].
+  double TorqueRms() const
+  {
+    return this->count ? std::sqrt(this->torqueSquared / this->count) : 0.0;
+  }
+
+  /// \brief Root mean square force error relative to the root mean square
+  /// full rate force.
+  double ForceRelative() const
+  {
+    return this->forceNormSquared > 0.0 ?
+        std::sqrt(this->forceSquared / this->forceNormSquared) : 0.0;
+  }
+};
+
+/// \brief Stream insertion operator for the report.
+/// \param[in] _out The output stream.
+/// \param[in] _error The error.
+/// \return The stream.
+inline std::ostream &operator<<(std::ostream &_out,
+    const WrenchThrottleError &_error)
+{
+  _out << "force rms " << _error.ForceRms() << " N ("
+       << _error.ForceRelative() * 100.0 << "%), max " << _error.forceMax
+       << " N, torque rms " << _error.TorqueRms() << " Nm, max "
+       << _error.torqueMax << " Nm over " << _error.count << " held steps";
+  return _out;
+}
+
+/// \brief Runs a wrench computation below the physics rate. Between
+/// updates the last wrench is held, or linearly extrapolated from the last
+/// two updates. Optionally the wrench is still computed at every step to
+/// measure the error of the held wrench, which costs the full rate.
+///
+/// Usage in a PreUpdate:
+///
+///     if (!throttle.NeedsUpdate(simTime))
+///     {
+///       throttle.Hold(simTime, force, torque);
+///       // apply
+///       return;
+///     }
+///     // compute force and torque
+///     throttle.Filter(simTime, force, torque);
+///     // apply
+class WrenchThrottle
+{
+  /// \brief Clock used for the sim time.
+  public: using Duration = std::chrono::steady_clock::duration;
+
+  /// \brief Configure the throttle.
+  /// \param[in] _rate Update rate [Hz], zero or less for every step.
+  /// \param[in] _extrapolate Linearly extrapolate the wrench between
+  /// updates instead of holding it.
+  /// \param[in] _checkError Compute the wrench at every step anyway and
+  /// accumulate the error of the throttled wrench.
+  public: void Configure(double _rate, bool _extrapolate, bool _checkError)
+  {
+    std::chrono::duration<double> period{_rate > 0 ? 1 / _rate : 0};
+    this->updatePeriod = std::chrono::duration_cast<Duration>(period);
+    this->extrapolate = _extrapolate;
+    this->checkError = _checkError;
+  }
+
+  /// \brief Whether the wrench is computed below the physics rate.
+  public: bool Enabled() const
+  {
+    return this->updatePeriod > Duration::zero();
+  }
+
+  /// \brief Whether the wrench must be computed this step.
+  /// \param[in] _simTime Current sim time.
+  public: bool NeedsUpdate(const Duration &_simTime) const
+  {
+    return !this->Enabled() || this->checkError || this->Due(_simTime);
+  }
+
+  /// \brief Held or extrapolated wrench for a step without update.
+  /// \param[in] _simTime Current sim time.
+  /// \param[out] _force Force [N].
+  /// \param[out] _torque Torque [Nm].
+  public: void Hold(const Duration &_simTime,
+                    ignition::math::Vector3d &_force,
+                    ignition::math::Vector3d &_torque) const
+  {
+    _force = this->last.force;
+    _torque = this->last.torque;
+    if (!this->extrapolate || !this->previous)
+      return;
+
+    const double span =
+        std::chrono::duration<double>(this->last.time - this->previous->time)
+        .count();
+    if (span <= 0.0)
+      return;
+    const double s =
+        std::chrono::duration<double>(_simTime - this->last.time).count() /
+        span;
+    _force += (this->last.force - this->previous->force) * s;
+    _torque += (this->last.torque - this->previous->torque) * s;
+  }
+
+  /// \brief Pass a freshly computed wrench. On update steps it is kept and
+  /// returned unchanged, otherwise it only measures the error and is
+  /// replaced by the held wrench.
+  /// \param[in] _simTime Current sim time.
+  /// \param[in,out] _force Force [N].
+  /// \param[in,out] _torque Torque [Nm].
+  public: void Filter(const Duration &_simTime,
+                      ignition::math::Vector3d &_force,
+                      ignition::math::Vector3d &_torque)
+  {
+    if (!this->Enabled())
+      return;
+
+    if (this->Due(_simTime))
+    {
+      if (this->updated)
+        this->previous = this->last;
+      this->last = {_simTime, _force, _torque};
+      this->updated = true;
+      return;
+    }
+
+    ignition::math::Vector3d force;
+    ignition::math::Vector3d torque;
+    this->Hold(_simTime, force, torque);
+    const double forceError = (force - _force).Length();
+    const double torqueError = (torque - _torque).Length();
+    ++this->error.count;
+    this->error.forceSquared += forceError * forceError;
+    this->error.forceMax = std::max(this->error.forceMax, forceError);
+    this->error.torqueSquared += torqueError * torqueError;
+    this->error.torqueMax = std::max(this->error.torqueMax, torqueError);
+    this->error.forceNormSquared += _force.SquaredLength();
+    _force = force;
+    _torque = torque;
+  }
+
+  /// \brief Take the error accumulated since the last call, once per
+  /// report period.
+  /// \param[in] _simTime Current sim time.
+  /// \param[in] _period Report period.
+  /// \return The error, or nothing if the period has not elapsed or the
+  /// error is not checked.
+  public: std::optional<WrenchThrottleError> TakeError(
+              const Duration &_simTime, const Duration &_period)
+  {
+    if (!this->Enabled() || !this->checkError)
+      return std::nullopt;
+    if (!this->lastReportTime)
+      this->lastReportTime = _simTime;
+    if (_simTime - *this->lastReportTime < _period)
+      return std::nullopt;
+    this->lastReportTime = _simTime;
+    WrenchThrottleError result = this->error;
+    this->error = WrenchThrottleError();
+    return result;
+  }
+
+  /// \brief Whether an update is due.
+  /// \param[in] _simTime Current sim time.
+  private: bool Due(const Duration &_simTime) const
+  {
+    if (!this->updated)
+      return true;
+    const auto elapsed = _simTime - this->last.time;
+    return elapsed >= this->updatePeriod || elapsed < Duration::zero();
+  }
+
+  /// \brief A computed wrench.
+  private: struct Sample
+  {
+    /// \brief Sim time of the computation.
+    Duration time{0};
+
+    /// \brief Force [N].
+    ignition::math::Vector3d force;
+
+    /// \brief Torque [Nm].
+    ignition::math::Vector3d torque;
+  };
+
+  /// \brief Update period, zero for every step.
+  private: Duration updatePeriod{0};
+
+  /// \brief Whether the wrench is extrapolated between updates.
+  private: bool extrapolate = false;
+
+  /// \brief Whether the error against the full rate is measured.
+  private: bool checkError = false;
+
+  /// \brief Whether there was an update yet.
+  private: bool updated = false;
+
+  /// \brief Last update.
+  private: Sample last;
+
+  /// \brief Update before the last one.
+  private: std::optional<Sample> previous;
+
+  /// \brief Error accumulated since the last report.
+  private: WrenchThrottleError error;
+
+  /// \brief Sim time of the last report.
+  private: std::optional<Duration> lastReportTime;
+};
+}  // namespace mbzirc
+
+#endif  // MBZIRC_IGN__WRENCHTHROTTLE_HH_
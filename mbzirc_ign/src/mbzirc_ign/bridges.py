@@ -271,3 +271,12 @@ def stream_status():
         ign_type='ignition.msgs.StringMsg',
         ros_type='std_msgs/msg/String',
         direction=BridgeDirection.IGN_TO_ROS)
+
+
+def rf_range_diagnostics():
+    return Bridge(
+        ign_topic='/mbzirc/diagnostics/rf_range',
+        ros_topic='/mbzirc/diagnostics/rf_range',
+        ign_type='ignition.msgs.Param_V',
+        ros_type='ros_ign_interfaces/msg/ParamVec',
+        direction=BridgeDirection.IGN_TO_ROS)
@@ -73,6 +73,7 @@ def competition_bridges():
         mbzirc_ign.bridges.run_clock(),
         mbzirc_ign.bridges.phase(),
         mbzirc_ign.bridges.stream_status(),
+        mbzirc_ign.bridges.rf_range_diagnostics(),
     ]
     nodes = []
     nodes.append(Node(
@@ -70,6 +70,7 @@ class Model:
         self.arm = ''
         self.gripper = ''
         self.arm_slot = '0'
+        self.rf_range_compact = False
 
     def is_UAV(self):
         return self.model_type in UAVS
@@ -258,6 +259,22 @@ class Model:
                         arguments=['1'],
                         remappings=[('input/image', f'{ros_slot_prefix}/depth'),
                                     ('output/image', f'{ros_slot_prefix}/optical/depth')]))
+                elif (p['sensor'] in mbzirc_ign.payload_bridges.rfranger_models() and
+                      self.rf_range_compact):
+                    # Only useful when the RFRange system of the world has
+                    # <compact_output> enabled.
+                    ign_topic, peers_topic = \
+                        mbzirc_ign.payload_bridges.rfranger_compact_topics(
+                            world_name, self.model_name, index)
+                    nodes.append(Node(
+                        package='mbzirc_ros',
+                        executable='rf_range_bridge',
+                        parameters=[{'ign_topic': ign_topic,
+                                     'peers_topic': peers_topic}],
+                        remappings=[('rfsensor/compact',
+                                     f'{ros_slot_prefix}/rfsensor/compact'),
+                                    ('rfsensor/peers',
+                                     f'{ros_slot_prefix}/rfsensor/peers')]))
         return [bridges, nodes, payload_launches]
 
     def is_custom_model(self, model):
@@ -322,6 +339,10 @@ class Model:
     def set_gripper(self, gripper):
         self.gripper = gripper
 
+    def set_rf_range_compact(self, rf_range_compact):
+        # Bridge the compact RFRange output, see rf_range_bridge
+        self.rf_range_compact = str(rf_range_compact).lower() == 'true'
+
     def generate(self):
         # Generate SDF by executing ERB and populating templates
         template_file = os.path.join(
@@ -516,4 +537,7 @@ class Model:
         if 'gripper' in config:
             model.set_gripper(config['gripper'])
 
+        if 'rf_range_compact' in config:
+            model.set_rf_range_compact(config['rf_range_compact'])
+
         return model
@@ -119,6 +119,12 @@ def rfranger(world_name, model_name, slot_idx, model_prefix=''):
         direction=BridgeDirection.IGN_TO_ROS)
 
 
+def rfranger_compact_topics(world_name, model_name, slot_idx):
+    # ign topics of the RFRange compact output, bridged by rf_range_bridge
+    prefix = f'/world/{world_name}/model/{model_name}/model/sensor_{slot_idx}'
+    return (f'{prefix}/rfsensor/compact', f'/world/{world_name}/rfsensor/peers')
+
+
 def payload_bridges(world_name, model_name, payload, idx, model_prefix=''):
     bridges = []
     if payload in camera_models():
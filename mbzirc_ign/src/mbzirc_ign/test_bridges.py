@@ -189,6 +189,10 @@ class TestBridges(unittest.TestCase):
         self.assertEqual(bridge.argument(),
                          '/mbzirc/target/stream/status'
                          '@std_msgs/msg/String[ignition.msgs.StringMsg')
+        bridge = bridges.rf_range_diagnostics()
+        self.assertEqual(bridge.argument(),
+                         '/mbzirc/diagnostics/rf_range'
+                         '@ros_ign_interfaces/msg/ParamVec[ignition.msgs.Param_V')
 
 
 class TestPayloadBridges(unittest.TestCase):
@@ -263,6 +267,17 @@ class TestPayloadBridges(unittest.TestCase):
                          f'{self.prefix(self.arm_name)}/camera/points'
                          '@sensor_msgs/msg/PointCloud2[ignition.msgs.PointCloudPacked')
 
+    def test_rfranger(self):
+        prefix = f'/world/{self.world_name}/model/{self.model_name}/model/sensor_{self.idx}'
+        bridge = payload_bridges.rfranger(self.world_name, self.model_name, self.idx)
+        self.assertEqual(bridge.argument(),
+                         f'{prefix}/rfsensor'
+                         '@ros_ign_interfaces/msg/ParamVec[ignition.msgs.Param_V')
+        self.assertEqual(payload_bridges.rfranger_compact_topics(
+                             self.world_name, self.model_name, self.idx),
+                         (f'{prefix}/rfsensor/compact',
+                          f'/world/{self.world_name}/rfsensor/peers'))
+
     def test_payload_bridges(self):
         bridges = payload_bridges.payload_bridges(
             self.world_name, self.model_name, 'mbzirc_vga_camera', self.idx)
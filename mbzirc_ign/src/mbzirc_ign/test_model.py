@@ -179,3 +179,20 @@ class TestModel(unittest.TestCase):
             self.assertTrue('slot0' in mapping[1])
         self.assertEqual(len(payload_nodes2), 0)
         self.assertEqual(len(launch2), 0)
+
+    def test_rf_range_compact(self):
+        config = os.path.join(get_package_share_directory('mbzirc_ign'),
+                              'config', 'rf_check.yaml')
+        with open(config, 'r') as stream:
+            team = Model.FromConfig(stream)
+        model = team[0]
+        self.assertFalse(model.rf_range_compact)
+
+        [payload_bridges, payload_nodes, launch] = model.payload_bridges('test_world_name')
+        self.assertEqual(len(payload_nodes), 0)
+
+        model.set_rf_range_compact('true')
+        self.assertTrue(model.rf_range_compact)
+        [compact_bridges, compact_nodes, launch] = model.payload_bridges('test_world_name')
+        self.assertEqual(len(compact_bridges), len(payload_bridges))
+        self.assertEqual(len(compact_nodes), 1)
@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Benchmarks for the marine systems. Runs without a Gazebo server, on an
+// EntityComponentManager holding a world and N vessel models:
+//
+//   ./marine_benchmark --benchmark_counters_tabular=true
+//
+// The Surface and SimpleHydrodynamics systems are configured from the usv
+// model's plugin elements and stepped through PreUpdate, either per vessel
+// or fused in the MarineDynamics world system. Each benchmark reports
+// "time/vessel", the wall time of one step per vessel, and "allocs/step",
+// the heap allocations of one step. The vessel state written by the
+// physics between steps is not timed.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <ignition/gazebo/EntityComponentManager.hh>
+#include <ignition/gazebo/EventManager.hh>
+#include <ignition/gazebo/components/AngularAcceleration.hh>
+#include <ignition/gazebo/components/AngularVelocity.hh>
+#include <ignition/gazebo/components/ExternalWorldWrenchCmd.hh>
+#include <ignition/gazebo/components/Gravity.hh>
+#include <ignition/gazebo/components/Inertial.hh>
+#include <ignition/gazebo/components/LinearAcceleration.hh>
+#include <ignition/gazebo/components/LinearVelocity.hh>
+#include <ignition/gazebo/components/Link.hh>
+#include <ignition/gazebo/components/Model.hh>
+#include <ignition/gazebo/components/Name.hh>
+#include <ignition/gazebo/components/ParentEntity.hh>
+#include <ignition/gazebo/components/Pose.hh>
+#include <ignition/gazebo/components/World.hh>
+#include <ignition/math/Inertial.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Quaternion.hh>
+#include <ignition/math/Vector3.hh>
+#include <sdf/Model.hh>
+#include <sdf/Root.hh>
+#include <sdf/World.hh>
+
+#include "MarineDynamics.hh"
+#include "SimpleHydrodynamics.hh"
+#include "Surface.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/// \brief Number of heap allocations made through operator new.
+static std::atomic<size_t> gAllocations{0};
+
+/////////////////////////////////////////////////
+void *operator new(std::size_t _size)
+{
+  ++gAllocations;
+  if (void *ptr = std::malloc(_size ? _size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+/// \brief Plugin elements of the usv model, see models/usv/model.sdf.erb.
+static const char kVesselSdf[] = R"(
+<sdf version="1.8">
+  <model name="usv">
+    <link name="base_link"/>
+    <plugin filename="libSurface.so"
+            name="ignition::gazebo::systems::Surface">
+      <link_name>base_link</link_name>
+      <vehicle_length>6</vehicle_length>
+      <vehicle_width>3.3</vehicle_width>
+      <hull_radius>0.27</hull_radius>
+      <fluid_level>0.45</fluid_level>
+      <wavefield>
+        <size>1000 1000</size>
+        <cell_count>50 50</cell_count>
+        <wave>
+          <model>PMS</model>
+          <period>5</period>
+          <number>3</number>
+          <scale>1.1</scale>
+          <gain>0.3</gain>
+          <direction>1 0</direction>
+          <angle>0.4</angle>
+          <tau>2.0</tau>
+          <amplitude>0.3</amplitude>
+          <steepness>0.0</steepness>
+        </wave>
+      </wavefield>
+    </plugin>
+    <plugin filename="libSimpleHydrodynamics.so"
+            name="ignition::gazebo::systems::SimpleHydrodynamics">
+      <link_name>base_link</link_name>
+      <xDotU>0.0</xDotU>
+      <yDotV>0.0</yDotV>
+      <nDotR>0.0</nDotR>
+      <xU>51.3</xU>
+      <xUU>72.4</xUU>
+      <yV>40.0</yV>
+      <yVV>0.0</yVV>
+      <zW>500.0</zW>
+      <kP>100.0</kP>
+      <mQ>100.0</mQ>
+      <nR>400.0</nR>
+      <nRR>0.0</nRR>
+    </plugin>
+  </model>
+</sdf>)";
+
+/// \brief World plugin element of the MarineDynamics system.
+static const char kWorldSdf[] = R"(
+<sdf version="1.8">
+  <world name="benchmark">
+    <plugin filename="libMarineDynamics.so"
+            name="ignition::gazebo::systems::MarineDynamics">
+      <threads>2</threads>
+    </plugin>
+  </world>
+</sdf>)";
+
+/// \brief A world with N vessels and their marine systems.
+class MarineScene
+{
+  /// \brief Constructor.
+  /// \param[in] _vessels Number of vessels.
+  /// \param[in] _threads MarineDynamics worker threads, -1 to run the per
+  /// vessel systems instead.
+  public: MarineScene(int64_t _vessels, int64_t _threads)
+  {
+    sdf::Root root;
+    root.LoadSdfString(kVesselSdf);
+    auto plugin = root.Model()->Element()->GetElement("plugin");
+    const sdf::ElementPtr surfaceSdf = plugin;
+    const sdf::ElementPtr hydroSdf = plugin->GetNextElement("plugin");
+
+    this->world = this->ecm.CreateEntity();
+    this->ecm.CreateComponent(this->world, components::World());
+    this->ecm.CreateComponent(this->world, components::Name("benchmark"));
+    this->ecm.CreateComponent(this->world,
+        components::Gravity(math::Vector3d(0, 0, -9.8)));
+
+    // Vessels 20 m apart on a square grid, so each sees its own waves.
+    const int64_t side = std::max<int64_t>(1,
+        std::lround(std::ceil(std::sqrt(static_cast<double>(_vessels)))));
+    for (int64_t v = 0; v < _vessels; ++v)
+    {
+      const math::Pose3d pose(20.0 * (v % side), 20.0 * (v / side), 0,
+          0, 0, 0.3 * v);
+
+      const Entity model = this->ecm.CreateEntity();
+      this->ecm.CreateComponent(model, components::Model());
+      this->ecm.CreateComponent(model,
+          components::Name("usv_" + std::to_string(v)));
+      this->ecm.CreateComponent(model, components::ParentEntity(this->world));
+      this->ecm.CreateComponent(model, components::Pose(pose));
+
+      const Entity link = this->ecm.CreateEntity();
+      this->ecm.CreateComponent(link, components::Link());
+      this->ecm.CreateComponent(link, components::Name("base_link"));
+      this->ecm.CreateComponent(link, components::ParentEntity(model));
+      this->ecm.CreateComponent(link, components::Pose());
+      math::Inertiald inertial;
+      inertial.SetMassMatrix(math::MassMatrix3d(1000,
+          math::Vector3d(500, 2000, 2000), math::Vector3d::Zero));
+      this->ecm.CreateComponent(link, components::Inertial(inertial));
+      this->ecm.CreateComponent(link, components::WorldPose(pose));
+      this->links.push_back(link);
+      this->poses.push_back(pose);
+
+      auto surface = std::make_unique<systems::Surface>();
+      surface->Configure(model, surfaceSdf, this->ecm, this->events);
+      auto hydro = std::make_unique<systems::SimpleHydrodynamics>();
+      hydro->Configure(model, hydroSdf, this->ecm, this->events);
+      this->surfaces.push_back(std::move(surface));
+      this->hydrodynamics.push_back(std::move(hydro));
+    }
+
+    if (_threads >= 0)
+    {
+      sdf::Root worldRoot;
+      worldRoot.LoadSdfString(kWorldSdf);
+      auto marineSdf =
+          worldRoot.WorldByIndex(0)->Element()->GetElement("plugin");
+      marineSdf->GetElement("threads")->Set(static_cast<int>(_threads));
+      this->marine = std::make_unique<systems::MarineDynamics>();
+      this->marine->Configure(this->world, marineSdf, this->ecm,
+          this->events);
+    }
+
+    this->info.dt = std::chrono::milliseconds(1);
+    this->info.simTime = std::chrono::seconds(10);
+  }
+
+  /// \brief Stand-in for the physics: move the vessels along a heave,
+  /// roll and surge motion and advance the sim time.
+  public: void Physics()
+  {
+    ++this->info.iterations;
+    this->info.simTime += this->info.dt;
+    const double t = std::chrono::duration<double>(this->info.simTime).count();
+
+    for (size_t v = 0; v < this->links.size(); ++v)
+    {
+      const double phase = t + 0.7 * v;
+      const math::Pose3d pose(
+          this->poses[v].Pos() +
+          math::Vector3d(1.5 * t, 0, 0.2 * std::sin(phase)),
+          this->poses[v].Rot() * math::Quaterniond(
+          0.05 * std::sin(0.8 * phase), 0.02 * std::cos(phase), 0));
+      const Entity link = this->links[v];
+
+      // The physics consumes the wrenches of the last step.
+      auto wrench = this->ecm.Component<components::ExternalWorldWrenchCmd>(
+          link);
+      if (wrench)
+        wrench->Data().Clear();
+
+      this->ecm.SetComponentData<components::WorldPose>(link, pose);
+      this->ecm.SetComponentData<components::WorldLinearVelocity>(link,
+          math::Vector3d(1.5, 0, 0.2 * std::cos(phase)));
+      this->ecm.SetComponentData<components::AngularVelocity>(link,
+          math::Vector3d(0.04 * std::cos(0.8 * phase),
+          -0.02 * std::sin(phase), 0));
+      this->ecm.SetComponentData<components::WorldLinearAcceleration>(link,
+          math::Vector3d(0, 0, -0.2 * std::sin(phase)));
+      this->ecm.SetComponentData<components::AngularAcceleration>(link,
+          math::Vector3d(-0.032 * std::sin(0.8 * phase),
+          -0.02 * std::cos(phase), 0));
+    }
+  }
+
+  /// \brief Run the marine systems for one step.
+  public: void Step()
+  {
+    if (this->marine)
+      this->marine->PreUpdate(this->info, this->ecm);
+    for (size_t v = 0; v < this->surfaces.size(); ++v)
+    {
+      this->surfaces[v]->PreUpdate(this->info, this->ecm);
+      this->hydrodynamics[v]->PreUpdate(this->info, this->ecm);
+    }
+  }
+
+  /// \brief Entity component manager.
+  public: EntityComponentManager ecm;
+
+  /// \brief Event manager.
+  public: EventManager events;
+
+  /// \brief Update info of the current step.
+  public: UpdateInfo info;
+
+  /// \brief The world entity.
+  public: Entity world{kNullEntity};
+
+  /// \brief Vessel links.
+  public: std::vector<Entity> links;
+
+  /// \brief Initial world pose of each vessel.
+  public: std::vector<math::Pose3d> poses;
+
+  /// \brief Surface system of each vessel.
+  public: std::vector<std::unique_ptr<systems::Surface>> surfaces;
+
+  /// \brief SimpleHydrodynamics system of each vessel.
+  public: std::vector<std::unique_ptr<systems::SimpleHydrodynamics>>
+              hydrodynamics;
+
+  /// \brief World system, if the vessels are fused.
+  public: std::unique_ptr<systems::MarineDynamics> marine;
+};
+
+/// \brief Step the scene and report the time per vessel and the
+/// allocations per step.
+/// \param[in] _state Benchmark state.
+/// \param[in] _scene The scene.
+void Run(benchmark::State &_state, MarineScene &_scene)
+{
+  // Warm up, so the systems pick up the vessels and size their buffers.
+  for (int i = 0; i < 10; ++i)
+  {
+    _scene.Physics();
+    _scene.Step();
+  }
+
+  size_t allocations = 0;
+  for (auto _ : _state)
+  {
+    _state.PauseTiming();
+    _scene.Physics();
+    _state.ResumeTiming();
+
+    const size_t before = gAllocations;
+    _scene.Step();
+    allocations += gAllocations - before;
+  }
+
+  const double vessels = static_cast<double>(_scene.links.size());
+  _state.SetItemsProcessed(_state.iterations() * _scene.links.size());
+  _state.counters["time/vessel"] = benchmark::Counter(
+      static_cast<double>(_state.iterations()) * vessels,
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  _state.counters["allocs/step"] = benchmark::Counter(
+      static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+/////////////////////////////////////////////////
+static void BM_PerVessel(benchmark::State &_state)
+{
+  MarineScene scene(_state.range(0), -1);
+  Run(_state, scene);
+}
+
+/////////////////////////////////////////////////
+static void BM_MarineDynamics(benchmark::State &_state)
+{
+  MarineScene scene(_state.range(0), _state.range(1));
+  Run(_state, scene);
+}
+
+/// \brief Vessel counts x MarineDynamics threads.
+/// \param[in] _b The benchmark.
+static void MarineArgs(benchmark::internal::Benchmark *_b)
+{
+  _b->ArgNames({"vessels", "threads"});
+  for (int64_t vessels : {1, 8, 64})
+  {
+    for (int64_t threads : {0, 2, 4})
+      _b->Args({vessels, threads});
+  }
+}
+
+BENCHMARK(BM_PerVessel)->ArgName("vessels")->Arg(1)->Arg(8)->Arg(64)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MarineDynamics)->Apply(MarineArgs)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,422 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Benchmarks for the RFRange system. Runs without a Gazebo server, on an
+// EntityComponentManager holding a world, a synthetic coast and N nodes
+// carrying an RF range sensor:
+//
+//   ./rf_benchmark --benchmark_counters_tabular=true
+//
+// BM_RFRangeStep takes (nodes, occlusion, threads). The RFRange system is
+// configured with the plugin element of worlds/coast.sdf, without its
+// <occlusion> block when occlusion is 0, and stepped through PreUpdate at
+// its update rate, so every step evaluates and publishes all the links.
+// Each sensor has a subscriber. It reports "time/link", the wall time of
+// one step per link, and "received", the share of the links that gave a
+// reading. The node motion between steps is not timed.
+// BM_LineOfSight reports the time of one line of sight test against the
+// occlusion grid of the coast.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ignition/gazebo/EntityComponentManager.hh>
+#include <ignition/gazebo/EventManager.hh>
+#include <ignition/gazebo/components/Collision.hh>
+#include <ignition/gazebo/components/Geometry.hh>
+#include <ignition/gazebo/components/Link.hh>
+#include <ignition/gazebo/components/Model.hh>
+#include <ignition/gazebo/components/Name.hh>
+#include <ignition/gazebo/components/ParentEntity.hh>
+#include <ignition/gazebo/components/Pose.hh>
+#include <ignition/gazebo/components/Static.hh>
+#include <ignition/gazebo/components/World.hh>
+#include <ignition/gazebo/Util.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+#include <ignition/msgs/param_v.pb.h>
+#include <ignition/transport/Node.hh>
+#include <sdf/Box.hh>
+#include <sdf/Geometry.hh>
+#include <sdf/Model.hh>
+#include <sdf/Root.hh>
+#include <sdf/World.hh>
+
+#include "CounterRng.hh"
+#include "GeometryMesh.hh"
+#include "OcclusionGrid.hh"
+#include "RFRange.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/// \brief Plugin element of the RFRange system, see worlds/coast.sdf. The
+/// seed is fixed, the diagnostics are off and the threads are set by the
+/// benchmark.
+static const char kWorldSdf[] = R"(
+<sdf version="1.8">
+  <world name="coast">
+    <plugin
+      filename="libRFRange.so"
+      name="ignition::gazebo::systems::RFRange">
+      <update_rate>1</update_rate>
+      <range_config>
+        <max_range>500000.0</max_range>
+        <fading_exponent>2.6</fading_exponent>
+        <l0>40</l0>
+        <sigma>0.005</sigma>
+        <rssi_1>-15</rssi_1>
+      </range_config>
+      <radio_config>
+        <tx_power>25</tx_power>
+        <noise_floor>-90</noise_floor>
+      </radio_config>
+      <occlusion>
+        <cell_size>2</cell_size>
+        <attenuation>20</attenuation>
+      </occlusion>
+      <seed>7</seed>
+      <diagnostics_rate>0</diagnostics_rate>
+      <threads>0</threads>
+    </plugin>
+  </world>
+</sdf>)";
+
+/// \brief The mbzirc_rf_range sensor, see
+/// models/sensors/mbzirc_rf_range/model.sdf.
+static const char kSensorSdf[] = R"(
+<sdf version="1.8">
+  <model name="mbzirc_rf_range">
+    <link name="sensor_link"/>
+    <plugin
+      filename="libRFRange.so"
+      name="ignition::gazebo::systems::RFRangeSensor">
+    </plugin>
+  </model>
+</sdf>)";
+
+/// \brief A box of the coast.
+struct CoastBox
+{
+  /// \brief Name of the model holding the box.
+  std::string model;
+
+  /// \brief Whether the model is static.
+  bool isStatic;
+
+  /// \brief Pose of the box center in the world frame.
+  math::Pose3d pose;
+
+  /// \brief Size of the box [m].
+  math::Vector3d size;
+};
+
+/// \brief A 2 km x 1 km coast: a strip of 50 m wide ridges alternating
+/// between 5 m and 30 m high along x < 0, a 40 m x 10 m dock, 3 m high, and
+/// seven 60 m x 15 m vessels, 12 m high, offshore. The vessels are not
+/// static, so they don't occlude.
+/// \return The boxes, grouped by model.
+std::vector<CoastBox> Coast()
+{
+  std::vector<CoastBox> boxes;
+  for (int i = 0; i < 20; ++i)
+  {
+    const double height = i % 2 ? 30.0 : 5.0;
+    boxes.push_back({"terrain", true,
+        math::Pose3d(-975.0 + i * 50.0, 0, height / 2, 0, 0, 0),
+        math::Vector3d(50, 1000, height)});
+  }
+  boxes.push_back({"Start Gate", true, math::Pose3d(40, 0, 1.5, 0, 0, 0),
+      math::Vector3d(40, 10, 3)});
+  for (int i = 0; i < 7; ++i)
+  {
+    boxes.push_back({std::string("Vessel ") + static_cast<char>('A' + i),
+        false, math::Pose3d(130.0 + i * 120.0, -292.5 + i * 100.0, 6,
+        0, 0, 0), math::Vector3d(60, 15, 12)});
+  }
+  return boxes;
+}
+
+/// \brief Box geometry.
+/// \param[in] _size Size of the box [m].
+/// \return The geometry.
+sdf::Geometry BoxGeometry(const math::Vector3d &_size)
+{
+  sdf::Box box;
+  box.SetSize(_size);
+  sdf::Geometry geometry;
+  geometry.SetType(sdf::GeometryType::BOX);
+  geometry.SetBoxShape(box);
+  return geometry;
+}
+
+/// \brief Nodes spread over the coast, a third of them flying.
+/// \param[in] _count Number of nodes.
+/// \return The positions.
+std::vector<math::Vector3d> MakeNodes(int64_t _count)
+{
+  mbzirc::CounterRng rng(1);
+  std::vector<math::Vector3d> nodes;
+  for (int64_t i = 0; i < _count; ++i)
+  {
+    nodes.push_back(math::Vector3d(-1000.0 + 2000.0 * rng.Uniform(),
+        -500.0 + 1000.0 * rng.Uniform(), i % 3 ? 2.0 : 40.0));
+  }
+  return nodes;
+}
+
+/// \brief Entity component manager whose steps can be ended as the server
+/// does, so the systems only see new entities once.
+class SceneEcm : public EntityComponentManager
+{
+  /// \brief End the step.
+  public: void EndStep()
+  {
+    this->ClearNewlyCreatedEntities();
+  }
+};
+
+/// \brief A world with the coast, N nodes with an RF range sensor and the
+/// RFRange system.
+class RFScene
+{
+  /// \brief Constructor.
+  /// \param[in] _nodes Number of nodes.
+  /// \param[in] _occlusion Whether the links are tested for line of sight.
+  /// \param[in] _threads RFRange worker threads.
+  public: RFScene(int64_t _nodes, bool _occlusion, int64_t _threads)
+  {
+    this->world = this->ecm.CreateEntity();
+    this->ecm.CreateComponent(this->world, components::World());
+    this->ecm.CreateComponent(this->world, components::Name("coast"));
+
+    // A model per occluder, with a link and a collision per box.
+    Entity model = kNullEntity;
+    std::string modelName;
+    for (const auto &box : Coast())
+    {
+      if (box.model != modelName)
+      {
+        modelName = box.model;
+        model = this->ecm.CreateEntity();
+        this->ecm.CreateComponent(model, components::Model());
+        this->ecm.CreateComponent(model, components::Name(modelName));
+        this->ecm.CreateComponent(model,
+            components::ParentEntity(this->world));
+        this->ecm.CreateComponent(model, components::Pose());
+        this->ecm.CreateComponent(model, components::Static(box.isStatic));
+      }
+
+      const Entity link = this->ecm.CreateEntity();
+      this->ecm.CreateComponent(link, components::Link());
+      this->ecm.CreateComponent(link, components::ParentEntity(model));
+      this->ecm.CreateComponent(link, components::Pose());
+
+      const Entity collision = this->ecm.CreateEntity();
+      this->ecm.CreateComponent(collision, components::Collision());
+      this->ecm.CreateComponent(collision, components::ParentEntity(link));
+      this->ecm.CreateComponent(collision, components::Pose(box.pose));
+      this->ecm.CreateComponent(collision,
+          components::Geometry(BoxGeometry(box.size)));
+    }
+
+    // Nodes carrying the sensor in slot 0.
+    sdf::Root sensorRoot;
+    sensorRoot.LoadSdfString(kSensorSdf);
+    const sdf::ElementPtr sensorSdf =
+        sensorRoot.Model()->Element()->GetElement("plugin");
+    const auto positions = MakeNodes(_nodes);
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+      const Entity node = this->ecm.CreateEntity();
+      this->ecm.CreateComponent(node, components::Model());
+      this->ecm.CreateComponent(node,
+          components::Name("node_" + std::to_string(i)));
+      this->ecm.CreateComponent(node, components::ParentEntity(this->world));
+      this->ecm.CreateComponent(node,
+          components::Pose(math::Pose3d(positions[i], math::Quaterniond())));
+      this->nodes.push_back(node);
+
+      const Entity sensor = this->ecm.CreateEntity();
+      this->ecm.CreateComponent(sensor, components::Model());
+      this->ecm.CreateComponent(sensor, components::Name("sensor_0"));
+      this->ecm.CreateComponent(sensor, components::ParentEntity(node));
+      this->ecm.CreateComponent(sensor, components::Pose());
+      this->sensors.push_back(sensor);
+
+      systems::RFRangeSensor rfSensor;
+      rfSensor.Configure(sensor, sensorSdf, this->ecm, this->events);
+    }
+
+    sdf::Root worldRoot;
+    worldRoot.LoadSdfString(kWorldSdf);
+    auto rangeSdf = worldRoot.WorldByIndex(0)->Element()->GetElement("plugin");
+    if (!_occlusion)
+      rangeSdf->RemoveChild(rangeSdf->GetElement("occlusion"));
+    rangeSdf->GetElement("threads")->Set(static_cast<int>(_threads));
+    this->rfRange.Configure(this->world, rangeSdf, this->ecm, this->events);
+
+    this->info.dt = std::chrono::seconds(1);
+    this->info.simTime = std::chrono::seconds(10);
+  }
+
+  /// \brief Subscribe to the readings of every sensor. Call after the
+  /// system advertised them.
+  public: void Subscribe()
+  {
+    for (const Entity sensor : this->sensors)
+    {
+      this->node.Subscribe(scopedName(sensor, this->ecm) + "/rfsensor",
+          &RFScene::OnReadings, this);
+    }
+  }
+
+  /// \brief Stand-in for the physics: move the nodes and advance the sim
+  /// time by an update period.
+  public: void Physics()
+  {
+    ++this->info.iterations;
+    this->info.simTime += this->info.dt;
+    for (const Entity node : this->nodes)
+    {
+      auto pose = this->ecm.Component<components::Pose>(node);
+      pose->Data().Pos().X() += 0.5;
+    }
+  }
+
+  /// \brief Run the RFRange system for one step.
+  public: void Step()
+  {
+    this->rfRange.PreUpdate(this->info, this->ecm);
+    this->ecm.EndStep();
+  }
+
+  /// \brief Callback of the readings of a sensor.
+  /// \param[in] _msg The readings.
+  private: void OnReadings(const msgs::Param_V &_msg)
+  {
+    this->readings += _msg.param_size();
+  }
+
+  /// \brief Entity component manager.
+  public: SceneEcm ecm;
+
+  /// \brief Event manager.
+  public: EventManager events;
+
+  /// \brief Update info of the current step.
+  public: UpdateInfo info;
+
+  /// \brief The world entity.
+  public: Entity world{kNullEntity};
+
+  /// \brief Node models.
+  public: std::vector<Entity> nodes;
+
+  /// \brief Sensor model of each node.
+  public: std::vector<Entity> sensors;
+
+  /// \brief The system.
+  public: systems::RFRange rfRange;
+
+  /// \brief Transport node of the subscribers.
+  public: transport::Node node;
+
+  /// \brief Number of readings received.
+  public: std::atomic<size_t> readings{0};
+};
+
+/////////////////////////////////////////////////
+static void BM_RFRangeStep(benchmark::State &_state)
+{
+  RFScene scene(_state.range(0), _state.range(1) != 0, _state.range(2));
+
+  // The first step picks up the sensors and builds the occlusion grid.
+  scene.Step();
+  scene.Subscribe();
+  for (int i = 0; i < 3; ++i)
+  {
+    scene.Physics();
+    scene.Step();
+  }
+
+  scene.readings = 0;
+  for (auto _ : _state)
+  {
+    _state.PauseTiming();
+    scene.Physics();
+    _state.ResumeTiming();
+
+    scene.Step();
+  }
+
+  // Every pair is within max range.
+  const double nodes = static_cast<double>(_state.range(0));
+  const double links = static_cast<double>(_state.iterations()) * nodes *
+      (nodes - 1);
+  _state.counters["time/link"] = benchmark::Counter(links,
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  _state.counters["received"] = links > 0 ? scene.readings / links : 0.0;
+}
+
+/// \brief Node counts x occlusion, and threads on the largest scene.
+/// \param[in] _b The benchmark.
+static void RFArgs(benchmark::internal::Benchmark *_b)
+{
+  _b->ArgNames({"nodes", "occlusion", "threads"});
+  for (int64_t nodes : {16, 64, 128})
+  {
+    for (int64_t occlusion : {0, 1})
+      _b->Args({nodes, occlusion, 0});
+  }
+  _b->Args({128, 1, 4});
+}
+
+BENCHMARK(BM_RFRangeStep)->Apply(RFArgs)->Unit(benchmark::kMicrosecond);
+
+/////////////////////////////////////////////////
+static void BM_LineOfSight(benchmark::State &_state)
+{
+  std::vector<math::Vector3d> vertices;
+  std::vector<uint32_t> indices;
+  for (const auto &box : Coast())
+  {
+    if (!box.isStatic)
+      continue;
+    mbzirc::AppendGeometryTriangles(BoxGeometry(box.size), box.pose,
+        vertices, indices);
+  }
+  mbzirc::OcclusionGrid coast;
+  coast.Build(vertices, indices, 2.0);
+
+  const auto nodes = MakeNodes(256);
+  size_t i = 0;
+  for (auto _ : _state)
+  {
+    benchmark::DoNotOptimize(coast.LineOfSight(nodes[i % nodes.size()],
+        nodes[(i * 7 + 1) % nodes.size()]));
+    ++i;
+  }
+}
+BENCHMARK(BM_LineOfSight);
+
+BENCHMARK_MAIN();
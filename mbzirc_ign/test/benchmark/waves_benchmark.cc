@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Benchmarks for the Waves library. Runs without a Gazebo server:
+//
+//   ./waves_benchmark --benchmark_counters_tabular=true
+//
+// Each benchmark takes (model, components, points) with model 0 for PMS and
+// 1 for CWR, and reports the time per point. The approximate variants also
+// report "max_err", the largest difference to ComputeDepthSimply [m] over
+// the query points, and the Newton solvers the iterations per point.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+#include "Wavefield.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/// \brief Set up a wavefield with the coast.sdf sea state.
+/// \param[in] _model 0 for PMS, 1 for CWR.
+/// \param[in] _number Number of components.
+/// \return The wavefield.
+std::unique_ptr<Wavefield> MakeWavefield(int64_t _model, int64_t _number)
+{
+  auto wavefield = std::make_unique<Wavefield>();
+  wavefield->SetGain(0.3);
+  wavefield->SetPeriod(5);
+  wavefield->SetAngle(0.4);
+  wavefield->SetTau(2.0);
+  wavefield->SetSteepness(0.5);
+  if (_model == 0)
+  {
+    wavefield->SetAmplitude(0.2);
+    wavefield->SetScale(1.5);
+  }
+  else
+  {
+    // CWR scales each component by scale^n, keep the spread at 4x and the
+    // summed amplitude at that of three components.
+    wavefield->SetAmplitude(0.6 / static_cast<double>(_number));
+    wavefield->SetScale(std::pow(2.0, 2.0 / static_cast<double>(_number)));
+  }
+  wavefield->SetModel(_model == 0 ? "PMS" : "CWR");
+  wavefield->SetNumber(_number);
+  return wavefield;
+}
+
+/// \brief Query points spread over a 50 m square.
+/// \param[in] _count Number of points.
+/// \return The points.
+std::vector<math::Vector3d> MakePoints(int64_t _count)
+{
+  std::vector<math::Vector3d> points;
+  const int64_t side = std::max<int64_t>(1, std::lround(std::sqrt(_count)));
+  for (int64_t i = 0; i < _count; ++i)
+  {
+    points.push_back(math::Vector3d(
+        -25.0 + 50.0 * (i % side) / side + 0.013 * i,
+        -25.0 + 50.0 * (i / side) / side, 0.0));
+  }
+  return points;
+}
+
+/// \brief Largest difference of a depth query to ComputeDepthSimply.
+/// \param[in] _wavefield The wavefield.
+/// \param[in] _points The query points.
+/// \param[in] _time The query time.
+/// \param[in] _query The depth query to check.
+/// \return The largest absolute difference [m].
+template <typename Query>
+double MaxError(Wavefield &_wavefield,
+    const std::vector<math::Vector3d> &_points, double _time, Query _query)
+{
+  double maxError = 0.0;
+  for (size_t p = 0; p < _points.size(); ++p)
+  {
+    maxError = std::max(maxError, std::fabs(_query(p) -
+        _wavefield.ComputeDepthSimply(_points[p], _time)));
+  }
+  return maxError;
+}
+
+/// \brief Report the time per point.
+/// \param[in] _state Benchmark state.
+/// \param[in] _points Number of points per iteration.
+void ReportPerPoint(benchmark::State &_state, size_t _points)
+{
+  _state.SetItemsProcessed(_state.iterations() * _points);
+  _state.counters["time/point"] = benchmark::Counter(
+      static_cast<double>(_state.iterations() * _points),
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+/////////////////////////////////////////////////
+static void BM_ComputeDepthSimply(benchmark::State &_state)
+{
+  auto wavefield = MakeWavefield(_state.range(0), _state.range(1));
+  auto points = MakePoints(_state.range(2));
+  double t = 10.0;
+  for (auto _ : _state)
+  {
+    // Advance the time so per-step caches are rebuilt as in a simulation.
+    t += 0.001;
+    for (const auto &point : points)
+      benchmark::DoNotOptimize(wavefield->ComputeDepthSimply(point, t));
+  }
+  ReportPerPoint(_state, points.size());
+}
+
+/////////////////////////////////////////////////
+static void BM_ComputeDepthBatch(benchmark::State &_state)
+{
+  auto wavefield = MakeWavefield(_state.range(0), _state.range(1));
+  auto points = MakePoints(_state.range(2));
+  std::vector<double> depths;
+
+  wavefield->ComputeDepthBatch(points, 10.0, depths);
+  _state.counters["max_err"] = MaxError(*wavefield, points, 10.0,
+      [&](size_t _p) { return depths[_p]; });
+
+  double t = 10.0;
+  for (auto _ : _state)
+  {
+    t += 0.001;
+    wavefield->ComputeDepthBatch(points, t, depths);
+    benchmark::DoNotOptimize(depths.data());
+  }
+  ReportPerPoint(_state, points.size());
+}
+
+/////////////////////////////////////////////////
+static void BM_ComputeDepthGridCache(benchmark::State &_state)
+{
+  auto wavefield = MakeWavefield(_state.range(0), _state.range(1));
+  wavefield->SetSize(math::Vector2d(100, 100));
+  wavefield->SetCellCount(math::Vector2d(200, 200));
+  wavefield->SetGridCache(true, 10.0);
+  auto points = MakePoints(_state.range(2));
+
+  _state.counters["max_err"] = MaxError(*wavefield, points, 10.0,
+      [&](size_t _p) { return wavefield->ComputeDepth(points[_p], 10.0); });
+
+  double t = 10.0;
+  for (auto _ : _state)
+  {
+    t += 0.001;
+    for (const auto &point : points)
+      benchmark::DoNotOptimize(wavefield->ComputeDepth(point, t));
+  }
+  ReportPerPoint(_state, points.size());
+}
+
+/////////////////////////////////////////////////
+static void BM_ComputeDepthLod(benchmark::State &_state)
+{
+  auto wavefield = MakeWavefield(_state.range(0), _state.range(1));
+  wavefield->SetLodErrorSamplePeriod(0);
+  auto points = MakePoints(_state.range(2));
+  const double budget = 0.01;
+
+  _state.counters["components"] =
+      wavefield->Components()->Truncation(budget);
+  _state.counters["max_err"] = MaxError(*wavefield, points, 10.0,
+      [&](size_t _p)
+      {
+        return wavefield->ComputeDepthLod(points[_p], budget, 10.0);
+      });
+
+  double t = 10.0;
+  for (auto _ : _state)
+  {
+    t += 0.001;
+    for (const auto &point : points)
+    {
+      benchmark::DoNotOptimize(
+          wavefield->ComputeDepthLod(point, budget, t));
+    }
+  }
+  ReportPerPoint(_state, points.size());
+}
+
+/////////////////////////////////////////////////
+static void BM_ComputeDepthDirectly(benchmark::State &_state)
+{
+  auto wavefield = MakeWavefield(_state.range(0), _state.range(1));
+  auto points = MakePoints(_state.range(2));
+
+  // ComputeDepthDirectly does not report its iterations, a solver that
+  // is reset before every query does the same work.
+  WavefieldSolver solver(*wavefield, points.size());
+  for (size_t p = 0; p < points.size(); ++p)
+  {
+    solver.Reset();
+    solver.ComputeDepth(p, points[p], 10.0);
+  }
+  _state.counters["iterations/point"] = solver.Stats().MeanIterations();
+
+  double t = 10.0;
+  for (auto _ : _state)
+  {
+    t += 0.001;
+    for (const auto &point : points)
+      benchmark::DoNotOptimize(wavefield->ComputeDepthDirectly(point, t));
+  }
+  ReportPerPoint(_state, points.size());
+}
+
+/////////////////////////////////////////////////
+static void BM_WavefieldSolverWarm(benchmark::State &_state)
+{
+  auto wavefield = MakeWavefield(_state.range(0), _state.range(1));
+  auto points = MakePoints(_state.range(2));
+  WavefieldSolver solver(*wavefield, points.size());
+
+  // Agreement with the cold solver.
+  double maxError = 0.0;
+  for (size_t p = 0; p < points.size(); ++p)
+  {
+    maxError = std::max(maxError, std::fabs(
+        solver.ComputeDepth(p, points[p], 10.0) -
+        wavefield->ComputeDepthDirectly(points[p], 10.0)));
+  }
+  _state.counters["max_err_direct"] = maxError;
+
+  // Points drift 5 mm per step, as a slow vessel does.
+  solver.ResetStats();
+  double t = 10.0;
+  int64_t step = 0;
+  for (auto _ : _state)
+  {
+    t += 0.001;
+    ++step;
+    const math::Vector3d drift(0.005 * step, 0, 0);
+    for (size_t p = 0; p < points.size(); ++p)
+    {
+      benchmark::DoNotOptimize(
+          solver.ComputeDepth(p, points[p] + drift, t));
+    }
+  }
+  _state.counters["iterations/point"] = solver.Stats().MeanIterations();
+  ReportPerPoint(_state, points.size());
+}
+
+/////////////////////////////////////////////////
+static void BM_FFTModel(benchmark::State &_state)
+{
+  auto wavefield = MakeWavefield(0, 3);
+  wavefield->SetModel("FFT");
+  auto points = MakePoints(_state.range(0));
+
+  double t = 10.0;
+  for (auto _ : _state)
+  {
+    t += 0.001;
+    for (const auto &point : points)
+      benchmark::DoNotOptimize(wavefield->ComputeDepth(point, t));
+  }
+  ReportPerPoint(_state, points.size());
+}
+
+/// \brief Models x component counts x point counts.
+/// \param[in] _b The benchmark.
+static void WaveArgs(benchmark::internal::Benchmark *_b)
+{
+  _b->ArgNames({"model", "components", "points"});
+  for (int64_t model : {0, 1})
+  {
+    for (int64_t number : {3, 8, 32, 128, 512})
+    {
+      for (int64_t points : {16, 256, 4096})
+        _b->Args({model, number, points});
+    }
+  }
+}
+
+BENCHMARK(BM_ComputeDepthSimply)->Apply(WaveArgs);
+BENCHMARK(BM_ComputeDepthBatch)->Apply(WaveArgs);
+BENCHMARK(BM_ComputeDepthGridCache)->Apply(WaveArgs);
+BENCHMARK(BM_ComputeDepthLod)->Apply(WaveArgs);
+BENCHMARK(BM_ComputeDepthDirectly)->Apply(WaveArgs);
+BENCHMARK(BM_WavefieldSolverWarm)->Apply(WaveArgs);
+BENCHMARK(BM_FFTModel)->ArgName("points")->Arg(16)->Arg(256)->Arg(4096);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+
+#include "HullMesh.hh"
+
+using namespace ignition;
+
+/// \brief Fluid density [kg/m^3].
+static constexpr double kDensity = 1000.0;
+
+/// \brief Gravity [m/s^2].
+static constexpr double kGravity = 9.8;
+
+/// \brief Box mesh centered on the origin with each face split into
+/// _n x _n quads.
+/// \param[in] _size Box size [m].
+/// \param[in] _n Subdivisions per face side.
+/// \param[out] _mesh The mesh.
+/// \param[in] _inward Wind the triangles clockwise seen from outside.
+static void MakeBox(const math::Vector3d &_size, int _n,
+    mbzirc::HullMesh &_mesh, bool _inward = false)
+{
+  const math::Vector3d h = _size * 0.5;
+  const math::Vector3d x(_size.X(), 0, 0);
+  const math::Vector3d y(0, _size.Y(), 0);
+  const math::Vector3d z(0, 0, _size.Z());
+
+  // Corner and two sides of each face, u x v pointing out.
+  const math::Vector3d faces[6][3] = {
+    {math::Vector3d(h.X(), -h.Y(), -h.Z()), y, z},
+    {math::Vector3d(-h.X(), -h.Y(), -h.Z()), z, y},
+    {math::Vector3d(-h.X(), h.Y(), -h.Z()), z, x},
+    {math::Vector3d(-h.X(), -h.Y(), -h.Z()), x, z},
+    {math::Vector3d(-h.X(), -h.Y(), h.Z()), x, y},
+    {math::Vector3d(-h.X(), -h.Y(), -h.Z()), y, x}};
+
+  std::vector<math::Vector3d> vertices;
+  std::vector<uint32_t> indices;
+  for (const auto &face : faces)
+  {
+    const uint32_t first = static_cast<uint32_t>(vertices.size());
+    for (int j = 0; j <= _n; ++j)
+    {
+      for (int i = 0; i <= _n; ++i)
+      {
+        vertices.push_back(face[0] + face[1] * (static_cast<double>(i) / _n) +
+            face[2] * (static_cast<double>(j) / _n));
+      }
+    }
+    for (int j = 0; j < _n; ++j)
+    {
+      for (int i = 0; i < _n; ++i)
+      {
+        const uint32_t a = first + j * (_n + 1) + i;
+        const uint32_t b = a + 1;
+        const uint32_t c = a + _n + 2;
+        const uint32_t d = a + _n + 1;
+        if (_inward)
+          indices.insert(indices.end(), {a, c, b, a, d, c});
+        else
+          indices.insert(indices.end(), {a, b, c, a, c, d});
+      }
+    }
+  }
+  _mesh.SetMesh(vertices, indices);
+}
+
+/////////////////////////////////////////////////
+TEST(HullMeshTest, Volume)
+{
+  mbzirc::HullMesh mesh;
+  MakeBox(math::Vector3d(4, 2, 1), 3, mesh);
+  EXPECT_EQ(6u * 18u, mesh.TriangleCount());
+  EXPECT_NEAR(8.0, mesh.Volume(), 1e-9);
+  EXPECT_EQ(math::Vector3d(-2, -1, -0.5), mesh.BoundingBox().Min());
+  EXPECT_EQ(math::Vector3d(2, 1, 0.5), mesh.BoundingBox().Max());
+
+  // Inward normals are turned around.
+  MakeBox(math::Vector3d(4, 2, 1), 3, mesh, true);
+  EXPECT_NEAR(8.0, mesh.Volume(), 1e-9);
+}
+
+/////////////////////////////////////////////////
+TEST(HullMeshTest, Archimedes)
+{
+  mbzirc::HullMesh mesh;
+  MakeBox(math::Vector3d(4, 2, 1), 1, mesh);
+  const auto &vertices = mesh.Transform(math::Pose3d::Zero);
+
+  math::Vector3d force;
+  math::Vector3d torque;
+
+  // Fully submerged.
+  std::vector<double> surface(vertices.size(), 3.0);
+  mesh.Integrate(surface, kDensity, kGravity, math::Vector3d::Zero, force,
+      torque);
+  EXPECT_NEAR(0.0, force.X(), 1e-6);
+  EXPECT_NEAR(0.0, force.Y(), 1e-6);
+  EXPECT_NEAR(kDensity * kGravity * 8.0, force.Z(), 1e-6);
+  EXPECT_NEAR(0.0, torque.Length(), 1e-6);
+
+  // Flat surface 0.25 m below the top, the waterline crosses the sides.
+  surface.assign(vertices.size(), 0.25);
+  mesh.Integrate(surface, kDensity, kGravity, math::Vector3d::Zero, force,
+      torque);
+  const double buoyancy = kDensity * kGravity * 4.0 * 2.0 * 0.75;
+  EXPECT_NEAR(0.0, force.X(), 1e-6);
+  EXPECT_NEAR(0.0, force.Y(), 1e-6);
+  EXPECT_NEAR(buoyancy, force.Z(), 1e-6);
+
+  // The buoyancy acts at the center of the submerged volume, x = 0.
+  mesh.Integrate(surface, kDensity, kGravity, math::Vector3d(1, 0, 0),
+      force, torque);
+  EXPECT_NEAR(0.0, torque.X(), 1e-6);
+  EXPECT_NEAR(buoyancy, torque.Y(), 1e-6);
+  EXPECT_NEAR(0.0, torque.Z(), 1e-6);
+
+  // Out of the water.
+  surface.assign(vertices.size(), -1.0);
+  mesh.Integrate(surface, kDensity, kGravity, math::Vector3d::Zero, force,
+      torque);
+  EXPECT_EQ(math::Vector3d::Zero, force);
+  EXPECT_EQ(math::Vector3d::Zero, torque);
+}
+
+/////////////////////////////////////////////////
+TEST(HullMeshTest, Heeled)
+{
+  mbzirc::HullMesh mesh;
+  MakeBox(math::Vector3d(4, 2, 1), 4, mesh);
+
+  // A heeled box in a flat sea: the waterline clips triangles in every
+  // configuration, and the force must stay vertical and match the
+  // displaced volume, which for a 0.2 rad heel about x of a box floating
+  // at its center is half the box.
+  const auto &vertices = mesh.Transform(math::Pose3d(0, 0, 0, 0.2, 0, 0));
+  std::vector<double> surface(vertices.size(), 0.0);
+  math::Vector3d force;
+  math::Vector3d torque;
+  mesh.Integrate(surface, kDensity, kGravity, math::Vector3d::Zero, force,
+      torque);
+  EXPECT_NEAR(0.0, force.X(), 1e-6);
+  EXPECT_NEAR(0.0, force.Y(), 1e-6);
+  EXPECT_NEAR(kDensity * kGravity * 4.0, force.Z(), 1e-6);
+
+  // The center of buoyancy moves to the low side, righting the box.
+  EXPECT_LT(torque.X(), 0.0);
+}
+
+/////////////////////////////////////////////////
+TEST(HullMeshTest, Decimate)
+{
+  mbzirc::HullMesh mesh;
+  MakeBox(math::Vector3d(4, 2, 1), 16, mesh);
+  EXPECT_EQ(6u * 512u, mesh.TriangleCount());
+
+  const auto &fine = mesh.Transform(math::Pose3d::Zero);
+  std::vector<double> surface(fine.size(), 0.1);
+  math::Vector3d fineForce;
+  math::Vector3d torque;
+  mesh.Integrate(surface, kDensity, kGravity, math::Vector3d::Zero,
+      fineForce, torque);
+
+  mesh.Decimate(200);
+  EXPECT_LE(mesh.TriangleCount(), 200u);
+  EXPECT_GT(mesh.TriangleCount(), 50u);
+  EXPECT_NEAR(8.0, mesh.Volume(), 0.4);
+
+  const auto &coarse = mesh.Transform(math::Pose3d::Zero);
+  surface.assign(coarse.size(), 0.1);
+  math::Vector3d coarseForce;
+  mesh.Integrate(surface, kDensity, kGravity, math::Vector3d::Zero,
+      coarseForce, torque);
+  EXPECT_NEAR(fineForce.Z(), coarseForce.Z(), 0.05 * fineForce.Z());
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+/// \brief Number of operator new calls made by the test program.
+static std::atomic<size_t> gAllocations{0};
+
+// Eigen asserts if it allocates on the heap while
+// set_is_malloc_allowed(false) is in effect. Keep its asserts in release
+// builds.
+#undef NDEBUG
+#include <cassert>
+#define EIGEN_RUNTIME_NO_MALLOC
+#include <Eigen/Dense>
+
+#include "HydrodynamicsKernel.hh"
+
+// The replacements are kept out of line, otherwise GCC sees the inlined
+// std::free applied to the result of operator new at the call sites and
+// warns about mismatched allocation functions.
+
+/////////////////////////////////////////////////
+__attribute__((noinline)) void *operator new(std::size_t _size)
+{
+  ++gAllocations;
+  if (void *ptr = std::malloc(_size ? _size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+/////////////////////////////////////////////////
+__attribute__((noinline)) void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////////////////////////////
+__attribute__((noinline)) void operator delete(void *_ptr,
+    std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+/// \brief Parameters with every term set, unlike the defaults.
+/// \return The parameters.
+mbzirc::HydrodynamicsParameters Parameters()
+{
+  mbzirc::HydrodynamicsParameters params;
+  params.xDotU = 5.5;
+  params.yDotV = 4.25;
+  params.zDotW = 0.75;
+  params.kDotP = 0.3;
+  params.mDotQ = 0.6;
+  params.nDotR = 1.2;
+  params.xU = 510.3;
+  params.xUU = 720.4;
+  params.yV = 400.0;
+  params.yVV = 30.5;
+  params.zW = 5000.0;
+  params.zWW = 10.0;
+  params.kP = 500.0;
+  params.kPP = 2.5;
+  params.mQ = 500.0;
+  params.mQQ = 3.5;
+  params.nR = 15000.0;
+  params.nRR = 7.0;
+  return params;
+}
+
+/// \brief Dense reference of the SimpleHydrodynamics loads.
+/// \param[in] _p Parameters.
+/// \param[in] _state Body frame velocity.
+/// \param[in] _stateDot Body frame acceleration.
+/// \return Body frame force and torque.
+Eigen::VectorXd Reference(const mbzirc::HydrodynamicsParameters &_p,
+    const Eigen::VectorXd &_state, const Eigen::VectorXd &_stateDot)
+{
+  Eigen::MatrixXd Ma = Eigen::MatrixXd::Zero(6, 6);
+  Ma(0, 0) = _p.xDotU;
+  Ma(1, 1) = _p.yDotV;
+  Ma(2, 2) = _p.zDotW;
+  Ma(3, 3) = _p.kDotP;
+  Ma(4, 4) = _p.mDotQ;
+  Ma(5, 5) = _p.nDotR;
+  const Eigen::VectorXd kAmassVec = -1.0 * Ma * _stateDot;
+
+  Eigen::MatrixXd Dmat = Eigen::MatrixXd::Zero(6, 6);
+  Dmat(0, 0) = _p.xU + _p.xUU * std::abs(_state(0));
+  Dmat(1, 1) = _p.yV + _p.yVV * std::abs(_state(1));
+  Dmat(2, 2) = _p.zW + _p.zWW * std::abs(_state(2));
+  Dmat(3, 3) = _p.kP + _p.kPP * std::abs(_state(3));
+  Dmat(4, 4) = _p.mQ + _p.mQQ * std::abs(_state(4));
+  Dmat(5, 5) = _p.nR + _p.nRR * std::abs(_state(5));
+  const Eigen::VectorXd kDvec = -1.0 * Dmat * _state;
+
+  return kAmassVec + kDvec;
+}
+
+/////////////////////////////////////////////////
+TEST(HydrodynamicsKernelTest, MatchesDense)
+{
+  const auto params = Parameters();
+  mbzirc::HydrodynamicsKernel<double> kernel(params);
+  using Vector6 = mbzirc::HydrodynamicsKernel<double>::Vector6;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-3.0, 3.0);
+  for (int i = 0; i < 1000; ++i)
+  {
+    Vector6 state;
+    Vector6 stateDot;
+    for (int j = 0; j < 6; ++j)
+    {
+      state(j) = dist(gen);
+      stateDot(j) = dist(gen);
+    }
+
+    const Vector6 force = kernel.Force(state, stateDot);
+    const Eigen::VectorXd expected = Reference(params, state, stateDot);
+    for (int j = 0; j < 6; ++j)
+      EXPECT_EQ(expected(j), force(j));
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(HydrodynamicsKernelTest, Coriolis)
+{
+  const auto params = Parameters();
+  mbzirc::HydrodynamicsKernel<double> kernel(params);
+  using Vector6 = mbzirc::HydrodynamicsKernel<double>::Vector6;
+
+  Vector6 state;
+  state << 1.5, -0.5, 0.2, 0.1, -0.3, 0.4;
+
+  Eigen::MatrixXd Cmat = Eigen::MatrixXd::Zero(6, 6);
+  Cmat(0, 5) = params.yDotV * state(1);
+  Cmat(1, 5) = params.xDotU * state(0);
+  Cmat(5, 0) = params.yDotV * state(1);
+  Cmat(5, 1) = params.xDotU * state(0);
+  const Eigen::VectorXd expected = -Cmat * Eigen::VectorXd(state);
+
+  const Vector6 force = kernel.CoriolisForce(state);
+  for (int j = 0; j < 6; ++j)
+    EXPECT_EQ(expected(j), force(j));
+}
+
+/////////////////////////////////////////////////
+TEST(HydrodynamicsKernelTest, NoAllocation)
+{
+  using Vector6 = mbzirc::HydrodynamicsKernel<double>::Vector6;
+  Vector6 state;
+  state << 1.5, -0.5, 0.2, 0.1, -0.3, 0.4;
+  Vector6 stateDot;
+  stateDot << -0.1, 0.2, 0.05, 0.3, -0.2, 0.1;
+
+  Eigen::internal::set_is_malloc_allowed(false);
+  const size_t before = gAllocations;
+  mbzirc::HydrodynamicsKernel<double> kernel(Parameters());
+  Vector6 sum = Vector6::Zero();
+  for (int i = 0; i < 1000; ++i)
+  {
+    sum += kernel.Force(state, stateDot);
+    sum += kernel.CoriolisForce(state);
+  }
+
+  // Single precision kernel.
+  mbzirc::HydrodynamicsKernel<float> kernelf(Parameters());
+  const mbzirc::HydrodynamicsKernel<float>::Vector6 forcef =
+      kernelf.Force(state.cast<float>(),
+      stateDot.cast<float>()) + kernelf.CoriolisForce(state.cast<float>());
+  const size_t after = gAllocations;
+  Eigen::internal::set_is_malloc_allowed(true);
+
+  EXPECT_EQ(before, after);
+  EXPECT_TRUE(sum.allFinite());
+  EXPECT_NEAR(sum(0) / 1000.0, forcef(0), 1e-2);
+}
+
+/////////////////////////////////////////////////
+TEST(HydrodynamicsKernelTest, AccelerationFilter)
+{
+  using Vector6 = mbzirc::AccelerationFilter<double>::Vector6;
+  const Vector6 step = Vector6::Constant(2.0);
+
+  // Pass through without a cutoff.
+  mbzirc::AccelerationFilter<double> filter;
+  EXPECT_EQ(step, filter.Update(step, 0.0));
+  EXPECT_EQ(Vector6::Zero(), filter.Update(Vector6::Zero(), 0.001));
+
+  // Step response of the first order lag: 1 - exp(-1) after one time
+  // constant.
+  const double cutoff = 2.0;
+  const double tau = 1.0 / (2.0 * M_PI * cutoff);
+  filter.SetCutoff(cutoff);
+  filter.Update(Vector6::Zero(), 0.0);
+  const double dt = 0.001;
+  Vector6 output;
+  int steps = static_cast<int>(std::round(tau / dt));
+  for (int i = 1; i <= steps; ++i)
+    output = filter.Update(step, i * dt);
+  EXPECT_NEAR(2.0 * (1.0 - std::exp(-steps * dt / tau)), output(0), 1e-9);
+
+  // Updates at the same sim time return the cached output.
+  EXPECT_EQ(output, filter.Update(Vector6::Zero(), steps * dt));
+
+  // A larger step size gives the same response.
+  filter.Reset();
+  filter.Update(Vector6::Zero(), 0.0);
+  Vector6 coarse;
+  for (int i = 1; i <= steps / 4; ++i)
+    coarse = filter.Update(step, i * 4 * dt);
+  EXPECT_NEAR(2.0 * (1.0 - std::exp(-(steps / 4) * 4 * dt / tau)),
+      coarse(0), 1e-9);
+
+  // Jumping back in time restarts the filter.
+  EXPECT_EQ(step, filter.Update(step, 0.0));
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "CounterRng.hh"
+#include "LinkBudget.hh"
+
+using namespace ignition;
+
+/////////////////////////////////////////////////
+TEST(LinkBudgetTest, PacketErrorRate)
+{
+  mbzirc::LinkBudget budget;
+  for (uint64_t numBytes : {1u, 100u, 1000u})
+  {
+    mbzirc::LinkBudget::Params params;
+    params.numBytes = numBytes;
+    budget.Configure(params);
+
+    double maxError = 0.0;
+    for (double snr = -19.99; snr < 30.0; snr += 0.0013)
+    {
+      maxError = std::max(maxError, std::abs(budget.PacketErrorRate(snr) -
+          mbzirc::LinkBudget::ExactPacketErrorRate(snr, numBytes)));
+    }
+    EXPECT_LT(maxError, 1e-4) << numBytes;
+  }
+
+  // The default payload is lost below the table and received above it.
+  budget.Configure(mbzirc::LinkBudget::Params());
+  EXPECT_DOUBLE_EQ(1.0, budget.PacketErrorRate(-100.0));
+  EXPECT_DOUBLE_EQ(0.0, budget.PacketErrorRate(100.0));
+  EXPECT_DOUBLE_EQ(0.0,
+      budget.PacketErrorRate(std::numeric_limits<double>::infinity()));
+}
+
+/////////////////////////////////////////////////
+TEST(LinkBudgetTest, MatchesExactModel)
+{
+  mbzirc::LinkBudget::Params params;
+  params.maxRange = 400.0;
+  params.fadingExponent = 2.6;
+  params.rssi1 = -20.0;
+  mbzirc::LinkBudget budget;
+  budget.Configure(params);
+
+  const math::Vector3d tx(10, -5, 2);
+  mbzirc::LinkBudget::Batch batch;
+  batch.Resize(2000);
+  mbzirc::CounterRng rng(7);
+  for (size_t i = 0; i < batch.rxPos.size(); ++i)
+  {
+    batch.rxPos[i] = tx + math::Vector3d(
+        rng.Uniform() - 0.5, rng.Uniform() - 0.5, 0.01).Normalize() *
+        (1.0 + 500.0 * rng.Uniform());
+    batch.fading[i] = rng.Normal(0.0, 1.0);
+    batch.loss[i] = i % 2 ? 20.0 : 0.0;
+    batch.draw[i] = rng.Uniform();
+  }
+  budget.Evaluate(tx, batch);
+
+  // Exact model of RFRange::AttemptSend and RFRange::RSSIToRange.
+  size_t received = 0;
+  for (size_t i = 0; i < batch.rxPos.size(); ++i)
+  {
+    const double distance = tx.Distance(batch.rxPos[i]);
+    const double rssi = params.txPower - (params.l0 +
+        10 * params.fadingExponent * std::log10(distance)) - batch.loss[i] +
+        std::sqrt(params.sigma) * batch.fading[i];
+    const double per = mbzirc::LinkBudget::ExactPacketErrorRate(
+        rssi - params.noiseFloor, params.numBytes);
+    EXPECT_NEAR(rssi, batch.rssi[i], 1e-12);
+
+    if (distance > params.maxRange)
+    {
+      EXPECT_FALSE(batch.received[i]);
+      continue;
+    }
+
+    // Draws within the error of the table may go either way.
+    if (std::abs(batch.draw[i] - per) > 1e-4)
+    {
+      EXPECT_EQ(batch.draw[i] > per, batch.received[i] != 0) << i;
+    }
+
+    if (!batch.received[i])
+      continue;
+    ++received;
+    const double range = std::pow(10,
+        (params.rssi1 - rssi) / (10 * params.fadingExponent));
+    EXPECT_NEAR(range, batch.range[i], range * 1e-12);
+  }
+
+  // Some links are received and some are lost.
+  EXPECT_GT(received, 100u);
+  EXPECT_LT(received, 1900u);
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "CounterRng.hh"
+#include "OcclusionGrid.hh"
+
+using namespace ignition;
+
+/// \brief Top face of a block, x in [10, 12], y in [-5, 5], 8 m high.
+/// \param[out] _vertices Vertices.
+/// \param[out] _indices Indices.
+static void Block(std::vector<math::Vector3d> &_vertices,
+    std::vector<uint32_t> &_indices)
+{
+  _vertices = {{10, -5, 8}, {12, -5, 8}, {12, 5, 8}, {10, 5, 8}};
+  _indices = {0, 1, 2, 0, 2, 3};
+}
+
+/////////////////////////////////////////////////
+TEST(OcclusionGridTest, Block)
+{
+  std::vector<math::Vector3d> vertices;
+  std::vector<uint32_t> indices;
+  Block(vertices, indices);
+
+  mbzirc::OcclusionGrid grid;
+  EXPECT_TRUE(grid.Empty());
+  EXPECT_TRUE(grid.LineOfSight({0, 0, 0}, {20, 0, 0}));
+
+  grid.Build(vertices, indices, 0.5);
+  EXPECT_FALSE(grid.Empty());
+  EXPECT_DOUBLE_EQ(8.0, grid.Height(11, 0));
+  EXPECT_TRUE(std::isinf(grid.Height(0, 0)));
+
+  // Through, over, beside and partly over the block.
+  EXPECT_FALSE(grid.LineOfSight({0, 0, 2}, {20, 0, 2}));
+  EXPECT_FALSE(grid.LineOfSight({20, 0, 2}, {0, 0, 2}));
+  EXPECT_TRUE(grid.LineOfSight({0, 0, 10}, {20, 0, 10}));
+  EXPECT_TRUE(grid.LineOfSight({0, 10, 2}, {20, 10, 2}));
+  EXPECT_TRUE(grid.LineOfSight({0, 0, 2}, {20, 0, 20}));
+  EXPECT_FALSE(grid.LineOfSight({0, 0, 2}, {20, 0, 12}));
+  EXPECT_FALSE(grid.LineOfSight({0, -20, 2}, {20, 20, 2}));
+
+  // Segments that end before the block.
+  EXPECT_TRUE(grid.LineOfSight({0, 0, 2}, {9, 0, 2}));
+  EXPECT_TRUE(grid.LineOfSight({11, 0, 9}, {11, 0, 20}));
+  EXPECT_FALSE(grid.LineOfSight({11, 0, 2}, {11, 0, 20}));
+}
+
+/////////////////////////////////////////////////
+TEST(OcclusionGridTest, MatchesSampling)
+{
+  // A pyramid 20 m high over [-50, 50]^2.
+  std::vector<math::Vector3d> vertices = {
+      {-50, -50, 0}, {50, -50, 0}, {50, 50, 0}, {-50, 50, 0}, {0, 0, 20}};
+  std::vector<uint32_t> indices = {0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4};
+  mbzirc::OcclusionGrid grid;
+  grid.Build(vertices, indices, 1.0);
+
+  // Test segments against dense samples of the grid heights.
+  mbzirc::CounterRng rng(3);
+  int blocked = 0;
+  int mismatches = 0;
+  for (int i = 0; i < 500; ++i)
+  {
+    const math::Vector3d a(rng.Uniform() * 160 - 80,
+        rng.Uniform() * 160 - 80, rng.Uniform() * 25);
+    const math::Vector3d b(rng.Uniform() * 160 - 80,
+        rng.Uniform() * 160 - 80, rng.Uniform() * 25);
+    bool sampled = true;
+    for (int s = 0; s <= 20000 && sampled; ++s)
+    {
+      const math::Vector3d p = a + (b - a) * (s / 20000.0);
+      sampled = p.Z() >= grid.Height(p.X(), p.Y());
+    }
+    const bool los = grid.LineOfSight(a, b);
+    blocked += !los;
+    mismatches += los != sampled;
+  }
+  EXPECT_GT(blocked, 50);
+  EXPECT_LE(mismatches, 2);
+}
+
+/////////////////////////////////////////////////
+TEST(OcclusionGridTest, CellBudget)
+{
+  std::vector<math::Vector3d> vertices = {
+      {0, 0, 1}, {100000, 0, 1}, {0, 100000, 1}};
+  std::vector<uint32_t> indices = {0, 1, 2};
+  mbzirc::OcclusionGrid grid;
+  grid.Build(vertices, indices, 1.0);
+  EXPECT_LE(grid.CellCount(), mbzirc::OcclusionGrid::kMaxCells);
+  EXPECT_GT(grid.CellSize(), 1.0);
+  EXPECT_DOUBLE_EQ(1.0, grid.Height(100, 100));
+  EXPECT_FALSE(grid.LineOfSight({-10, 10, 0}, {1000, 10, 0}));
+}
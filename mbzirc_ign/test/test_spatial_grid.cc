@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+#include "SpatialGrid.hh"
+
+using namespace ignition;
+
+/// \brief Pairs found by the grid.
+/// \param[in] _points The points.
+/// \param[in] _range Pair range.
+/// \return The sorted pairs.
+std::vector<std::pair<size_t, size_t>> GridPairs(
+    const std::vector<math::Vector3d> &_points, double _range)
+{
+  mbzirc::SpatialGrid grid;
+  grid.Build(_points, _range);
+  std::vector<std::pair<size_t, size_t>> pairs;
+  grid.ForEachPair([&](size_t _i, size_t _j)
+      {
+        EXPECT_LT(_i, _j);
+        pairs.push_back({_i, _j});
+      });
+  std::sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+
+/// \brief Pairs found by testing every pair.
+/// \param[in] _points The points.
+/// \param[in] _range Pair range.
+/// \return The sorted pairs.
+std::vector<std::pair<size_t, size_t>> AllPairs(
+    const std::vector<math::Vector3d> &_points, double _range)
+{
+  std::vector<std::pair<size_t, size_t>> pairs;
+  for (size_t i = 0; i < _points.size(); ++i)
+  {
+    for (size_t j = i + 1; j < _points.size(); ++j)
+    {
+      if (_range <= 0.0 || _points[i].Distance(_points[j]) <= _range)
+        pairs.push_back({i, j});
+    }
+  }
+  return pairs;
+}
+
+/////////////////////////////////////////////////
+TEST(SpatialGridTest, MatchesAllPairs)
+{
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> xy(-2000.0, 2000.0);
+  std::uniform_real_distribution<double> z(0.0, 150.0);
+  std::vector<math::Vector3d> points;
+  for (int i = 0; i < 300; ++i)
+    points.push_back(math::Vector3d(xy(gen), xy(gen), z(gen)));
+
+  for (double range : {0.0, 10.0, 150.0, 400.0, 5000.0})
+  {
+    const auto expected = AllPairs(points, range);
+    EXPECT_EQ(expected, GridPairs(points, range)) << range;
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(SpatialGridTest, NeighborsMatchPairs)
+{
+  std::mt19937 gen(11);
+  std::uniform_real_distribution<double> xy(-1000.0, 1000.0);
+  std::uniform_real_distribution<double> z(0.0, 150.0);
+  std::vector<math::Vector3d> points;
+  for (int i = 0; i < 200; ++i)
+    points.push_back(math::Vector3d(xy(gen), xy(gen), z(gen)));
+
+  for (double range : {0.0, 10.0, 150.0, 400.0})
+  {
+    mbzirc::SpatialGrid grid;
+    grid.Build(points, range);
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      grid.ForEachNeighbor(i, [&](size_t _j)
+          {
+            EXPECT_NE(i, _j);
+            if (i < _j)
+              pairs.push_back({i, _j});
+          });
+    }
+    std::sort(pairs.begin(), pairs.end());
+    EXPECT_EQ(AllPairs(points, range), pairs) << range;
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(SpatialGridTest, CellBoundaries)
+{
+  // Points on and across cell boundaries, including negative cells.
+  const std::vector<math::Vector3d> points = {
+    {0, 0, 0}, {10, 0, 0}, {-10, 0, 0}, {20.0001, 0, 0},
+    {-9.9999, -9.9999, 0}, {5, 5, 5}, {10, 10, 10}, {0, 0, 0}};
+  for (double range : {5.0, 10.0, 17.33})
+    EXPECT_EQ(AllPairs(points, range), GridPairs(points, range)) << range;
+}
+
+/////////////////////////////////////////////////
+TEST(SpatialGridTest, Empty)
+{
+  EXPECT_TRUE(GridPairs({}, 10.0).empty());
+  EXPECT_TRUE(GridPairs({math::Vector3d::Zero}, 10.0).empty());
+
+  // Not built.
+  mbzirc::SpatialGrid grid;
+  int count = 0;
+  grid.ForEachPair([&](size_t, size_t) { ++count; });
+  EXPECT_EQ(0, count);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "StaggeredSchedule.hh"
+
+/// \brief Items due at an update.
+/// \param[in] _last Time of the previous update [ns].
+/// \param[in] _now Time of this update [ns].
+/// \param[in] _period Update period [ns].
+/// \param[in] _count Number of items.
+/// \return The items due.
+std::vector<size_t> Due(int64_t _last, int64_t _now, int64_t _period,
+    size_t _count)
+{
+  std::vector<size_t> due;
+  mbzirc::StaggeredDue(_last, _now, _period, _count, due);
+  return due;
+}
+
+/////////////////////////////////////////////////
+TEST(StaggeredScheduleTest, Slots)
+{
+  // 4 items over a 1000 ns period, slots start at 0, 250, 500 and 750.
+  EXPECT_EQ(std::vector<size_t>({0}), Due(0, 0, 1000, 4));
+  EXPECT_EQ(std::vector<size_t>(), Due(0, 249, 1000, 4));
+  EXPECT_EQ(std::vector<size_t>({1}), Due(249, 250, 1000, 4));
+  EXPECT_EQ(std::vector<size_t>(), Due(250, 251, 1000, 4));
+  EXPECT_EQ(std::vector<size_t>({1, 2}), Due(0, 500, 1000, 4));
+  EXPECT_EQ(std::vector<size_t>({3}), Due(500, 999, 1000, 4));
+}
+
+/////////////////////////////////////////////////
+TEST(StaggeredScheduleTest, WrapAround)
+{
+  // Slots 3 and 4 of 4 items, i.e. items 3 and 0 of the next period.
+  EXPECT_EQ(std::vector<size_t>({0, 3}), Due(700, 1000, 1000, 4));
+  EXPECT_EQ(std::vector<size_t>({0, 1}), Due(1999, 2250, 1000, 4));
+
+  // A full period or more services every item once.
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2}), Due(100, 1100, 1000, 3));
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2}), Due(100, 5000, 1000, 3));
+}
+
+/////////////////////////////////////////////////
+TEST(StaggeredScheduleTest, EachItemOncePerPeriod)
+{
+  // Steps that don't divide the period still service each item once.
+  const int64_t period = 1000000;
+  const size_t count = 7;
+  std::vector<int> serviced(count, 0);
+  int64_t last = 0;
+  for (int64_t now = 0; now < 10 * period; now += 3001)
+  {
+    for (size_t i : Due(last, now, period, count))
+      serviced[i]++;
+    last = now;
+  }
+  for (size_t i = 0; i < count; ++i)
+    EXPECT_NEAR(10, serviced[i], 1) << i;
+}
+
+/////////////////////////////////////////////////
+TEST(StaggeredScheduleTest, TimeGoesBackwards)
+{
+  // After a reset, only the current slot is serviced, as at the start.
+  EXPECT_EQ(Due(0, 0, 1000, 4), Due(5000, 0, 1000, 4));
+  EXPECT_EQ(std::vector<size_t>({2}), Due(5000, 500, 1000, 4));
+  EXPECT_EQ(std::vector<size_t>(), Due(5000, 600, 1000, 4));
+
+  // Same time as the previous update.
+  EXPECT_EQ(std::vector<size_t>({1}), Due(250, 250, 1000, 4));
+}
+
+/////////////////////////////////////////////////
+TEST(StaggeredScheduleTest, CountChanges)
+{
+  // Going from 4 to 5 items mid period, the slots map to the new items and
+  // every index stays within range.
+  EXPECT_EQ(std::vector<size_t>({1}), Due(0, 250, 1000, 4));
+  EXPECT_EQ(std::vector<size_t>({2, 3}), Due(250, 600, 1000, 5));
+  for (size_t count = 1; count < 20; ++count)
+  {
+    for (size_t i : Due(123, 4567, 1000, count))
+      EXPECT_LT(i, count);
+  }
+
+  // No items.
+  EXPECT_TRUE(Due(0, 1000, 1000, 0).empty());
+}
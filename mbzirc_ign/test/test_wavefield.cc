@@ -0,0 +1,500 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+#include "Wavefield.hh"
+#include "WavefieldFFT.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/// \brief Wavefield matching the sea state used in coast.sdf.
+void SetCoastWaves(Wavefield &_wavefield)
+{
+  _wavefield.SetGain(0.3);
+  _wavefield.SetPeriod(5);
+  _wavefield.SetScale(1.5);
+  _wavefield.SetAngle(0.4);
+  _wavefield.SetTau(2.0);
+  _wavefield.SetSteepness(0.0);
+  _wavefield.SetNumber(3);
+}
+
+/// \brief A small lattice of query points spread over a few wavelengths.
+std::vector<math::Vector3d> QueryPoints()
+{
+  std::vector<math::Vector3d> points;
+  for (int i = -10; i <= 10; ++i)
+  {
+    for (int j = -3; j <= 3; ++j)
+      points.push_back(math::Vector3d(-1400 + i * 3.7, 20 + j * 1.3, 0.0));
+  }
+  return points;
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, BatchMatchesScalar)
+{
+  Wavefield wavefield;
+  SetCoastWaves(wavefield);
+
+  auto points = QueryPoints();
+  std::vector<double> depths;
+  for (double t : {0.0, 0.25, 1.0, 12.5, 3600.0})
+  {
+    wavefield.ComputeDepthBatch(points, t, depths);
+    ASSERT_EQ(points.size(), depths.size());
+    for (size_t p = 0; p < points.size(); ++p)
+    {
+      EXPECT_NEAR(wavefield.ComputeDepthSimply(points[p], t), depths[p],
+          1e-12);
+    }
+  }
+
+  // Empty input.
+  wavefield.ComputeDepthBatch({}, 1.0, depths);
+  EXPECT_TRUE(depths.empty());
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, Snapshot)
+{
+  Wavefield wavefield;
+  SetCoastWaves(wavefield);
+
+  auto snapshot = wavefield.Snapshot(12.5);
+  ASSERT_NE(nullptr, snapshot);
+  EXPECT_DOUBLE_EQ(12.5, snapshot->Time());
+  EXPECT_DOUBLE_EQ(1 - exp(-12.5 / 2.0), snapshot->Ramp());
+
+  // Queries made during the same time step share the snapshot.
+  EXPECT_EQ(snapshot, wavefield.Snapshot(12.5));
+  EXPECT_NE(snapshot, wavefield.Snapshot(12.75));
+
+  // The cached terms reproduce the per-point sum through the
+  // angle-addition identity.
+  const auto &c = snapshot->Components();
+  ASSERT_EQ(3u, c.Size());
+  for (const auto &point : QueryPoints())
+  {
+    double h = 0.0;
+    for (size_t i = 0; i < c.Size(); ++i)
+    {
+      double kx = c.k[i] * (point.X() * c.dx[i] + point.Y() * c.dy[i]);
+      h += c.a[i] * (cos(kx) * snapshot->CosOmegaT()[i] +
+          sin(kx) * snapshot->SinOmegaT()[i]);
+    }
+    h *= snapshot->Ramp();
+
+    EXPECT_NEAR(h, snapshot->ComputeDepth(point), 1e-9);
+    EXPECT_DOUBLE_EQ(wavefield.ComputeDepthSimply(point, 12.5),
+        snapshot->ComputeDepth(point));
+  }
+
+  // Recalculating the components invalidates the cached snapshot.
+  wavefield.SetPeriod(6);
+  EXPECT_NE(snapshot, wavefield.Snapshot(12.5));
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, GridCache)
+{
+  Wavefield wavefield;
+  SetCoastWaves(wavefield);
+  wavefield.SetSize(math::Vector2d(200, 200));
+  wavefield.SetCellCount(math::Vector2d(400, 400));
+
+  // Disabled by default: ComputeDepth is ComputeDepthSimply.
+  EXPECT_FALSE(wavefield.GridCacheEnabled());
+  math::Vector3d point(12.3, -45.6, 0.0);
+  EXPECT_DOUBLE_EQ(wavefield.ComputeDepthSimply(point, 10.0),
+      wavefield.ComputeDepth(point, 10.0));
+
+  for (const std::string interpolation : {"bilinear", "bicubic"})
+  {
+    wavefield.SetGridCache(true, 0.0, interpolation, true);
+    EXPECT_TRUE(wavefield.GridCacheEnabled());
+    const double tol = interpolation == "bilinear" ? 2e-3 : 5e-4;
+
+    for (double t : {1.0, 12.5})
+    {
+      for (int i = -20; i <= 20; ++i)
+      {
+        for (int j = -20; j <= 20; ++j)
+        {
+          math::Vector3d p(i * 4.37, j * 3.91, 0.0);
+          EXPECT_NEAR(wavefield.ComputeDepthSimply(p, t),
+              wavefield.ComputeDepth(p, t), tol);
+        }
+      }
+      math::Vector3d n = wavefield.ComputeNormal(point, t);
+      EXPECT_NEAR(1.0, n.Length(), 1e-9);
+      EXPECT_GT(n.Z(), 0.9);
+    }
+
+    // Points outside the cached region fall back to the exact sum.
+    math::Vector3d far(500.0, 0.0, 0.0);
+    EXPECT_DOUBLE_EQ(wavefield.ComputeDepthSimply(far, 12.5),
+        wavefield.ComputeDepth(far, 12.5));
+  }
+
+  EXPECT_GT(wavefield.GridCacheError().count, 0u);
+  EXPECT_LT(wavefield.GridCacheError().max, 2e-3);
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, FFT)
+{
+  WavefieldFFT fft;
+  fft.SetResolution(100);
+  EXPECT_EQ(128u, fft.Resolution());
+  fft.SetResolution(64);
+  fft.SetPatchSize(320.0);
+
+  const double period = 5.0;
+  fft.SetSpectrum(1.0, period, math::Vector2d(1, 0), 0.4);
+  fft.Update(10.0);
+
+  // The synthesized field is real, zero mean, and carries the
+  // Pierson-Moskowitz variance alpha g^2 / (5 wp^4).
+  const auto &heights = fft.Heights();
+  ASSERT_EQ(64u * 64u, heights.size());
+  double mean = 0.0;
+  double variance = 0.0;
+  for (double h : heights)
+  {
+    mean += h;
+    variance += h * h;
+  }
+  mean /= heights.size();
+  variance /= heights.size();
+  const double wp = 2.0 * M_PI / period;
+  const double m0 = 0.0081 * 9.81 * 9.81 / (5.0 * std::pow(wp, 4.0));
+  EXPECT_NEAR(0.0, mean, 1e-9);
+  EXPECT_NEAR(m0, variance, 0.3 * m0);
+
+  // Samples at the nodes are the nodes, and the patch is periodic.
+  const double cell = 320.0 / 64;
+  EXPECT_NEAR(heights[3 * 64 + 5], fft.Height(5 * cell, 3 * cell), 1e-9);
+  EXPECT_NEAR(fft.Height(12.3, 4.5), fft.Height(12.3 + 320.0, 4.5 - 320.0),
+      1e-9);
+
+  // The same seed gives the same sea, a new time gives a different one.
+  WavefieldFFT other;
+  other.SetResolution(64);
+  other.SetPatchSize(320.0);
+  other.SetSpectrum(1.0, period, math::Vector2d(1, 0), 0.4);
+  other.Update(10.0);
+  EXPECT_DOUBLE_EQ(fft.Height(12.3, 4.5), other.Height(12.3, 4.5));
+  other.Update(11.0);
+  EXPECT_NE(fft.Height(12.3, 4.5), other.Height(12.3, 4.5));
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, FFTChoppy)
+{
+  // A single steep Gerstner wave, ak = 0.3.
+  Wavefield wavefield;
+  wavefield.SetModel("CWR");
+  wavefield.SetNumber(1);
+  wavefield.SetPeriod(5.0);
+  wavefield.SetDirection(math::Vector2d(1, 0));
+  const double omega = 2.0 * M_PI / 5.0;
+  const double k = omega * omega / 9.8;
+  const double wavelength = 2.0 * M_PI / k;
+  const double amplitude = 0.3 / k;
+  wavefield.SetAmplitude(amplitude);
+
+  // The same wave on a patch four wavelengths across.
+  WavefieldFFT fft;
+  fft.SetResolution(256);
+  fft.SetPatchSize(4.0 * wavelength);
+  fft.SetChoppiness(1.0);
+  fft.SetWave(amplitude, math::Vector2d(k, 0));
+  fft.Update(0.0);
+
+  // The crest is narrower than the trough: the surface is above the mean
+  // level over 1/2 - 2a/L of a wavelength, and follows the Gerstner profile.
+  const int samples = 1000;
+  int above = 0;
+  for (int i = 0; i < samples; ++i)
+  {
+    const math::Vector3d point(i * wavelength / samples, 0.3, 0.0);
+    const double h = fft.Height(point.X(), point.Y());
+    EXPECT_NEAR(wavefield.ComputeDepthDirectly(point, 0.0, -1000.0), h,
+        0.01 * amplitude) << point.X();
+    if (h > 0.0)
+      ++above;
+  }
+  EXPECT_NEAR(0.5 - 2.0 * amplitude / wavelength,
+      static_cast<double>(above) / samples, 0.01);
+  EXPECT_LT(above, samples / 2);
+
+  // Without choppiness crest and trough are the same width.
+  fft.SetChoppiness(0.0);
+  fft.Update(0.0);
+  above = 0;
+  for (int i = 0; i < samples; ++i)
+  {
+    if (fft.Height(i * wavelength / samples, 0.3) > 0.0)
+      ++above;
+  }
+  EXPECT_NEAR(0.5, static_cast<double>(above) / samples, 0.01);
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, FFTModel)
+{
+  Wavefield wavefield;
+  SetCoastWaves(wavefield);
+  wavefield.SetModel("FFT");
+
+  math::Vector3d point(12.3, -4.5, 0.0);
+  const double h = wavefield.ComputeDepth(point, 20.0);
+  EXPECT_NE(0.0, h);
+  EXPECT_DOUBLE_EQ(h, wavefield.ComputeDepthSimply(point, 20.0));
+  EXPECT_DOUBLE_EQ(h, wavefield.ComputeDepthDirectly(point, 20.0));
+  std::vector<double> depths;
+  wavefield.ComputeDepthBatch({point}, 20.0, depths);
+  ASSERT_EQ(1u, depths.size());
+  EXPECT_DOUBLE_EQ(h, depths[0]);
+
+  // The startup ramp applies as for the other models.
+  EXPECT_DOUBLE_EQ(0.0, wavefield.ComputeDepth(point, 0.0));
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, SolverWarmStart)
+{
+  Wavefield wavefield;
+  SetCoastWaves(wavefield);
+  wavefield.SetSteepness(0.5);
+
+  auto points = QueryPoints();
+  WavefieldSolver solver(wavefield, points.size());
+  solver.SetTolerance(1e-10);
+
+  // Cold start: same answer and work as the stateless solver.
+  for (size_t p = 0; p < points.size(); ++p)
+  {
+    EXPECT_NEAR(wavefield.ComputeDepthDirectly(points[p], 10.0),
+        solver.ComputeDepth(p, points[p], 10.0), 1e-9);
+  }
+  const double coldIterations = solver.Stats().MeanIterations();
+  EXPECT_EQ(points.size(), solver.Stats().solves);
+
+  // Move the samples a little every 10 ms step.
+  solver.ResetStats();
+  for (int step = 1; step <= 50; ++step)
+  {
+    const double t = 10.0 + step * 0.01;
+    for (size_t p = 0; p < points.size(); ++p)
+    {
+      math::Vector3d point = points[p] + math::Vector3d(step * 0.005, 0, 0);
+      EXPECT_NEAR(wavefield.ComputeDepthDirectly(point, t),
+          solver.ComputeDepth(p, point, t), 1e-9);
+    }
+  }
+  EXPECT_EQ(0u, solver.Stats().unconverged);
+  EXPECT_LT(solver.Stats().MeanIterations(), coldIterations);
+
+  // Growing the sample set on the fly starts the new sample cold.
+  math::Vector3d extra(3.0, 4.0, 0.0);
+  EXPECT_NEAR(wavefield.ComputeDepthDirectly(extra, 11.0),
+      solver.ComputeDepth(points.size(), extra, 11.0), 1e-9);
+  EXPECT_EQ(points.size() + 1, solver.Size());
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, Kinematics)
+{
+  Wavefield wavefield;
+  SetCoastWaves(wavefield);
+
+  const double t = 12.5;
+  const double e = 1e-5;
+  for (const auto &surface : QueryPoints())
+  {
+    auto kin = wavefield.ComputeKinematics(surface, t);
+    EXPECT_DOUBLE_EQ(wavefield.ComputeDepthSimply(surface, t), kin.height);
+
+    // Slope and vertical velocity against central differences.
+    const math::Vector3d dx(e, 0, 0);
+    const math::Vector3d dy(0, e, 0);
+    EXPECT_NEAR((wavefield.ComputeDepthSimply(surface + dx, t) -
+        wavefield.ComputeDepthSimply(surface - dx, t)) / (2 * e),
+        kin.dhdx, 1e-6);
+    EXPECT_NEAR((wavefield.ComputeDepthSimply(surface + dy, t) -
+        wavefield.ComputeDepthSimply(surface - dy, t)) / (2 * e),
+        kin.dhdy, 1e-6);
+
+    // At the mean level the vertical particle velocity is dh/dt once the
+    // start-up ramp has settled.
+    auto settled = wavefield.ComputeKinematics(surface, 3600.0);
+    EXPECT_NEAR((wavefield.ComputeDepthSimply(surface, 3600.0 + e) -
+        wavefield.ComputeDepthSimply(surface, 3600.0 - e)) / (2 * e),
+        settled.velocity.Z(), 1e-5);
+
+    // Motion decays with depth and is unchanged above the mean level.
+    auto deep = wavefield.ComputeKinematics(surface - math::Vector3d(0, 0, 50),
+        t);
+    EXPECT_LT(deep.velocity.Length(), kin.velocity.Length() + 1e-12);
+    auto above = wavefield.ComputeKinematics(surface + math::Vector3d(0, 0, 1),
+        t);
+    EXPECT_EQ(kin.velocity, above.velocity);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, Acquire)
+{
+  auto sdf = std::make_shared<sdf::Element>();
+
+  // Plugins of the same world share one wavefield.
+  auto first = Wavefield::Acquire(1, sdf);
+  auto second = Wavefield::Acquire(1, sdf);
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(first, second);
+
+  // Other worlds get their own.
+  auto other = Wavefield::Acquire(2, sdf);
+  EXPECT_NE(first, other);
+
+  // Loaded wavefields can be looked up by their key.
+  EXPECT_EQ(first, Wavefield::Find(1, Wavefield::Key(sdf)));
+  EXPECT_EQ(nullptr, Wavefield::Find(3, Wavefield::Key(sdf)));
+
+  // A released wavefield is loaded again on next use.
+  std::weak_ptr<Wavefield> released = other;
+  other.reset();
+  EXPECT_TRUE(released.expired());
+  EXPECT_EQ(nullptr, Wavefield::Find(2, Wavefield::Key(sdf)));
+  EXPECT_NE(nullptr, Wavefield::Acquire(2, sdf));
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, SeaStateUpdate)
+{
+  Wavefield wavefield;
+  SetCoastWaves(wavefield);
+  auto components = wavefield.Components();
+  const uint64_t revision = wavefield.Revision();
+  math::Vector3d point(12.3, -4.5, 0.0);
+  const double before = wavefield.ComputeDepth(point, 20.0);
+
+  // Nothing changes until the update is applied.
+  EXPECT_FALSE(wavefield.ApplyPendingUpdate());
+  wavefield.SetSeaState(0.6, 7.0, math::Vector2d(0, 1));
+  EXPECT_EQ(components, wavefield.Components());
+  EXPECT_DOUBLE_EQ(before, wavefield.ComputeDepth(point, 20.0));
+
+  // Only the first consumer of a step recalculates.
+  EXPECT_TRUE(wavefield.ApplyPendingUpdate());
+  EXPECT_FALSE(wavefield.ApplyPendingUpdate());
+  EXPECT_EQ(revision + 1, wavefield.Revision());
+  EXPECT_FLOAT_EQ(0.6, wavefield.Gain());
+  EXPECT_DOUBLE_EQ(7.0, wavefield.Period());
+  EXPECT_EQ(math::Vector2d(0, 1), wavefield.Direction());
+
+  // Readers holding the old components keep a consistent set.
+  EXPECT_NE(components, wavefield.Components());
+  EXPECT_EQ(3u, components->Size());
+  EXPECT_NE(before, wavefield.ComputeDepth(point, 20.0));
+
+  // A zero direction keeps the current one.
+  wavefield.SetSeaState(0.3, 5.0);
+  EXPECT_TRUE(wavefield.ApplyPendingUpdate());
+  EXPECT_EQ(math::Vector2d(0, 1), wavefield.Direction());
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, ManyComponents)
+{
+  Wavefield wavefield;
+  SetCoastWaves(wavefield);
+  const auto three = wavefield.Components();
+  const double minOmega =
+      *std::min_element(three->omega.begin(), three->omega.end());
+  const double maxOmega =
+      *std::max_element(three->omega.begin(), three->omega.end());
+
+  // More than three PMS components cover the same band with the same
+  // total energy, roughly.
+  for (size_t number : {4u, 8u, 64u, 512u})
+  {
+    wavefield.SetNumber(number);
+    auto c = wavefield.Components();
+    ASSERT_EQ(number, c->Size());
+    double energy = 0.0;
+    double threeEnergy = 0.0;
+    for (size_t i = 0; i < c->Size(); ++i)
+    {
+      EXPECT_TRUE(std::isfinite(c->a[i]));
+      EXPECT_GE(c->omega[i], minOmega * (1 - 1e-9));
+      EXPECT_LE(c->omega[i], maxOmega * (1 + 1e-9));
+      energy += c->a[i] * c->a[i];
+    }
+    for (size_t i = 0; i < three->Size(); ++i)
+      threeEnergy += three->a[i] * three->a[i];
+    EXPECT_NEAR(threeEnergy, energy, 0.5 * threeEnergy);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(WavefieldTest, Lod)
+{
+  Wavefield wavefield;
+  SetCoastWaves(wavefield);
+  wavefield.SetNumber(32);
+  wavefield.SetLodErrorSamplePeriod(1);
+
+  // Components are sorted by amplitude and the tail bounds the error.
+  auto c = wavefield.Components();
+  for (size_t i = 1; i < c->Size(); ++i)
+    EXPECT_GE(std::fabs(c->a[i - 1]), std::fabs(c->a[i]));
+  EXPECT_EQ(c->Size(), c->Truncation(0.0));
+  EXPECT_EQ(0u, c->Truncation(c->tail[0]));
+
+  for (double budget : {0.0, 0.01, 0.05, 1.0})
+  {
+    const size_t count = c->Truncation(budget);
+    EXPECT_LE(c->tail[count], budget);
+    for (const auto &point : QueryPoints())
+    {
+      EXPECT_NEAR(wavefield.ComputeDepthSimply(point, 12.5),
+          wavefield.ComputeDepthLod(point, budget, 12.5), budget + 1e-12);
+    }
+  }
+
+  // Errors are reported per level of detail.
+  auto errors = wavefield.LodError();
+  ASSERT_EQ(4u, errors.size());
+  EXPECT_DOUBLE_EQ(0.0, errors[c->Size()].max);
+  for (const auto &[count, error] : errors)
+  {
+    EXPECT_EQ(QueryPoints().size(), error.count);
+    EXPECT_LE(error.max, c->tail[count] + 1e-12);
+  }
+}
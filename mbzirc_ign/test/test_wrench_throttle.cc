@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include <ignition/math/Vector3.hh>
+
+#include "WrenchThrottle.hh"
+
+using namespace ignition;
+using namespace std::chrono_literals;
+
+/// \brief Force ramp used as the full rate wrench.
+/// \param[in] _time Sim time.
+/// \return The force [N].
+math::Vector3d Ramp(const std::chrono::steady_clock::duration &_time)
+{
+  const double t = std::chrono::duration<double>(_time).count();
+  return math::Vector3d(100.0 * t, 0, 1000.0);
+}
+
+/////////////////////////////////////////////////
+TEST(WrenchThrottleTest, FullRate)
+{
+  mbzirc::WrenchThrottle throttle;
+  throttle.Configure(0, false, false);
+  EXPECT_FALSE(throttle.Enabled());
+  for (auto t = 0ms; t < 100ms; t += 4ms)
+  {
+    EXPECT_TRUE(throttle.NeedsUpdate(t));
+    math::Vector3d force = Ramp(t);
+    math::Vector3d torque(1, 2, 3);
+    throttle.Filter(t, force, torque);
+    EXPECT_EQ(Ramp(t), force);
+    EXPECT_EQ(math::Vector3d(1, 2, 3), torque);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(WrenchThrottleTest, Hold)
+{
+  mbzirc::WrenchThrottle throttle;
+  throttle.Configure(50, false, false);
+  EXPECT_TRUE(throttle.Enabled());
+
+  // 4 ms steps, updates every 20 ms.
+  int updates = 0;
+  math::Vector3d force;
+  math::Vector3d torque;
+  for (auto t = 0ms; t < 200ms; t += 4ms)
+  {
+    if (throttle.NeedsUpdate(t))
+    {
+      ++updates;
+      force = Ramp(t);
+      torque = math::Vector3d::Zero;
+      throttle.Filter(t, force, torque);
+      EXPECT_EQ(Ramp(t), force);
+    }
+    else
+    {
+      throttle.Hold(t, force, torque);
+      const auto last = t - t % 20ms;
+      EXPECT_EQ(Ramp(last), force);
+    }
+  }
+  EXPECT_EQ(10, updates);
+  EXPECT_FALSE(throttle.TakeError(1s, 0s));
+}
+
+/////////////////////////////////////////////////
+TEST(WrenchThrottleTest, Extrapolate)
+{
+  mbzirc::WrenchThrottle throttle;
+  throttle.Configure(50, true, true);
+
+  // The error is checked, so every step computes the wrench, and a linear
+  // extrapolation of a ramp is exact after the second update.
+  math::Vector3d force;
+  math::Vector3d torque;
+  for (auto t = 0ms; t < 200ms; t += 4ms)
+  {
+    EXPECT_TRUE(throttle.NeedsUpdate(t));
+    force = Ramp(t);
+    torque = math::Vector3d::Zero;
+    throttle.Filter(t, force, torque);
+    if (t > 20ms)
+    {
+      EXPECT_NEAR(Ramp(t).X(), force.X(), 1e-9);
+    }
+  }
+
+  auto error = throttle.TakeError(0ms, 0ms);
+  ASSERT_TRUE(error);
+  EXPECT_EQ(40, error->count);
+  EXPECT_GT(error->forceMax, 0.0);
+  EXPECT_NEAR(0.0, error->torqueMax, 1e-12);
+
+  // Taking the error resets it.
+  error = throttle.TakeError(1s, 0s);
+  ASSERT_TRUE(error);
+  EXPECT_EQ(0, error->count);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <ignition/msgs/double_v.pb.h>
+#include <ignition/msgs/stringmsg_v.pb.h>
+#include <ignition/transport/Node.hh>
+
+#include <ros_ign_interfaces/msg/string_vec.hpp>
+#include <std_msgs/msg/float64_multi_array.hpp>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// \brief A bridge node for the compact output of the RFRange system.
+///
+/// The readings of a sensor, an ignition::msgs::Double_V of
+/// (peer id, range, rssi) triplets, are published as a
+/// std_msgs/Float64MultiArray on "rfsensor/compact" with a 2D layout,
+/// readings x 3. Float64MultiArray has no header, so the sim time of the
+/// readings [s] is carried as a leading element, skipped by the layout's
+/// data_offset of 1. The peer table that maps the ids to model names is
+/// published as a ros_ign_interfaces/StringVec on "rfsensor/peers" when it
+/// changes, with a transient local QoS so late subscribers receive it.
+///
+/// Parameters:
+///  * ign_topic - Ignition topic of the sensor readings.
+///  * peers_topic - Ignition topic of the peer table.
+class RFRangeBridge : public rclcpp::Node
+{
+  /// \brief Constructor
+  public: RFRangeBridge() : Node("rf_range_bridge")
+  {
+    const std::string ignTopic =
+        this->declare_parameter<std::string>("ign_topic", "");
+    const std::string peersTopic =
+        this->declare_parameter<std::string>("peers_topic", "");
+
+    this->rangePub =
+        this->create_publisher<std_msgs::msg::Float64MultiArray>(
+        "rfsensor/compact", 10);
+    this->peersPub =
+        this->create_publisher<ros_ign_interfaces::msg::StringVec>(
+        "rfsensor/peers", rclcpp::QoS(1).transient_local());
+
+    if (ignTopic.empty() || peersTopic.empty())
+    {
+      RCLCPP_ERROR(this->get_logger(),
+          "Parameters [ign_topic] and [peers_topic] are required");
+      return;
+    }
+
+    this->ignNode.Subscribe(ignTopic, &RFRangeBridge::OnRange, this);
+    this->ignNode.Subscribe(peersTopic, &RFRangeBridge::OnPeers, this);
+  }
+
+  /// \brief Callback when sensor readings are received
+  /// \param[in] _msg Packed (peer id, range, rssi) triplets
+  private: void OnRange(const ignition::msgs::Double_V &_msg)
+  {
+    std_msgs::msg::Float64MultiArray rosMsg;
+    rosMsg.layout.dim.resize(2);
+    rosMsg.layout.dim[0].label = "readings";
+    rosMsg.layout.dim[0].size = _msg.data_size() / 3;
+    rosMsg.layout.dim[0].stride = _msg.data_size();
+    rosMsg.layout.dim[1].label = "peer_id_range_rssi";
+    rosMsg.layout.dim[1].size = 3;
+    rosMsg.layout.dim[1].stride = 3;
+    rosMsg.layout.data_offset = 1;
+    rosMsg.data.reserve(_msg.data_size() + 1);
+    rosMsg.data.push_back(_msg.header().stamp().sec() +
+        _msg.header().stamp().nsec() * 1e-9);
+    rosMsg.data.insert(rosMsg.data.end(), _msg.data().begin(),
+        _msg.data().end());
+    this->rangePub->publish(rosMsg);
+  }
+
+  /// \brief Callback when the peer table is received
+  /// \param[in] _msg Model names indexed by peer id
+  private: void OnPeers(const ignition::msgs::StringMsg_V &_msg)
+  {
+    std::vector<std::string> peers(_msg.data().begin(), _msg.data().end());
+
+    // The table is republished periodically, forward only the changes.
+    {
+      std::lock_guard<std::mutex> lock(this->peersMutex);
+      if (peers == this->peers)
+        return;
+      this->peers = peers;
+    }
+
+    ros_ign_interfaces::msg::StringVec rosMsg;
+    rosMsg.header.stamp.sec = _msg.header().stamp().sec();
+    rosMsg.header.stamp.nanosec = _msg.header().stamp().nsec();
+    rosMsg.data = peers;
+    this->peersPub->publish(rosMsg);
+  }
+
+  /// \brief Ignition transport node
+  private: ignition::transport::Node ignNode;
+
+  /// \brief Publisher for the readings
+  private: rclcpp::Publisher<std_msgs::msg::Float64MultiArray>::SharedPtr
+      rangePub;
+
+  /// \brief Publisher for the peer table
+  private: rclcpp::Publisher<ros_ign_interfaces::msg::StringVec>::SharedPtr
+      peersPub;
+
+  /// \brief Last forwarded peer table
+  private: std::vector<std::string> peers;
+
+  /// \brief Mutex to protect the peer table
+  private: std::mutex peersMutex;
+};
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<RFRangeBridge>());
+  rclcpp::shutdown();
+  return 0;
+}
@@ -21,8 +21,12 @@
 #include <rclcpp/node.hpp>
 
 #include <ros_ign_interfaces/msg/param_vec.hpp>
+#include <ros_ign_interfaces/msg/string_vec.hpp>
+#include <std_msgs/msg/float64_multi_array.hpp>
 
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace mbzirc_seed
 {
@@ -41,6 +45,10 @@ struct RangeInfo
 };
 
 /// \brief Node to read RF ranging measurements from the MBZIRC simulation
+///
+/// Subscribes to "range", to be remapped to the rfsensor topic of a slot,
+/// e.g. /quadrotor_1/slot0/rfsensor. The compact output of the simulator is
+/// read from the same name with /compact and /peers appended.
 class ReadRfRange : public rclcpp::Node
 {
 public:
@@ -51,11 +59,19 @@ protected:
   /// \brief Callback for when air pressure messages are received
   void onRangeMessage(const ros_ign_interfaces::msg::ParamVec & msg);
 
+  /// \brief Callback for when compact range messages are received
+  void onCompactRangeMessage(const std_msgs::msg::Float64MultiArray & msg);
+
+  /// \brief Callback for when the peer table of the compact messages is received
+  void onPeersMessage(const ros_ign_interfaces::msg::StringVec & msg);
+
   /// \brief Callback for when timer fires
   void onTimer();
 
   /// Subscriptions
   rclcpp::Subscription<ros_ign_interfaces::msg::ParamVec>::SharedPtr rf_range_sub_;
+  rclcpp::Subscription<std_msgs::msg::Float64MultiArray>::SharedPtr rf_range_compact_sub_;
+  rclcpp::Subscription<ros_ign_interfaces::msg::StringVec>::SharedPtr rf_range_peers_sub_;
 
   /// Timers
   rclcpp::TimerBase::SharedPtr timer_;
@@ -63,6 +79,9 @@ protected:
   /// RF Range information
   std::mutex ranges_mutex_;
   std::unordered_map<std::string, RangeInfo> ranges_;
+
+  /// Platform names of the compact messages, indexed by peer id
+  std::vector<std::string> peers_;
 };
 }  // namespace mbzirc_seed
 #endif  // MBZIRC_SEED__READ_RF_RANGE_HH_
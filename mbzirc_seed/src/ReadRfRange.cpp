@@ -27,6 +27,19 @@ ReadRfRange::ReadRfRange(const rclcpp::NodeOptions & options)
       "range", rclcpp::QoS(10),
       std::bind(&ReadRfRange::onRangeMessage, this, std::placeholders::_1));
 
+  // Compact output of the simulator, see rf_range_bridge. It is published
+  // under the sensor topic, e.g. <slot>/rfsensor/compact next to
+  // <slot>/rfsensor, so the names are taken from the resolved "range" topic
+  // and follow its remapping.
+  // The peer table is only sent when it changes, hence the transient local QoS.
+  const std::string range_topic = rf_range_sub_->get_topic_name();
+  rf_range_compact_sub_ = this->create_subscription<std_msgs::msg::Float64MultiArray>(
+      range_topic + "/compact", rclcpp::QoS(10),
+      std::bind(&ReadRfRange::onCompactRangeMessage, this, std::placeholders::_1));
+  rf_range_peers_sub_ = this->create_subscription<ros_ign_interfaces::msg::StringVec>(
+      range_topic + "/peers", rclcpp::QoS(1).transient_local(),
+      std::bind(&ReadRfRange::onPeersMessage, this, std::placeholders::_1));
+
   timer_ = this->create_wall_timer(
       std::chrono::milliseconds(2000),
       std::bind(&ReadRfRange::onTimer, this));
@@ -128,6 +141,38 @@ void ReadRfRange::onRangeMessage(const ros_ign_interfaces::msg::ParamVec & msg)
   }
 }
 
+void ReadRfRange::onCompactRangeMessage(const std_msgs::msg::Float64MultiArray & msg)
+{
+  // The readings are packed (peer id, range, rssi) triplets, the peer id
+  // indexes the peer table. They follow the sim time of the readings, in
+  // seconds, see layout.data_offset.
+  if (msg.layout.data_offset < 1 || msg.data.size() < msg.layout.data_offset) {
+    return;
+  }
+  rclcpp::Time t(static_cast<int64_t>(msg.data[0] * 1e9), RCL_ROS_TIME);
+  std::lock_guard<std::mutex> lock(ranges_mutex_);
+  for (size_t ii = msg.layout.data_offset; ii + 2 < msg.data.size(); ii += 3)
+  {
+    auto id = static_cast<size_t>(msg.data[ii]);
+    if (id >= peers_.size()) {
+      // Peer table not received yet.
+      continue;
+    }
+
+    auto & info = this->ranges_[peers_[id]];
+    info.platform = peers_[id];
+    info.range = msg.data[ii + 1];
+    info.rssi = msg.data[ii + 2];
+    info.last_seen = t;
+  }
+}
+
+void ReadRfRange::onPeersMessage(const ros_ign_interfaces::msg::StringVec & msg)
+{
+  std::lock_guard<std::mutex> lock(ranges_mutex_);
+  peers_ = msg.data;
+}
+
 }  // namespace mbzirc_seed
 
 #include "rclcpp_components/register_node_macro.hpp"